@@ -0,0 +1,184 @@
+#include "../Events/eventsPump.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <vector>
+
+// Events/s delivered to dozens of handlers. The baseline hands every event to every handler, which
+// works out its type with a dynamic_cast chain as VulkanBackend used to; the others go through
+// EventPump's per-type subscriber lists. Usage: eventdispatchbench [events] [handlers per type]
+using namespace Events;
+
+namespace
+{
+    const size_t FrameEvents = 64;
+
+    // The old interface, one entry point for every event.
+    class BroadcastHandler
+    {
+    public:
+        virtual ~BroadcastHandler() {}
+        virtual void HandleEvent(const Event * evt) = 0;
+    };
+
+    class CastingHandler : public BroadcastHandler
+    {
+    public:
+        double Total = 0.0;
+
+        void HandleEvent(const Event * evt) override
+        {
+            if (auto press = dynamic_cast<const KeyPressEvent *>(evt))
+            {
+                Total += (double)press->Key;
+            }
+            else if (dynamic_cast<const KeyReleaseEvent *>(evt))
+            {
+                Total -= 1.0;
+            }
+            else if (dynamic_cast<const KeyHoldEvent *>(evt))
+            {
+                Total -= 2.0;
+            }
+            else if (dynamic_cast<const MouseButtonPressEvent *>(evt))
+            {
+                Total -= 3.0;
+            }
+            else if (dynamic_cast<const MouseButtonPressHoldEvent *>(evt))
+            {
+                Total -= 4.0;
+            }
+            else if (dynamic_cast<const MouseButtonReleaseEvent *>(evt))
+            {
+                Total -= 5.0;
+            }
+            else if (auto move = dynamic_cast<const MouseMoveEvent *>(evt))
+            {
+                Total += move->DeltaX;
+            }
+        }
+    };
+
+    class MoveHandler : public IEventHandler<MouseMoveEvent>
+    {
+    public:
+        double Total = 0.0;
+
+        void HandleEvent(const MouseMoveEvent & evt) override
+        {
+            Total += evt.DeltaX;
+        }
+    };
+
+    class KeyHandler : public IEventHandler<KeyPressEvent>
+    {
+    public:
+        double Total = 0.0;
+
+        void HandleEvent(const KeyPressEvent & evt) override
+        {
+            Total += (double)evt.Key;
+        }
+    };
+
+    template <typename Body>
+    double EventsPerSecond(size_t count, Body body)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        body();
+        return count / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    const size_t count = argc > 1 ? strtoull(argv[1], nullptr, 10) : 2000000;
+    const size_t perType = argc > 2 ? strtoull(argv[2], nullptr, 10) : 24;
+
+    const MouseMoveEvent move(0.0, 0.0, 1.0, 0.0);
+    const KeyPressEvent press(Input::Key::W);
+
+    std::vector<CastingHandler> casting(perType * 2);
+    std::vector<BroadcastHandler *> broadcastHandlers;
+    std::vector<MoveHandler> moveHandlers(perType);
+    std::vector<KeyHandler> keyHandlers(perType);
+
+    for (auto & handler : casting)
+    {
+        broadcastHandlers.push_back(&handler);
+    }
+
+    for (size_t i = 0; i < perType; i++)
+    {
+        EventPump::Subscribe<MouseMoveEvent>(&moveHandlers[i]);
+        EventPump::Subscribe<KeyPressEvent>(&keyHandlers[i]);
+    }
+
+    // Alternating mouse moves and key presses.
+    const double broadcast = EventsPerSecond(count, [&]()
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            const Event * evt = i % 2 ? (const Event *)&press : (const Event *)&move;
+
+            for (auto handler : broadcastHandlers)
+            {
+                handler->HandleEvent(evt);
+            }
+        }
+    });
+
+    const double fired = EventsPerSecond(count, [&]()
+    {
+        for (size_t i = 0; i < count; i++)
+        {
+            if (i % 2)
+            {
+                EventPump::FireEvent(press);
+            }
+            else
+            {
+                EventPump::FireEvent(move);
+            }
+        }
+    });
+
+    const double posted = EventsPerSecond(count, [&]()
+    {
+        for (size_t i = 0; i < count; i += FrameEvents)
+        {
+            for (size_t j = i; j < i + FrameEvents && j < count; j++)
+            {
+                if (j % 2)
+                {
+                    EventPump::PostEvent(press);
+                }
+                else
+                {
+                    EventPump::PostEvent(move);
+                }
+            }
+
+            EventPump::DispatchEvents();
+        }
+    });
+
+    double checksum = 0.0;
+
+    for (const auto & handler : casting)
+    {
+        checksum += handler.Total;
+    }
+
+    for (size_t i = 0; i < perType; i++)
+    {
+        checksum += moveHandlers[i].Total + keyHandlers[i].Total;
+    }
+
+    printf("%zu events, %zu handlers (%zu per type for the subscriber lists)\n", count, perType * 2, perType);
+    printf("  broadcast + dynamic_cast  %8.2fM events/s\n", broadcast / 1e6);
+    printf("  FireEvent<T>              %8.2fM events/s\n", fired / 1e6);
+    printf("  PostEvent + Dispatch      %8.2fM events/s\n", posted / 1e6);
+    printf("  dropped %llu, checksum %.0f\n", (unsigned long long)EventPump::DroppedEvents(), checksum);
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include "../Events/eventsPump.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+#include <memory>
+
+// Events/s through the queue when each event is heap allocated, as input used to do, against
+// posting AnyEvents by value through EventPump. Usage: eventqueuebench [events]
+using namespace Events;
+
+namespace
+{
+    const size_t FrameEvents = 64;
+
+    // Consumes the delivered events so the work cannot be optimised away.
+    struct Sink : public IEventHandler<KeyPressEvent>, public IEventHandler<MouseMoveEvent>
+    {
+        double Total = 0.0;
+
+        void HandleEvent(const KeyPressEvent & evt) override
+        {
+            Total += (double)evt.Key;
+        }
+
+        void HandleEvent(const MouseMoveEvent & evt) override
+        {
+            Total += evt.DeltaX;
+        }
+    };
+
+    // Mouse moves with a key press every eighth event.
+    template <typename Post>
+    void Produce(size_t index, Post post)
+    {
+        if (index % 8 == 7)
+        {
+            post(KeyPressEvent(Input::Key::W));
+        }
+        else
+        {
+            post(MouseMoveEvent((double)index, 0.0, 1.0, 0.0));
+        }
+    }
+
+    double HeapEventsPerSecond(size_t count, Sink & sink)
+    {
+        std::unique_ptr<Util::Threading::MpscRing<Event *, 4096>> queue(new Util::Threading::MpscRing<Event *, 4096>());
+
+        const auto start = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < count; i += FrameEvents)
+        {
+            for (size_t j = i; j < i + FrameEvents && j < count; j++)
+            {
+                Produce(j, [&queue](auto evt)
+                {
+                    queue->TryPush((Event *)new decltype(evt)(evt));
+                });
+            }
+
+            Event * evt;
+
+            while (queue->TryPop(evt))
+            {
+                if (auto move = dynamic_cast<MouseMoveEvent *>(evt))
+                {
+                    sink.HandleEvent(*move);
+                }
+                else if (auto key = dynamic_cast<KeyPressEvent *>(evt))
+                {
+                    sink.HandleEvent(*key);
+                }
+
+                delete evt;
+            }
+        }
+
+        return count / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    double ValueEventsPerSecond(size_t count)
+    {
+        const auto start = std::chrono::steady_clock::now();
+
+        for (size_t i = 0; i < count; i += FrameEvents)
+        {
+            for (size_t j = i; j < i + FrameEvents && j < count; j++)
+            {
+                Produce(j, [](const auto & evt)
+                {
+                    EventPump::PostEvent(evt);
+                });
+            }
+
+            EventPump::DispatchEvents();
+        }
+
+        return count / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    const size_t count = argc > 1 ? strtoull(argv[1], nullptr, 10) : 4000000;
+
+    Sink sink;
+    EventPump::Subscribe<KeyPressEvent>(&sink);
+    EventPump::Subscribe<MouseMoveEvent>(&sink);
+
+    // One untimed pass each to warm the allocator and the queue.
+    HeapEventsPerSecond(count / 10, sink);
+    ValueEventsPerSecond(count / 10);
+
+    const double heap = HeapEventsPerSecond(count, sink);
+    const double value = ValueEventsPerSecond(count);
+
+    printf("%zu events, %zu per frame\n", count, FrameEvents);
+    printf("  new/delete per event  %8.2fM events/s\n", heap / 1e6);
+    printf("  AnyEvent by value     %8.2fM events/s\n", value / 1e6);
+    printf("  dropped %llu, checksum %.0f\n", (unsigned long long)EventPump::DroppedEvents(), sink.Total);
+    return 0;
+}
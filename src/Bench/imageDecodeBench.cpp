@@ -0,0 +1,124 @@
+#include "../Graphics/imageLoader.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Images/s through ImageLoader for 1, 2, 4, ... workers up to the core count. Each pass loads every
+// file given repeat times and frees the pixels in load order, like FinishTextureLoads.
+// Usage: imagedecodebench [--repeat n] [--budget mb] [--workers max] image...
+using namespace Graphics;
+
+namespace
+{
+    struct Decoded
+    {
+        std::future<ImageHeader> Header;
+        std::vector<uint8_t> Pixels;
+        ImageLoader::Reservation Budget;
+    };
+
+    ImageLoaderStats Run(Util::Threading::ThreadPool * pool, uint64_t budget, const std::vector<std::string> & paths, int repeat)
+    {
+        ImageLoader loader(pool, budget);
+        std::vector<std::unique_ptr<Decoded>> loads;
+
+        for (int r = 0; r < repeat; r++)
+        {
+            for (const auto & path : paths)
+            {
+                auto load = std::make_unique<Decoded>();
+                auto destination = load.get();
+
+                load->Header = loader.Load(path, [destination](const ImageHeader & header, ImageLoader::Reservation reservation)
+                {
+                    destination->Pixels.resize(header.Size());
+                    destination->Budget = std::move(reservation);
+                    return destination->Pixels.data();
+                });
+
+                loads.push_back(std::move(load));
+            }
+        }
+
+        for (auto & load : loads)
+        {
+            load->Header.get();
+            load.reset();
+        }
+
+        return loader.Stats();
+    }
+}
+
+int main(int argc, char * argv[])
+{
+    int repeat = 4;
+    uint64_t budget = 256ull * 1024 * 1024;
+    size_t cores = std::max(std::thread::hardware_concurrency(), 1u);
+    std::vector<std::string> paths;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--repeat") == 0 && i + 1 < argc)
+        {
+            repeat = atoi(argv[++i]);
+        }
+        else if (strcmp(argv[i], "--budget") == 0 && i + 1 < argc)
+        {
+            budget = strtoull(argv[++i], nullptr, 10) * 1024 * 1024;
+        }
+        else if (strcmp(argv[i], "--workers") == 0 && i + 1 < argc)
+        {
+            cores = std::max<size_t>(strtoull(argv[++i], nullptr, 10), 1);
+        }
+        else
+        {
+            paths.push_back(argv[i]);
+        }
+    }
+
+    if (paths.empty() || repeat < 1)
+    {
+        fprintf(stderr, "usage: imagedecodebench [--repeat n] [--budget mb] [--workers max] image...\n");
+        return 1;
+    }
+
+    // Warms the page cache so the first pass is not the only one reading from disk.
+    {
+        Util::Threading::ThreadPool pool(cores);
+        Run(&pool, budget, paths, 1);
+    }
+
+    printf("%zu images x %d, %llu MB budget\n", paths.size(), repeat, (unsigned long long)(budget / (1024 * 1024)));
+    printf("  workers  images/s    MB/s  speedup\n");
+
+    double single = 0.0;
+
+    for (size_t workers = 1; ; workers = std::min(workers * 2, cores))
+    {
+        Util::Threading::ThreadPool pool(workers);
+        const auto stats = Run(&pool, budget, paths, repeat);
+        const double rate = stats.ImagesPerSecond();
+
+        if (workers == 1)
+        {
+            single = rate;
+        }
+
+        printf("  %7zu  %8.1f  %6.1f  %6.2fx\n", workers, rate,
+            stats.WallSeconds > 0.0 ? stats.DecodedBytes / stats.WallSeconds / (1024 * 1024) : 0.0,
+            single > 0.0 ? rate / single : 0.0);
+
+        if (workers == cores)
+        {
+            break;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,51 @@
+#ifndef ANYEVENT_H
+#define ANYEVENT_H
+#include "keyPressEvent.h"
+#include "keyReleaseEvent.h"
+#include "keyHoldEvent.h"
+#include "mouseMoveEvent.h"
+#include "mouseButtonPressEvent.h"
+#include "mouseButtonPressHoldEvent.h"
+#include "mouseButtonReleaseEvent.h"
+#include <stddef.h>
+#include <type_traits>
+#include <variant>
+
+namespace Events
+{
+    // Every event the pump can queue, held by value so posting one never touches the heap.
+    // monostate is the empty slot the ring default constructs.
+    typedef std::variant<
+        std::monostate,
+        KeyPressEvent,
+        KeyReleaseEvent,
+        KeyHoldEvent,
+        MouseMoveEvent,
+        MouseButtonPressEvent,
+        MouseButtonPressHoldEvent,
+        MouseButtonReleaseEvent> AnyEvent;
+
+    namespace Detail
+    {
+        template <typename T, typename Variant>
+        struct VariantIndex;
+
+        template <typename T, typename... Types>
+        struct VariantIndex<T, std::variant<T, Types...>> : std::integral_constant<size_t, 0>
+        {
+        };
+
+        template <typename T, typename First, typename... Types>
+        struct VariantIndex<T, std::variant<First, Types...>>
+            : std::integral_constant<size_t, 1 + VariantIndex<T, std::variant<Types...>>::value>
+        {
+        };
+    }
+
+    // Compile-time id of an event type, its position in AnyEvent.
+    template <typename T>
+    constexpr size_t EventTypeId = Detail::VariantIndex<T, AnyEvent>::value;
+
+    constexpr size_t EventTypeCount = std::variant_size_v<AnyEvent>;
+}
+#endif // !ANYEVENT_H
@@ -1,19 +1,40 @@
 #include "eventsPump.h"
+#include <type_traits>
 namespace Events
 {
     EventPump * EventPump::instance = nullptr;
-    void EventPump::registerHandler(IEventHandler * evtHandler)
+    bool EventPump::postEvent(AnyEvent && evt)
     {
-        this->handlers.push_back(evtHandler);
+        if (queue.TryPush(std::move(evt)))
+        {
+            return true;
+        }
+
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
     }
 
-    void EventPump::fireEvent(Event * evt)
+    void EventPump::dispatchEvents()
     {
-        for (const auto & handler : handlers)
+        // Only what is queued now goes out, events posted by handlers wait for the next frame.
+        // batch was reserved up front, so this never reallocates.
+        batch.clear();
+        AnyEvent evt;
+
+        while (batch.size() < QueueCapacity && queue.TryPop(evt))
         {
-            handler->HandleEvent(evt);
+            batch.push_back(std::move(evt));
         }
 
-        delete evt;
+        for (auto & queued : batch)
+        {
+            std::visit([this](auto & queuedEvent)
+            {
+                if constexpr (!std::is_same_v<std::decay_t<decltype(queuedEvent)>, std::monostate>)
+                {
+                    fireEvent(queuedEvent);
+                }
+            }, queued);
+        }
     }
 }
\ No newline at end of file
@@ -1,7 +1,11 @@
 #ifndef EVENTPUMP_H
 #define EVENTPUMP_H
-#include "event.h"
+#include "anyEvent.h"
 #include "iEventHandler.h"
+#include "../Utils/mpscRing.h"
+#include <stdint.h>
+#include <algorithm>
+#include <atomic>
 #include <vector>
 
 namespace Events
@@ -18,26 +22,75 @@ namespace Events
             return instance;
         }
 
-        static void RegisterHandler(IEventHandler * evtHandler)
+        // handler only receives events of type T.
+        template <typename T>
+        static void Subscribe(IEventHandler<T> * handler)
         {
-            GetInstance()->registerHandler(evtHandler);
+            GetInstance()->subscribers[EventTypeId<T>].push_back(handler);
         }
 
-        static void FireEvent(Event * evt)
+        template <typename T>
+        static void Unsubscribe(IEventHandler<T> * handler)
+        {
+            auto & list = GetInstance()->subscribers[EventTypeId<T>];
+            list.erase(std::remove(list.begin(), list.end(), (void *)handler), list.end());
+        }
+
+        // Delivers straight away on the calling thread, only for the main thread.
+        template <typename T>
+        static void FireEvent(const T & evt)
         {
             GetInstance()->fireEvent(evt);
         }
 
+        // Copies evt into the queue for the next DispatchEvents, safe from any thread. When the
+        // queue is full it is dropped and false is returned.
+        template <typename T>
+        static bool PostEvent(const T & evt)
+        {
+            return GetInstance()->postEvent(AnyEvent(std::in_place_type<T>, evt));
+        }
+
+        // Delivers everything posted so far, called once a frame by the main loop.
+        static void DispatchEvents()
+        {
+            GetInstance()->dispatchEvents();
+        }
+
+        static uint64_t DroppedEvents()
+        {
+            return GetInstance()->dropped.load(std::memory_order_relaxed);
+        }
+
     private:
-        EventPump() {}
+        static const size_t QueueCapacity = 4096;
+
+        EventPump()
+        {
+            batch.reserve(QueueCapacity);
+        }
 
-        void fireEvent(Event * evt);
+        template <typename T>
+        void fireEvent(const T & evt)
+        {
+            // Everything in the list was subscribed as an IEventHandler<T>.
+            for (void * handler : subscribers[EventTypeId<T>])
+            {
+                static_cast<IEventHandler<T> *>(handler)->HandleEvent(evt);
+            }
+        }
 
-        void registerHandler(IEventHandler * handler);
+        bool postEvent(AnyEvent && evt);
+        void dispatchEvents();
 
         static EventPump * instance;
 
-        std::vector<IEventHandler *> handlers;
+        // Indexed by EventTypeId, the handlers are stored type-erased.
+        std::vector<void *> subscribers[EventTypeCount];
+
+        Util::Threading::MpscRing<AnyEvent, QueueCapacity> queue;
+        std::vector<AnyEvent> batch;
+        std::atomic<uint64_t> dropped{ 0 };
     };
 }
 #endif // !EVENTPUMP_H
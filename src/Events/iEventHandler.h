@@ -1,14 +1,15 @@
 #ifndef IEVENTHANDLER_H
 #define IEVENTHANDLER_H
-#include "event.h"
 
 namespace Events
 {
+    // Implemented once per event type a class subscribes to.
+    template <typename T>
     class IEventHandler
     {
     public:
 
-        virtual void HandleEvent(Event * evt) = 0;
+        virtual void HandleEvent(const T & evt) = 0;
     };
 }
 
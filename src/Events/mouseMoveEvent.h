@@ -9,12 +9,16 @@ namespace Events
     {
     public:
 
+        // Cursor position at the end of the frame and the motion summed over it.
         double X;
         double Y;
+        double DeltaX;
+        double DeltaY;
 
-        MouseMoveEvent(double x, double y)
+        MouseMoveEvent(double x, double y, double deltaX, double deltaY)
         {
             this->X = x; this->Y = y;
+            this->DeltaX = deltaX; this->DeltaY = deltaY;
         }
     };
 }
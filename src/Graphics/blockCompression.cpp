@@ -0,0 +1,813 @@
+#include "blockCompression.h"
+#include "../Utils/threadPool.h"
+#include <float.h>
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define BLOCK_COMPRESSION_SSE
+#include <emmintrin.h>
+#endif
+
+namespace Graphics
+{
+    namespace
+    {
+        const uint32_t BlockDim = 4;
+        const int PowerIterations = 8;
+
+        // Interpolation weights for 4 bit BC7 indices, out of 64.
+        const int Bc7Weights[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+        // Position of each BC1 index between colour0 and colour1.
+        const float Bc1Positions[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+
+        const float ColourWeights[4] = { 1.0f, 1.0f, 1.0f, 0.0f };
+        const float AlphaWeights[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+        const float RgbaWeights[4] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+        // 16 texels as planar RGBA floats in 0-255, so four texels fit a register per channel.
+        struct Block
+        {
+            alignas(16) float Channel[4][16];
+        };
+
+        void LoadBlock(const uint8_t * rgba, uint32_t width, uint32_t height, uint32_t bx, uint32_t by, Block & block)
+        {
+            for (uint32_t y = 0; y < BlockDim; y++)
+            {
+                const uint32_t sy = std::min(by * BlockDim + y, height - 1);
+
+                for (uint32_t x = 0; x < BlockDim; x++)
+                {
+                    const uint32_t sx = std::min(bx * BlockDim + x, width - 1);
+                    const uint8_t * texel = rgba + ((size_t)sy * width + sx) * 4;
+
+                    for (int c = 0; c < 4; c++)
+                    {
+                        block.Channel[c][y * BlockDim + x] = texel[c];
+                    }
+                }
+            }
+        }
+
+        // Picks the closest palette entry for every texel, returns the summed weighted squared error.
+        float AssignIndices(const Block & block, const float (*palette)[4], int count, const float * weights, uint8_t * indices)
+        {
+            float error = 0.0f;
+
+#ifdef BLOCK_COMPRESSION_SSE
+            const __m128 wr = _mm_set1_ps(weights[0]);
+            const __m128 wg = _mm_set1_ps(weights[1]);
+            const __m128 wb = _mm_set1_ps(weights[2]);
+            const __m128 wa = _mm_set1_ps(weights[3]);
+
+            for (int g = 0; g < 16; g += 4)
+            {
+                const __m128 r = _mm_load_ps(&block.Channel[0][g]);
+                const __m128 gr = _mm_load_ps(&block.Channel[1][g]);
+                const __m128 b = _mm_load_ps(&block.Channel[2][g]);
+                const __m128 a = _mm_load_ps(&block.Channel[3][g]);
+
+                __m128 best = _mm_set1_ps(FLT_MAX);
+                __m128 bestIndex = _mm_setzero_ps();
+
+                for (int i = 0; i < count; i++)
+                {
+                    const __m128 dr = _mm_sub_ps(r, _mm_set1_ps(palette[i][0]));
+                    const __m128 dg = _mm_sub_ps(gr, _mm_set1_ps(palette[i][1]));
+                    const __m128 db = _mm_sub_ps(b, _mm_set1_ps(palette[i][2]));
+                    const __m128 da = _mm_sub_ps(a, _mm_set1_ps(palette[i][3]));
+
+                    __m128 d = _mm_mul_ps(wr, _mm_mul_ps(dr, dr));
+                    d = _mm_add_ps(d, _mm_mul_ps(wg, _mm_mul_ps(dg, dg)));
+                    d = _mm_add_ps(d, _mm_mul_ps(wb, _mm_mul_ps(db, db)));
+                    d = _mm_add_ps(d, _mm_mul_ps(wa, _mm_mul_ps(da, da)));
+
+                    const __m128 closer = _mm_cmplt_ps(d, best);
+                    best = _mm_min_ps(d, best);
+                    bestIndex = _mm_or_ps(_mm_and_ps(closer, _mm_set1_ps((float)i)), _mm_andnot_ps(closer, bestIndex));
+                }
+
+                alignas(16) float distance[4];
+                alignas(16) float index[4];
+                _mm_store_ps(distance, best);
+                _mm_store_ps(index, bestIndex);
+
+                for (int k = 0; k < 4; k++)
+                {
+                    indices[g + k] = (uint8_t)index[k];
+                    error += distance[k];
+                }
+            }
+#else
+            for (int t = 0; t < 16; t++)
+            {
+                float best = FLT_MAX;
+
+                for (int i = 0; i < count; i++)
+                {
+                    float d = 0.0f;
+
+                    for (int c = 0; c < 4; c++)
+                    {
+                        const float delta = block.Channel[c][t] - palette[i][c];
+                        d += weights[c] * delta * delta;
+                    }
+
+                    if (d < best)
+                    {
+                        best = d;
+                        indices[t] = (uint8_t)i;
+                    }
+                }
+
+                error += best;
+            }
+#endif
+
+            return error;
+        }
+
+#ifdef BLOCK_COMPRESSION_SSE
+        template <int Lane>
+        inline __m128 Broadcast(__m128 v)
+        {
+            return _mm_shuffle_ps(v, v, _MM_SHUFFLE(Lane, Lane, Lane, Lane));
+        }
+
+        inline void Transpose(const __m128 v[4], __m128 t[4])
+        {
+            t[0] = v[0];
+            t[1] = v[1];
+            t[2] = v[2];
+            t[3] = v[3];
+            _MM_TRANSPOSE4_PS(t[0], t[1], t[2], t[3]);
+        }
+
+        // Lane c of the result reduces the four lanes of v[c].
+        inline __m128 SumLanes(const __m128 v[4])
+        {
+            __m128 t[4];
+            Transpose(v, t);
+            return _mm_add_ps(_mm_add_ps(t[0], t[1]), _mm_add_ps(t[2], t[3]));
+        }
+
+        inline __m128 MinLanes(const __m128 v[4])
+        {
+            __m128 t[4];
+            Transpose(v, t);
+            return _mm_min_ps(_mm_min_ps(t[0], t[1]), _mm_min_ps(t[2], t[3]));
+        }
+
+        inline __m128 MaxLanes(const __m128 v[4])
+        {
+            __m128 t[4];
+            Transpose(v, t);
+            return _mm_max_ps(_mm_max_ps(t[0], t[1]), _mm_max_ps(t[2], t[3]));
+        }
+
+        inline float HorizontalSum(__m128 v)
+        {
+            v = _mm_add_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+            return _mm_cvtss_f32(_mm_add_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2))));
+        }
+
+        inline float HorizontalMin(__m128 v)
+        {
+            v = _mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+            return _mm_cvtss_f32(_mm_min_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2))));
+        }
+
+        inline float HorizontalMax(__m128 v)
+        {
+            v = _mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(2, 3, 0, 1)));
+            return _mm_cvtss_f32(_mm_max_ps(v, _mm_shuffle_ps(v, v, _MM_SHUFFLE(1, 0, 3, 2))));
+        }
+#endif
+
+        // Extremes of the block along its principal axis over the first channels, found by power iteration.
+        void PrincipalEndpoints(const Block & block, int channels, float low[4], float high[4])
+        {
+#ifdef BLOCK_COMPRESSION_SSE
+            // Channels become lanes. The ones past channels are zeroed once centred, so they add nothing to the
+            // covariance or the projections and their axis component stays 0.
+            const __m128 used = _mm_castsi128_ps(_mm_cmplt_epi32(_mm_setr_epi32(0, 1, 2, 3), _mm_set1_epi32(channels)));
+            const __m128 zero = _mm_setzero_ps();
+
+            __m128 sums[4];
+            __m128 minimums[4];
+            __m128 maximums[4];
+
+            for (int c = 0; c < 4; c++)
+            {
+                const __m128 g0 = _mm_load_ps(&block.Channel[c][0]);
+                const __m128 g1 = _mm_load_ps(&block.Channel[c][4]);
+                const __m128 g2 = _mm_load_ps(&block.Channel[c][8]);
+                const __m128 g3 = _mm_load_ps(&block.Channel[c][12]);
+
+                sums[c] = _mm_add_ps(_mm_add_ps(g0, g1), _mm_add_ps(g2, g3));
+                minimums[c] = _mm_min_ps(_mm_min_ps(g0, g1), _mm_min_ps(g2, g3));
+                maximums[c] = _mm_max_ps(_mm_max_ps(g0, g1), _mm_max_ps(g2, g3));
+            }
+
+            const __m128 mean = _mm_mul_ps(SumLanes(sums), _mm_set1_ps(1.0f / 16.0f));
+            _mm_storeu_ps(low, mean);
+            _mm_storeu_ps(high, mean);
+
+            __m128 axis = _mm_and_ps(used, _mm_sub_ps(MaxLanes(maximums), MinLanes(minimums)));
+
+            // Flat block, both endpoints are the mean.
+            if (_mm_movemask_ps(_mm_cmpneq_ps(axis, zero)) == 0)
+            {
+                return;
+            }
+
+            // Centred texels, four per register per channel.
+            __m128 centred[4][4];
+
+            for (int c = 0; c < 4; c++)
+            {
+                const __m128 offset = _mm_set1_ps(low[c]);
+
+                for (int g = 0; g < 4; g++)
+                {
+                    centred[c][g] = c < channels ? _mm_sub_ps(_mm_load_ps(&block.Channel[c][g * 4]), offset) : zero;
+                }
+            }
+
+            // Row i of the covariance matrix, which is also column i.
+            __m128 covariance[4];
+
+            for (int i = 0; i < 4; i++)
+            {
+                __m128 products[4];
+
+                for (int j = 0; j < 4; j++)
+                {
+                    products[j] = _mm_add_ps(
+                        _mm_add_ps(_mm_mul_ps(centred[i][0], centred[j][0]), _mm_mul_ps(centred[i][1], centred[j][1])),
+                        _mm_add_ps(_mm_mul_ps(centred[i][2], centred[j][2]), _mm_mul_ps(centred[i][3], centred[j][3])));
+                }
+
+                covariance[i] = SumLanes(products);
+            }
+
+            for (int iteration = 0; iteration < PowerIterations; iteration++)
+            {
+                const __m128 next = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(covariance[0], Broadcast<0>(axis)), _mm_mul_ps(covariance[1], Broadcast<1>(axis))),
+                    _mm_add_ps(_mm_mul_ps(covariance[2], Broadcast<2>(axis)), _mm_mul_ps(covariance[3], Broadcast<3>(axis))));
+
+                const float norm = HorizontalMax(_mm_andnot_ps(_mm_set1_ps(-0.0f), next));
+
+                if (norm == 0.0f)
+                {
+                    break;
+                }
+
+                axis = _mm_div_ps(next, _mm_set1_ps(norm));
+            }
+
+            axis = _mm_mul_ps(axis, _mm_set1_ps(1.0f / sqrtf(HorizontalSum(_mm_mul_ps(axis, axis)))));
+
+            __m128 projections[4];
+
+            for (int g = 0; g < 4; g++)
+            {
+                projections[g] = _mm_add_ps(
+                    _mm_add_ps(_mm_mul_ps(centred[0][g], Broadcast<0>(axis)), _mm_mul_ps(centred[1][g], Broadcast<1>(axis))),
+                    _mm_add_ps(_mm_mul_ps(centred[2][g], Broadcast<2>(axis)), _mm_mul_ps(centred[3][g], Broadcast<3>(axis))));
+            }
+
+            const __m128 minT = _mm_set1_ps(HorizontalMin(_mm_min_ps(_mm_min_ps(projections[0], projections[1]), _mm_min_ps(projections[2], projections[3]))));
+            const __m128 maxT = _mm_set1_ps(HorizontalMax(_mm_max_ps(_mm_max_ps(projections[0], projections[1]), _mm_max_ps(projections[2], projections[3]))));
+
+            // The unused channels have a zero axis, so they stay at the mean.
+            const __m128 top = _mm_set1_ps(255.0f);
+            _mm_storeu_ps(low, _mm_min_ps(_mm_max_ps(_mm_add_ps(mean, _mm_mul_ps(axis, minT)), zero), top));
+            _mm_storeu_ps(high, _mm_min_ps(_mm_max_ps(_mm_add_ps(mean, _mm_mul_ps(axis, maxT)), zero), top));
+#else
+            float mean[4] = {};
+            float minimum[4];
+            float maximum[4];
+
+            for (int c = 0; c < 4; c++)
+            {
+                minimum[c] = maximum[c] = block.Channel[c][0];
+
+                for (int t = 0; t < 16; t++)
+                {
+                    mean[c] += block.Channel[c][t];
+                    minimum[c] = std::min(minimum[c], block.Channel[c][t]);
+                    maximum[c] = std::max(maximum[c], block.Channel[c][t]);
+                }
+
+                mean[c] /= 16.0f;
+                low[c] = high[c] = mean[c];
+            }
+
+            float covariance[4][4] = {};
+
+            for (int t = 0; t < 16; t++)
+            {
+                for (int i = 0; i < channels; i++)
+                {
+                    for (int j = i; j < channels; j++)
+                    {
+                        covariance[i][j] += (block.Channel[i][t] - mean[i]) * (block.Channel[j][t] - mean[j]);
+                    }
+                }
+            }
+
+            for (int i = 0; i < channels; i++)
+            {
+                for (int j = 0; j < i; j++)
+                {
+                    covariance[i][j] = covariance[j][i];
+                }
+            }
+
+            float axis[4] = {};
+            float length = 0.0f;
+
+            for (int c = 0; c < channels; c++)
+            {
+                axis[c] = maximum[c] - minimum[c];
+                length += axis[c] * axis[c];
+            }
+
+            // Flat block, both endpoints are the mean.
+            if (length == 0.0f)
+            {
+                return;
+            }
+
+            for (int iteration = 0; iteration < PowerIterations; iteration++)
+            {
+                float next[4] = {};
+                float norm = 0.0f;
+
+                for (int i = 0; i < channels; i++)
+                {
+                    for (int j = 0; j < channels; j++)
+                    {
+                        next[i] += covariance[i][j] * axis[j];
+                    }
+
+                    norm = std::max(norm, fabsf(next[i]));
+                }
+
+                if (norm == 0.0f)
+                {
+                    break;
+                }
+
+                for (int c = 0; c < channels; c++)
+                {
+                    axis[c] = next[c] / norm;
+                }
+            }
+
+            length = 0.0f;
+            for (int c = 0; c < channels; c++)
+            {
+                length += axis[c] * axis[c];
+            }
+
+            const float scale = 1.0f / sqrtf(length);
+            for (int c = 0; c < channels; c++)
+            {
+                axis[c] *= scale;
+            }
+
+            float minT = FLT_MAX;
+            float maxT = -FLT_MAX;
+
+            for (int t = 0; t < 16; t++)
+            {
+                float projection = 0.0f;
+
+                for (int c = 0; c < channels; c++)
+                {
+                    projection += (block.Channel[c][t] - mean[c]) * axis[c];
+                }
+
+                minT = std::min(minT, projection);
+                maxT = std::max(maxT, projection);
+            }
+
+            for (int c = 0; c < channels; c++)
+            {
+                low[c] = std::min(std::max(mean[c] + axis[c] * minT, 0.0f), 255.0f);
+                high[c] = std::min(std::max(mean[c] + axis[c] * maxT, 0.0f), 255.0f);
+            }
+#endif
+        }
+
+        // Least squares endpoints for fixed indices, where index i sits at positions[i] between first and second.
+        bool FitEndpoints(const Block & block, const uint8_t * indices, const float * positions, float first[4], float second[4])
+        {
+            float aa = 0.0f;
+            float ab = 0.0f;
+            float bb = 0.0f;
+            float ax[4] = {};
+            float bx[4] = {};
+
+            for (int t = 0; t < 16; t++)
+            {
+                const float w = positions[indices[t]];
+                const float v = 1.0f - w;
+
+                aa += v * v;
+                ab += v * w;
+                bb += w * w;
+
+                for (int c = 0; c < 4; c++)
+                {
+                    ax[c] += v * block.Channel[c][t];
+                    bx[c] += w * block.Channel[c][t];
+                }
+            }
+
+            const float determinant = aa * bb - ab * ab;
+
+            if (fabsf(determinant) < 1e-6f)
+            {
+                return false;
+            }
+
+            const float inverse = 1.0f / determinant;
+
+            for (int c = 0; c < 4; c++)
+            {
+                first[c] = std::min(std::max((ax[c] * bb - bx[c] * ab) * inverse, 0.0f), 255.0f);
+                second[c] = std::min(std::max((bx[c] * aa - ax[c] * ab) * inverse, 0.0f), 255.0f);
+            }
+
+            return true;
+        }
+
+        uint16_t Pack565(const float colour[4])
+        {
+            const uint32_t r = (uint32_t)(colour[0] * 31.0f / 255.0f + 0.5f);
+            const uint32_t g = (uint32_t)(colour[1] * 63.0f / 255.0f + 0.5f);
+            const uint32_t b = (uint32_t)(colour[2] * 31.0f / 255.0f + 0.5f);
+            return (uint16_t)((r << 11) | (g << 5) | b);
+        }
+
+        void Unpack565(uint16_t packed, float colour[4])
+        {
+            const uint32_t r = (packed >> 11) & 31;
+            const uint32_t g = (packed >> 5) & 63;
+            const uint32_t b = packed & 31;
+
+            colour[0] = (float)((r << 3) | (r >> 2));
+            colour[1] = (float)((g << 2) | (g >> 4));
+            colour[2] = (float)((b << 3) | (b >> 2));
+            colour[3] = 0.0f;
+        }
+
+        struct Bc1Candidate
+        {
+            uint16_t Colour0;
+            uint16_t Colour1;
+            uint8_t Indices[16];
+            float Error;
+        };
+
+        // Quantises a pair of endpoints to 565 in four colour order and assigns indices.
+        Bc1Candidate EvaluateBc1(const Block & block, const float a[4], const float b[4])
+        {
+            Bc1Candidate candidate;
+            candidate.Colour0 = Pack565(a);
+            candidate.Colour1 = Pack565(b);
+
+            // Colour0 > colour1 selects four colour mode; equal endpoints decode as a solid block through index 0.
+            if (candidate.Colour0 < candidate.Colour1)
+            {
+                std::swap(candidate.Colour0, candidate.Colour1);
+            }
+
+            float palette[4][4];
+            Unpack565(candidate.Colour0, palette[0]);
+            Unpack565(candidate.Colour1, palette[1]);
+
+            for (int c = 0; c < 4; c++)
+            {
+                palette[2][c] = (2.0f * palette[0][c] + palette[1][c]) / 3.0f;
+                palette[3][c] = (palette[0][c] + 2.0f * palette[1][c]) / 3.0f;
+            }
+
+            candidate.Error = AssignIndices(block, palette, 4, ColourWeights, candidate.Indices);
+            return candidate;
+        }
+
+        void EncodeBc1(const Block & block, uint8_t * out)
+        {
+            float low[4];
+            float high[4];
+            PrincipalEndpoints(block, 3, low, high);
+
+            auto best = EvaluateBc1(block, high, low);
+
+            // One refinement against the chosen indices usually recovers most of the quantisation loss.
+            float first[4];
+            float second[4];
+
+            if (best.Colour0 != best.Colour1 && FitEndpoints(block, best.Indices, Bc1Positions, first, second))
+            {
+                const auto refined = EvaluateBc1(block, first, second);
+
+                if (refined.Error < best.Error)
+                {
+                    best = refined;
+                }
+            }
+
+            uint32_t bits = 0;
+
+            for (int t = 0; t < 16; t++)
+            {
+                bits |= (uint32_t)best.Indices[t] << (t * 2);
+            }
+
+            out[0] = (uint8_t)best.Colour0;
+            out[1] = (uint8_t)(best.Colour0 >> 8);
+            out[2] = (uint8_t)best.Colour1;
+            out[3] = (uint8_t)(best.Colour1 >> 8);
+
+            for (int i = 0; i < 4; i++)
+            {
+                out[4 + i] = (uint8_t)(bits >> (i * 8));
+            }
+        }
+
+        // The BC3 alpha block: two 8 bit endpoints and 3 bit indices into the eight value ramp.
+        void EncodeAlpha(const Block & block, uint8_t * out)
+        {
+            float minimum = 255.0f;
+            float maximum = 0.0f;
+
+            for (int t = 0; t < 16; t++)
+            {
+                minimum = std::min(minimum, block.Channel[3][t]);
+                maximum = std::max(maximum, block.Channel[3][t]);
+            }
+
+            const uint8_t alpha0 = (uint8_t)maximum;
+            const uint8_t alpha1 = (uint8_t)minimum;
+
+            memset(out, 0, 8);
+            out[0] = alpha0;
+            out[1] = alpha1;
+
+            if (alpha0 == alpha1)
+            {
+                return;
+            }
+
+            float palette[8][4] = {};
+            palette[0][3] = alpha0;
+            palette[1][3] = alpha1;
+
+            for (int i = 1; i < 7; i++)
+            {
+                palette[i + 1][3] = (float)(((7 - i) * alpha0 + i * alpha1) / 7);
+            }
+
+            uint8_t indices[16];
+            AssignIndices(block, palette, 8, AlphaWeights, indices);
+
+            uint64_t bits = 0;
+
+            for (int t = 0; t < 16; t++)
+            {
+                bits |= (uint64_t)indices[t] << (t * 3);
+            }
+
+            for (int i = 0; i < 6; i++)
+            {
+                out[2 + i] = (uint8_t)(bits >> (i * 8));
+            }
+        }
+
+        struct Bc7Candidate
+        {
+            uint8_t Endpoints[2][4];
+            uint8_t PBits[2];
+            uint8_t Indices[16];
+            float Error;
+        };
+
+        // 7 bit endpoint plus the shared low bit that rounds it closest.
+        void QuantiseBc7(const float endpoint[4], uint8_t quantised[4], uint8_t & pBit)
+        {
+            float bestError = FLT_MAX;
+
+            for (int p = 0; p < 2; p++)
+            {
+                uint8_t candidate[4];
+                float error = 0.0f;
+
+                for (int c = 0; c < 4; c++)
+                {
+                    const int q = std::min(std::max((int)((endpoint[c] - p) * 0.5f + 0.5f), 0), 127);
+                    const float delta = (float)((q << 1) | p) - endpoint[c];
+
+                    candidate[c] = (uint8_t)q;
+                    error += delta * delta;
+                }
+
+                if (error < bestError)
+                {
+                    bestError = error;
+                    pBit = (uint8_t)p;
+                    memcpy(quantised, candidate, 4);
+                }
+            }
+        }
+
+        Bc7Candidate EvaluateBc7(const Block & block, const float a[4], const float b[4])
+        {
+            Bc7Candidate candidate;
+            QuantiseBc7(a, candidate.Endpoints[0], candidate.PBits[0]);
+            QuantiseBc7(b, candidate.Endpoints[1], candidate.PBits[1]);
+
+            float palette[16][4];
+
+            for (int c = 0; c < 4; c++)
+            {
+                const int e0 = (candidate.Endpoints[0][c] << 1) | candidate.PBits[0];
+                const int e1 = (candidate.Endpoints[1][c] << 1) | candidate.PBits[1];
+
+                for (int i = 0; i < 16; i++)
+                {
+                    palette[i][c] = (float)(((64 - Bc7Weights[i]) * e0 + Bc7Weights[i] * e1 + 32) >> 6);
+                }
+            }
+
+            candidate.Error = AssignIndices(block, palette, 16, RgbaWeights, candidate.Indices);
+            return candidate;
+        }
+
+        struct BitWriter
+        {
+            uint8_t * Out;
+            uint32_t Position;
+
+            void Write(uint32_t value, uint32_t bits)
+            {
+                for (uint32_t i = 0; i < bits; i++, Position++)
+                {
+                    Out[Position >> 3] |= (uint8_t)(((value >> i) & 1) << (Position & 7));
+                }
+            }
+        };
+
+        void EncodeBc7(const Block & block, uint8_t * out)
+        {
+            float low[4];
+            float high[4];
+            PrincipalEndpoints(block, 4, low, high);
+
+            auto best = EvaluateBc7(block, low, high);
+
+            float positions[16];
+            for (int i = 0; i < 16; i++)
+            {
+                positions[i] = Bc7Weights[i] / 64.0f;
+            }
+
+            float first[4];
+            float second[4];
+
+            if (FitEndpoints(block, best.Indices, positions, first, second))
+            {
+                const auto refined = EvaluateBc7(block, first, second);
+
+                if (refined.Error < best.Error)
+                {
+                    best = refined;
+                }
+            }
+
+            // The anchor texel's index drops its top bit, so make sure it is below 8.
+            if (best.Indices[0] >= 8)
+            {
+                std::swap(best.Endpoints[0], best.Endpoints[1]);
+                std::swap(best.PBits[0], best.PBits[1]);
+
+                for (int t = 0; t < 16; t++)
+                {
+                    best.Indices[t] = 15 - best.Indices[t];
+                }
+            }
+
+            memset(out, 0, 16);
+            BitWriter writer = { out, 0 };
+
+            writer.Write(1 << 6, 7);
+
+            for (int c = 0; c < 4; c++)
+            {
+                writer.Write(best.Endpoints[0][c], 7);
+                writer.Write(best.Endpoints[1][c], 7);
+            }
+
+            writer.Write(best.PBits[0], 1);
+            writer.Write(best.PBits[1], 1);
+            writer.Write(best.Indices[0], 3);
+
+            for (int t = 1; t < 16; t++)
+            {
+                writer.Write(best.Indices[t], 4);
+            }
+        }
+    }
+
+    uint32_t BlockCompressor::BlockBytes(BlockFormat format)
+    {
+        return format == BlockFormat::BC1 ? 8 : 16;
+    }
+
+    std::vector<MipLevel> BlockCompressor::Layout(BlockFormat format, uint32_t width, uint32_t height)
+    {
+        std::vector<MipLevel> levels(MipChain::LevelCount(width, height));
+        uint64_t offset = 0;
+
+        for (auto & level : levels)
+        {
+            level.Width = width;
+            level.Height = height;
+            level.Offset = offset;
+            level.Size = EncodedSize(format, width, height);
+
+            offset = (offset + level.Size + 15) & ~15ull;
+            width = std::max(width / 2, 1u);
+            height = std::max(height / 2, 1u);
+        }
+
+        return levels;
+    }
+
+    uint64_t BlockCompressor::EncodedSize(BlockFormat format, uint32_t width, uint32_t height)
+    {
+        const uint64_t blocksX = (width + BlockDim - 1) / BlockDim;
+        const uint64_t blocksY = (height + BlockDim - 1) / BlockDim;
+        return blocksX * blocksY * BlockBytes(format);
+    }
+
+    void BlockCompressor::Encode(BlockFormat format, const uint8_t * rgba, uint32_t width, uint32_t height, uint8_t * out)
+    {
+        const uint32_t blocksX = (width + BlockDim - 1) / BlockDim;
+        const uint32_t blocksY = (height + BlockDim - 1) / BlockDim;
+        const uint32_t blockBytes = BlockBytes(format);
+
+        Util::Threading::ThreadPool::GetInstance()->ParallelFor(blocksY, 1, [&](size_t firstRow, size_t lastRow)
+        {
+            Block block;
+
+            for (size_t by = firstRow; by < lastRow; by++)
+            {
+                uint8_t * row = out + by * blocksX * blockBytes;
+
+                for (uint32_t bx = 0; bx < blocksX; bx++)
+                {
+                    LoadBlock(rgba, width, height, bx, (uint32_t)by, block);
+                    uint8_t * encoded = row + (size_t)bx * blockBytes;
+
+                    switch (format)
+                    {
+                    case BlockFormat::BC1:
+                        EncodeBc1(block, encoded);
+                        break;
+                    case BlockFormat::BC3:
+                        EncodeAlpha(block, encoded);
+                        EncodeBc1(block, encoded + 8);
+                        break;
+                    case BlockFormat::BC7:
+                        EncodeBc7(block, encoded);
+                        break;
+                    }
+                }
+            }
+        });
+    }
+
+    bool BlockCompressor::HasAlpha(const uint8_t * rgba, uint32_t width, uint32_t height)
+    {
+        const size_t count = (size_t)width * height;
+
+        for (size_t i = 0; i < count; i++)
+        {
+            if (rgba[i * 4 + 3] != 255)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+}
@@ -0,0 +1,37 @@
+#ifndef BLOCKCOMPRESSION_H
+#define BLOCKCOMPRESSION_H
+#include <stdint.h>
+#include <vector>
+#include "mipChain.h"
+
+namespace Graphics
+{
+    enum class BlockFormat
+    {
+        // RGB at 4 bits per pixel, alpha is dropped.
+        BC1,
+
+        // BC1 colour plus a separate interpolated alpha block, 8 bits per pixel.
+        BC3,
+
+        // RGBA at 8 bits per pixel, encoded with mode 6 only (one subset, 7.7.7.7.1 endpoints, 4 bit indices).
+        BC7
+    };
+
+    class BlockCompressor
+    {
+    public:
+        static uint32_t BlockBytes(BlockFormat format);
+
+        // Same level sizes as MipChain::Layout but in 4x4 blocks, partial blocks rounded up.
+        static std::vector<MipLevel> Layout(BlockFormat format, uint32_t width, uint32_t height);
+        static uint64_t EncodedSize(BlockFormat format, uint32_t width, uint32_t height);
+
+        // Encodes tightly packed RGBA8 into blocks, rows of blocks in parallel. Pixels past the edge of
+        // partial blocks repeat the last row or column.
+        static void Encode(BlockFormat format, const uint8_t * rgba, uint32_t width, uint32_t height, uint8_t * out);
+
+        static bool HasAlpha(const uint8_t * rgba, uint32_t width, uint32_t height);
+    };
+}
+#endif // !BLOCKCOMPRESSION_H
@@ -0,0 +1,159 @@
+#include "clusterCuller.h"
+#include <math.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define CLUSTER_CULLER_SSE
+#include <xmmintrin.h>
+#endif
+
+namespace Graphics
+{
+    namespace
+    {
+        // Gribb-Hartmann extraction, normalised so plane distances are in object space units. The near
+        // plane uses the -w..w convention, which for 0..1 depth is slightly behind the real one and
+        // therefore still conservative.
+        void ExtractPlanes(const glm::mat4 & m, glm::vec4 planes[6])
+        {
+            const glm::vec4 row0(m[0][0], m[1][0], m[2][0], m[3][0]);
+            const glm::vec4 row1(m[0][1], m[1][1], m[2][1], m[3][1]);
+            const glm::vec4 row2(m[0][2], m[1][2], m[2][2], m[3][2]);
+            const glm::vec4 row3(m[0][3], m[1][3], m[2][3], m[3][3]);
+
+            planes[0] = row3 + row0;
+            planes[1] = row3 - row0;
+            planes[2] = row3 + row1;
+            planes[3] = row3 - row1;
+            planes[4] = row3 + row2;
+            planes[5] = row3 - row2;
+
+            for (int i = 0; i < 6; i++)
+            {
+                planes[i] /= glm::length(glm::vec3(planes[i]));
+            }
+        }
+    }
+
+    void ClusterCuller::Assign(const std::vector<MeshletBounds> & bounds)
+    {
+        count = bounds.size();
+
+        const size_t padded = (count + 3) & ~size_t(3);
+
+        // Padding clusters have a negative radius, which fails every plane test.
+        centerX.assign(padded, 0.0f);
+        centerY.assign(padded, 0.0f);
+        centerZ.assign(padded, 0.0f);
+        radius.assign(padded, -1.0f);
+        apexX.assign(padded, 0.0f);
+        apexY.assign(padded, 0.0f);
+        apexZ.assign(padded, 0.0f);
+        axisX.assign(padded, 0.0f);
+        axisY.assign(padded, 0.0f);
+        axisZ.assign(padded, 1.0f);
+        cutoff.assign(padded, 2.0f);
+
+        for (size_t i = 0; i < count; i++)
+        {
+            centerX[i] = bounds[i].Center.x;
+            centerY[i] = bounds[i].Center.y;
+            centerZ[i] = bounds[i].Center.z;
+            radius[i] = bounds[i].Radius;
+            apexX[i] = bounds[i].Apex.x;
+            apexY[i] = bounds[i].Apex.y;
+            apexZ[i] = bounds[i].Apex.z;
+            axisX[i] = bounds[i].Axis.x;
+            axisY[i] = bounds[i].Axis.y;
+            axisZ[i] = bounds[i].Axis.z;
+            cutoff[i] = bounds[i].Cutoff;
+        }
+    }
+
+    size_t ClusterCuller::Count() const
+    {
+        return count;
+    }
+
+    void ClusterCuller::Cull(const glm::mat4 & modelViewProj, const glm::vec3 & eye, std::vector<uint32_t> & visible) const
+    {
+        visible.clear();
+
+        glm::vec4 planes[6];
+        ExtractPlanes(modelViewProj, planes);
+
+#ifdef CLUSTER_CULLER_SSE
+        const __m128 zero = _mm_setzero_ps();
+        const __m128 eyeX = _mm_set1_ps(eye.x);
+        const __m128 eyeY = _mm_set1_ps(eye.y);
+        const __m128 eyeZ = _mm_set1_ps(eye.z);
+
+        for (size_t i = 0; i < centerX.size(); i += 4)
+        {
+            const __m128 cx = _mm_loadu_ps(&centerX[i]);
+            const __m128 cy = _mm_loadu_ps(&centerY[i]);
+            const __m128 cz = _mm_loadu_ps(&centerZ[i]);
+            const __m128 r = _mm_loadu_ps(&radius[i]);
+
+            __m128 inside = _mm_cmpge_ps(r, zero);
+
+            for (int p = 0; p < 6; p++)
+            {
+                __m128 distance = _mm_add_ps(_mm_set1_ps(planes[p].w), r);
+                distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes[p].x), cx));
+                distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes[p].y), cy));
+                distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(planes[p].z), cz));
+                inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, zero));
+            }
+
+            // dot(apex - eye, axis) > cutoff * |apex - eye| means every triangle faces away.
+            const __m128 dx = _mm_sub_ps(_mm_loadu_ps(&apexX[i]), eyeX);
+            const __m128 dy = _mm_sub_ps(_mm_loadu_ps(&apexY[i]), eyeY);
+            const __m128 dz = _mm_sub_ps(_mm_loadu_ps(&apexZ[i]), eyeZ);
+
+            __m128 along = _mm_mul_ps(dx, _mm_loadu_ps(&axisX[i]));
+            along = _mm_add_ps(along, _mm_mul_ps(dy, _mm_loadu_ps(&axisY[i])));
+            along = _mm_add_ps(along, _mm_mul_ps(dz, _mm_loadu_ps(&axisZ[i])));
+
+            __m128 lengthSq = _mm_mul_ps(dx, dx);
+            lengthSq = _mm_add_ps(lengthSq, _mm_mul_ps(dy, dy));
+            lengthSq = _mm_add_ps(lengthSq, _mm_mul_ps(dz, dz));
+
+            const __m128 backfacing = _mm_cmpgt_ps(along, _mm_mul_ps(_mm_loadu_ps(&cutoff[i]), _mm_sqrt_ps(lengthSq)));
+
+            const int mask = _mm_movemask_ps(_mm_andnot_ps(backfacing, inside));
+
+            for (int lane = 0; lane < 4; lane++)
+            {
+                if (mask & (1 << lane))
+                {
+                    visible.push_back((uint32_t)(i + lane));
+                }
+            }
+        }
+#else
+        for (size_t i = 0; i < count; i++)
+        {
+            bool inside = true;
+
+            for (int p = 0; p < 6 && inside; p++)
+            {
+                inside = planes[p].x * centerX[i] + planes[p].y * centerY[i] + planes[p].z * centerZ[i] + planes[p].w + radius[i] >= 0.0f;
+            }
+
+            if (!inside)
+            {
+                continue;
+            }
+
+            const glm::vec3 toApex = glm::vec3(apexX[i], apexY[i], apexZ[i]) - eye;
+
+            if (glm::dot(toApex, glm::vec3(axisX[i], axisY[i], axisZ[i])) > cutoff[i] * glm::length(toApex))
+            {
+                continue;
+            }
+
+            visible.push_back((uint32_t)i);
+        }
+#endif
+    }
+}
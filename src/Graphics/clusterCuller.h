@@ -0,0 +1,39 @@
+#ifndef CLUSTERCULLER_H
+#define CLUSTERCULLER_H
+#include <stdint.h>
+#include <vector>
+#include "meshlet.h"
+
+namespace Graphics
+{
+    // Frustum and backface cone culling for the clusters of one mesh, four clusters at a time.
+    // Bounds are kept as structure of arrays padded to a multiple of four so the loop needs no tail.
+    class ClusterCuller
+    {
+    public:
+        void Assign(const std::vector<MeshletBounds> & bounds);
+
+        // modelViewProj maps object space to clip space and eye is the camera position in object space.
+        // Indices of the clusters that may be visible are written to visible, which is cleared first.
+        void Cull(const glm::mat4 & modelViewProj, const glm::vec3 & eye, std::vector<uint32_t> & visible) const;
+
+        size_t Count() const;
+
+    private:
+        size_t count = 0;
+
+        std::vector<float> centerX;
+        std::vector<float> centerY;
+        std::vector<float> centerZ;
+        std::vector<float> radius;
+
+        std::vector<float> apexX;
+        std::vector<float> apexY;
+        std::vector<float> apexZ;
+        std::vector<float> axisX;
+        std::vector<float> axisY;
+        std::vector<float> axisZ;
+        std::vector<float> cutoff;
+    };
+}
+#endif // !CLUSTERCULLER_H
@@ -0,0 +1,132 @@
+#include "geometryPool.h"
+#include "vulkanBuffer.h"
+#include <string.h>
+
+namespace Graphics::Vulkan
+{
+    int32_t GeometryPool::AddVertices(const std::vector<Vertex> & vertices)
+    {
+        const auto offset = vertexData.size();
+        const auto size = vertices.size() * sizeof(Vertex);
+
+        vertexData.resize(offset + size);
+        memcpy(vertexData.data() + offset, vertices.data(), size);
+
+        return (int32_t)(offset / sizeof(Vertex));
+    }
+
+    IndexRange GeometryPool::AddIndices(const IndexData & indices)
+    {
+        const auto stride = indices.Stride();
+        const auto offset = (indexData.size() + stride - 1) / stride * stride;
+
+        indexData.resize(offset + indices.Size());
+        memcpy(indexData.data() + offset, indices.Data(), indices.Size());
+
+        IndexRange range;
+        range.FirstIndex = (uint32_t)(offset / stride);
+        range.IndexCount = (uint32_t)indices.Count();
+        range.Type = indices.Type();
+        return range;
+    }
+
+    void GeometryPool::Clear()
+    {
+        vertexData.clear();
+        indexData.clear();
+    }
+
+    void GeometryPool::Upload(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t * queueIndicies, const CopyFunction & copy)
+    {
+        UploadBuffer(device, physicalDevice, queueIndicies, copy, vertexData,
+            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+            vertexBuffer, vertexBufferMemory, vertexBufferSize);
+
+        UploadBuffer(device, physicalDevice, queueIndicies, copy, indexData,
+            VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+            indexBuffer, indexBufferMemory, indexBufferSize);
+    }
+
+    void GeometryPool::UploadBuffer(
+        VkDevice device,
+        VkPhysicalDevice physicalDevice,
+        uint32_t * queueIndicies,
+        const CopyFunction & copy,
+        const std::vector<uint8_t> & contents,
+        VkBufferUsageFlags usage,
+        VkBuffer & buffer,
+        VkDeviceMemory & memory,
+        VkDeviceSize & capacity)
+    {
+        if (contents.empty())
+        {
+            return;
+        }
+
+        if (contents.size() > capacity)
+        {
+            vkDeviceWaitIdle(device);
+            vkDestroyBuffer(device, buffer, nullptr);
+            vkFreeMemory(device, memory, nullptr);
+
+            CreateBuffer(
+                device,
+                physicalDevice,
+                contents.size(),
+                VK_BUFFER_USAGE_TRANSFER_DST_BIT | usage,
+                VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                queueIndicies,
+                buffer,
+                memory);
+
+            capacity = contents.size();
+        }
+
+        VkBuffer stagingBuffer;
+        VkDeviceMemory stagingMemory;
+
+        CreateBuffer(device,
+            physicalDevice,
+            contents.size(),
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            queueIndicies,
+            stagingBuffer,
+            stagingMemory);
+
+        void * data;
+        vkMapMemory(device, stagingMemory, 0, contents.size(), 0, &data);
+        memcpy(data, contents.data(), contents.size());
+        vkUnmapMemory(device, stagingMemory);
+
+        copy(stagingBuffer, buffer, contents.size());
+
+        vkFreeMemory(device, stagingMemory, nullptr);
+        vkDestroyBuffer(device, stagingBuffer, nullptr);
+    }
+
+    void GeometryPool::Destroy(VkDevice device)
+    {
+        vkDestroyBuffer(device, vertexBuffer, nullptr);
+        vkFreeMemory(device, vertexBufferMemory, nullptr);
+        vkDestroyBuffer(device, indexBuffer, nullptr);
+        vkFreeMemory(device, indexBufferMemory, nullptr);
+
+        vertexBuffer = VK_NULL_HANDLE;
+        vertexBufferMemory = VK_NULL_HANDLE;
+        vertexBufferSize = 0;
+        indexBuffer = VK_NULL_HANDLE;
+        indexBufferMemory = VK_NULL_HANDLE;
+        indexBufferSize = 0;
+    }
+
+    VkBuffer GeometryPool::VertexBuffer() const
+    {
+        return vertexBuffer;
+    }
+
+    VkBuffer GeometryPool::IndexBuffer() const
+    {
+        return indexBuffer;
+    }
+}
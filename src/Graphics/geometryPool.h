@@ -0,0 +1,60 @@
+#ifndef GEOMETRYPOOL_H
+#define GEOMETRYPOOL_H
+#include <functional>
+#include <vector>
+#include "graphics_includes.h"
+#include "vertex.h"
+#include "indexData.h"
+
+namespace Graphics::Vulkan
+{
+    struct IndexRange
+    {
+        uint32_t FirstIndex;
+        uint32_t IndexCount;
+        IndexType Type;
+    };
+
+    // One vertex buffer and one index buffer shared by every mesh and LOD. Ranges are appended on the CPU
+    // and pushed to device local memory in a single copy per buffer. 16 and 32-bit index ranges can live
+    // side by side since each range is aligned to its own stride and addressed through firstIndex.
+    class GeometryPool
+    {
+    public:
+        typedef std::function<void(VkBuffer src, VkBuffer dst, VkDeviceSize size)> CopyFunction;
+
+        int32_t AddVertices(const std::vector<Vertex> & vertices);
+        IndexRange AddIndices(const IndexData & indices);
+        void Clear();
+
+        void Upload(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t * queueIndicies, const CopyFunction & copy);
+        void Destroy(VkDevice device);
+
+        VkBuffer VertexBuffer() const;
+        VkBuffer IndexBuffer() const;
+
+    private:
+        void UploadBuffer(
+            VkDevice device,
+            VkPhysicalDevice physicalDevice,
+            uint32_t * queueIndicies,
+            const CopyFunction & copy,
+            const std::vector<uint8_t> & contents,
+            VkBufferUsageFlags usage,
+            VkBuffer & buffer,
+            VkDeviceMemory & memory,
+            VkDeviceSize & capacity);
+
+        std::vector<uint8_t> vertexData;
+        std::vector<uint8_t> indexData;
+
+        VkBuffer vertexBuffer = VK_NULL_HANDLE;
+        VkDeviceMemory vertexBufferMemory = VK_NULL_HANDLE;
+        VkDeviceSize vertexBufferSize = 0;
+
+        VkBuffer indexBuffer = VK_NULL_HANDLE;
+        VkDeviceMemory indexBufferMemory = VK_NULL_HANDLE;
+        VkDeviceSize indexBufferSize = 0;
+    };
+}
+#endif // !GEOMETRYPOOL_H
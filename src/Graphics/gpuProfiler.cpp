@@ -0,0 +1,267 @@
+#include "gpuProfiler.h"
+#include "../Utils/profiler.h"
+#include <stdexcept>
+
+namespace Graphics::Vulkan
+{
+    namespace
+    {
+        // Results come back in bit order, matching the fields of GpuFrameTimes.
+        const VkQueryPipelineStatisticFlags StatisticFlags =
+            VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+            VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+            VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+            VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+            VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT;
+
+        const uint32_t StatisticCount = 5;
+
+        const char * const CounterNames[(size_t)GpuScope::Count] =
+        {
+            "GPU frame ms",
+            "GPU render pass ms",
+            "GPU draws ms"
+        };
+    }
+
+    GpuProfiler::GpuProfiler(Util::Logging::Logger & logger) :
+        logger(logger)
+    {
+    }
+
+    void GpuProfiler::Init(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t queueFamily, bool pipelineStatistics, uint32_t framesInFlight)
+    {
+        this->device = device;
+        statistics = pipelineStatistics;
+        pendingSlots.assign(framesInFlight, NoSlot);
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+
+        uint32_t familyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, nullptr);
+        std::vector<VkQueueFamilyProperties> families(familyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice, &familyCount, families.data());
+
+        const uint32_t validBits = queueFamily < familyCount ? families[queueFamily].timestampValidBits : 0;
+        timestamps = validBits > 0;
+        timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+        nanosecondsPerTick = properties.limits.timestampPeriod;
+
+        LOG_INFO(logger, Vulkan, "GPU profiling: timestamps {}, pipeline statistics {}", timestamps, statistics);
+    }
+
+    void GpuProfiler::CreatePools(uint32_t slotCount)
+    {
+        Destroy();
+        pendingSlots.assign(pendingSlots.size(), NoSlot);
+
+        if (timestamps)
+        {
+            VkQueryPoolCreateInfo poolInfo = {};
+            poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            poolInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+            poolInfo.queryCount = slotCount * QueriesPerSlot;
+
+            if (vkCreateQueryPool(device, &poolInfo, nullptr, &timestampPool) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create timestamp query pool!");
+            }
+        }
+
+        if (statistics)
+        {
+            VkQueryPoolCreateInfo poolInfo = {};
+            poolInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+            poolInfo.queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS;
+            poolInfo.queryCount = slotCount;
+            poolInfo.pipelineStatistics = StatisticFlags;
+
+            if (vkCreateQueryPool(device, &poolInfo, nullptr, &statisticsPool) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to create pipeline statistics query pool!");
+            }
+        }
+    }
+
+    void GpuProfiler::Destroy()
+    {
+        if (timestampPool != VK_NULL_HANDLE)
+        {
+            vkDestroyQueryPool(device, timestampPool, nullptr);
+            timestampPool = VK_NULL_HANDLE;
+        }
+
+        if (statisticsPool != VK_NULL_HANDLE)
+        {
+            vkDestroyQueryPool(device, statisticsPool, nullptr);
+            statisticsPool = VK_NULL_HANDLE;
+        }
+    }
+
+    void GpuProfiler::Reset(VkCommandBuffer commandBuffer, uint32_t slot)
+    {
+        if (timestampPool != VK_NULL_HANDLE)
+        {
+            vkCmdResetQueryPool(commandBuffer, timestampPool, slot * QueriesPerSlot, QueriesPerSlot);
+        }
+
+        if (statisticsPool != VK_NULL_HANDLE)
+        {
+            vkCmdResetQueryPool(commandBuffer, statisticsPool, slot, 1);
+        }
+    }
+
+    void GpuProfiler::Begin(VkCommandBuffer commandBuffer, uint32_t slot, GpuScope scope)
+    {
+        if (timestampPool != VK_NULL_HANDLE)
+        {
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, timestampPool, slot * QueriesPerSlot + 2 * (uint32_t)scope);
+        }
+    }
+
+    void GpuProfiler::End(VkCommandBuffer commandBuffer, uint32_t slot, GpuScope scope)
+    {
+        if (timestampPool != VK_NULL_HANDLE)
+        {
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, timestampPool, slot * QueriesPerSlot + 2 * (uint32_t)scope + 1);
+        }
+    }
+
+    void GpuProfiler::BeginStatistics(VkCommandBuffer commandBuffer, uint32_t slot)
+    {
+        if (statisticsPool != VK_NULL_HANDLE)
+        {
+            vkCmdBeginQuery(commandBuffer, statisticsPool, slot, 0);
+        }
+    }
+
+    void GpuProfiler::EndStatistics(VkCommandBuffer commandBuffer, uint32_t slot)
+    {
+        if (statisticsPool != VK_NULL_HANDLE)
+        {
+            vkCmdEndQuery(commandBuffer, statisticsPool, slot);
+        }
+    }
+
+    void GpuProfiler::Collect(uint32_t frame)
+    {
+        const uint32_t slot = pendingSlots[frame];
+        pendingSlots[frame] = NoSlot;
+
+        if (slot == NoSlot || (!timestamps && !statistics))
+        {
+            return;
+        }
+
+        // No wait flag: the fence has signalled, but the same image may already have been submitted
+        // again by the other frame and reset its queries, in which case this sample is dropped.
+        GpuFrameTimes times;
+
+        if (timestampPool != VK_NULL_HANDLE)
+        {
+            uint64_t values[QueriesPerSlot];
+
+            if (vkGetQueryPoolResults(device, timestampPool, slot * QueriesPerSlot, QueriesPerSlot, sizeof(values), values,
+                sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+            {
+                notReady++;
+                return;
+            }
+
+            for (uint32_t scope = 0; scope < (uint32_t)GpuScope::Count; scope++)
+            {
+                const uint64_t ticks = (values[2 * scope + 1] - values[2 * scope]) & timestampMask;
+                times.Milliseconds[scope] = ticks * nanosecondsPerTick / 1000000.0;
+            }
+        }
+
+        if (statisticsPool != VK_NULL_HANDLE)
+        {
+            uint64_t values[StatisticCount];
+
+            if (vkGetQueryPoolResults(device, statisticsPool, slot, 1, sizeof(values), values,
+                sizeof(values), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS)
+            {
+                notReady++;
+                return;
+            }
+
+            times.Vertices = values[0];
+            times.Primitives = values[1];
+            times.VertexInvocations = values[2];
+            times.ClippedPrimitives = values[3];
+            times.FragmentInvocations = values[4];
+        }
+
+        last = times;
+        frames++;
+
+        for (size_t scope = 0; scope < (size_t)GpuScope::Count; scope++)
+        {
+            totals.Milliseconds[scope] += times.Milliseconds[scope];
+        }
+
+        totals.Vertices += times.Vertices;
+        totals.Primitives += times.Primitives;
+        totals.VertexInvocations += times.VertexInvocations;
+        totals.ClippedPrimitives += times.ClippedPrimitives;
+        totals.FragmentInvocations += times.FragmentInvocations;
+
+        if (Util::Profiling::Profiler::Enabled())
+        {
+            if (timestamps)
+            {
+                for (size_t scope = 0; scope < (size_t)GpuScope::Count; scope++)
+                {
+                    Util::Profiling::Profiler::Counter(CounterNames[scope], times.Milliseconds[scope]);
+                }
+            }
+
+            if (statistics)
+            {
+                Util::Profiling::Profiler::Counter("GPU primitives", (double)times.Primitives);
+                Util::Profiling::Profiler::Counter("GPU fragment invocations", (double)times.FragmentInvocations);
+            }
+        }
+    }
+
+    void GpuProfiler::Submitted(uint32_t frame, uint32_t slot)
+    {
+        pendingSlots[frame] = slot;
+    }
+
+    GpuFrameTimes GpuProfiler::Last() const
+    {
+        return last;
+    }
+
+    void GpuProfiler::Summarize()
+    {
+        if (frames == 0)
+        {
+            LOG_INFO(logger, Vulkan, "GPU profiling: no frames read back, {} not ready", notReady);
+            return;
+        }
+
+        if (timestamps)
+        {
+            LOG_INFO(logger, Vulkan, "GPU times over {} frames: frame {} ms, render pass {} ms, draws {} ms on average, {} not ready",
+                frames,
+                totals.Milliseconds[(size_t)GpuScope::Frame] / frames,
+                totals.Milliseconds[(size_t)GpuScope::RenderPass] / frames,
+                totals.Milliseconds[(size_t)GpuScope::Draws] / frames,
+                notReady);
+        }
+
+        if (statistics)
+        {
+            LOG_INFO(logger, Vulkan, "GPU statistics per frame: {} vertices, {} primitives, {} vertex invocations, {} clipped primitives, {} fragment invocations",
+                totals.Vertices / frames,
+                totals.Primitives / frames,
+                totals.VertexInvocations / frames,
+                totals.ClippedPrimitives / frames,
+                totals.FragmentInvocations / frames);
+        }
+    }
+}
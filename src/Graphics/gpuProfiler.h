@@ -0,0 +1,87 @@
+#ifndef GPUPROFILER_H
+#define GPUPROFILER_H
+#include "graphics_includes.h"
+#include "../Utils/logger.h"
+#include <stdint.h>
+#include <vector>
+
+namespace Graphics::Vulkan
+{
+    enum class GpuScope : uint32_t
+    {
+        Frame,
+        RenderPass,
+        Draws,
+        Count
+    };
+
+    struct GpuFrameTimes
+    {
+        double Milliseconds[(size_t)GpuScope::Count] = {};
+
+        // Left at 0 when the device has no pipeline statistics queries.
+        uint64_t Vertices = 0;
+        uint64_t Primitives = 0;
+        uint64_t VertexInvocations = 0;
+        uint64_t ClippedPrimitives = 0;
+        uint64_t FragmentInvocations = 0;
+    };
+
+    // Timestamp and pipeline statistics queries for the render command buffers. Those are recorded
+    // once per swapchain image, so every image gets its own slot of queries, reset at the start of
+    // its command buffer. Results are read back for the image a frame in flight submitted once that
+    // frame's fence has been waited on, without waiting on the queries themselves, and fed to the
+    // CPU profiler as counters while it's recording.
+    class GpuProfiler
+    {
+    public:
+        explicit GpuProfiler(Util::Logging::Logger & logger);
+
+        // Timestamps are skipped when the queue family has no valid timestamp bits, statistics
+        // unless the pipelineStatisticsQuery feature was enabled on the device.
+        void Init(VkDevice device, VkPhysicalDevice physicalDevice, uint32_t queueFamily, bool pipelineStatistics, uint32_t framesInFlight);
+
+        // Recreates the query pools, the device must be idle.
+        void CreatePools(uint32_t slotCount);
+        void Destroy();
+
+        // Reset goes first in the slot's command buffer, outside a render pass. Statistics can't
+        // span subpasses, so they're begun and ended outside the render pass as well.
+        void Reset(VkCommandBuffer commandBuffer, uint32_t slot);
+        void Begin(VkCommandBuffer commandBuffer, uint32_t slot, GpuScope scope);
+        void End(VkCommandBuffer commandBuffer, uint32_t slot, GpuScope scope);
+        void BeginStatistics(VkCommandBuffer commandBuffer, uint32_t slot);
+        void EndStatistics(VkCommandBuffer commandBuffer, uint32_t slot);
+
+        // Collect after waiting on the frame's fence, Submitted after submitting the slot with it.
+        void Collect(uint32_t frame);
+        void Submitted(uint32_t frame, uint32_t slot);
+
+        GpuFrameTimes Last() const;
+
+        // Logs the averages over every frame read back.
+        void Summarize();
+
+    private:
+        static constexpr uint32_t QueriesPerSlot = 2 * (uint32_t)GpuScope::Count;
+        static constexpr uint32_t NoSlot = UINT32_MAX;
+
+        Util::Logging::Logger & logger;
+
+        VkDevice device = VK_NULL_HANDLE;
+        VkQueryPool timestampPool = VK_NULL_HANDLE;
+        VkQueryPool statisticsPool = VK_NULL_HANDLE;
+        bool timestamps = false;
+        bool statistics = false;
+        uint64_t timestampMask = 0;
+        double nanosecondsPerTick = 0.0;
+
+        std::vector<uint32_t> pendingSlots;
+
+        GpuFrameTimes last;
+        GpuFrameTimes totals;
+        uint64_t frames = 0;
+        uint64_t notReady = 0;
+    };
+}
+#endif // !GPUPROFILER_H
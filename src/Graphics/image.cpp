@@ -1,20 +1,159 @@
 #include "image.h"
+#include "pixelConvert.h"
+#include "../Utils/mappedFile.h"
+#include <stdlib.h>
+#include <string.h>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+
+namespace Graphics
+{
+    namespace
+    {
+        // Bump allocator for stb_image's working memory. Freeing is a no-op, everything is dropped at once
+        // after each image, and the blocks are kept so a worker stops allocating after its first few decodes.
+        class DecodeArena
+        {
+        public:
+            // Each allocation is preceded by its size, stb_image's realloc doesn't always pass the old one.
+            void * Allocate(size_t size)
+            {
+                const size_t total = Alignment + ((size + Alignment - 1) & ~(Alignment - 1));
+
+                if (blocks.empty() || blocks.back().Used + total > blocks.back().Size)
+                {
+                    const size_t previous = blocks.empty() ? 0 : blocks.back().Size;
+                    size_t blockSize = previous * 2 > MinimumBlock ? previous * 2 : MinimumBlock;
+                    blockSize = blockSize > total ? blockSize : total;
+
+                    blocks.push_back({ std::unique_ptr<uint8_t[]>(new uint8_t[blockSize]), blockSize, 0 });
+                }
+
+                auto & block = blocks.back();
+                auto header = block.Memory.get() + block.Used;
+                block.Used += total;
+
+                *(size_t *)header = size;
+                last = header + Alignment;
+                return last;
+            }
+
+            void * Reallocate(void * p, size_t newSize)
+            {
+                if (p == nullptr)
+                {
+                    return Allocate(newSize);
+                }
+
+                auto header = (uint8_t *)p - Alignment;
+                const size_t oldSize = *(size_t *)header;
+
+                // The zlib output buffer is grown over and over, extend it in place when it was the last allocation.
+                auto & block = blocks.back();
+                const size_t end = (header - block.Memory.get()) + Alignment + ((newSize + Alignment - 1) & ~(Alignment - 1));
+
+                if (p == last && end <= block.Size)
+                {
+                    block.Used = end;
+                    *(size_t *)header = newSize;
+                    return p;
+                }
+
+                void * moved = Allocate(newSize);
+                memcpy(moved, p, oldSize < newSize ? oldSize : newSize);
+                return moved;
+            }
+
+            void Reset()
+            {
+                // Merge into one block big enough for the last image so the next one fits without growing.
+                if (blocks.size() > 1)
+                {
+                    size_t total = 0;
+
+                    for (const auto & block : blocks)
+                    {
+                        total += block.Size;
+                    }
+
+                    blocks.clear();
+                    blocks.push_back({ std::unique_ptr<uint8_t[]>(new uint8_t[total]), total, 0 });
+                }
+                else if (!blocks.empty())
+                {
+                    blocks.back().Used = 0;
+                }
+
+                last = nullptr;
+            }
+
+        private:
+            struct Block
+            {
+                std::unique_ptr<uint8_t[]> Memory;
+                size_t Size;
+                size_t Used;
+            };
+
+            static const size_t Alignment = 16;
+            static const size_t MinimumBlock = 1 << 20;
+
+            std::vector<Block> blocks;
+            void * last = nullptr;
+        };
+
+        thread_local DecodeArena * activeArena = nullptr;
+
+        void * StbMalloc(size_t size)
+        {
+            return activeArena != nullptr ? activeArena->Allocate(size) : malloc(size);
+        }
+
+        void * StbRealloc(void * p, size_t newSize)
+        {
+            return activeArena != nullptr ? activeArena->Reallocate(p, newSize) : realloc(p, newSize);
+        }
+
+        void StbFree(void * p)
+        {
+            if (activeArena == nullptr)
+            {
+                free(p);
+            }
+        }
+    }
+}
+
+#define STBI_MALLOC(size) Graphics::StbMalloc(size)
+#define STBI_REALLOC(p, newSize) Graphics::StbRealloc(p, newSize)
+#define STBI_FREE(p) Graphics::StbFree(p)
+// The failure reason is a plain global, and decodes run on several threads at once.
+#define STBI_NO_FAILURE_STRINGS
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
 namespace Graphics
 {
+    uint64_t ImageHeader::Size() const
+    {
+        return (uint64_t)Width * Height * Channels;
+    }
+
     Image * Image::Open(const std::string &path)
     {
+        Util::IO::MappedFile file(path);
+
         int x, y, c;
 
         auto img = new Image();
 
-        img->data = stbi_load(path.c_str(), &x, &y, &c, 4);
+        img->data = stbi_load_from_memory(file.Data(), (int)file.Size(), &x, &y, &c, 4);
 
         if (img->data == nullptr)
         {
-            throw new std::runtime_error("Could not load image");
+            delete img;
+            throw std::runtime_error("Could not load image " + path);
         }
 
         img->width = (uint32_t)x;
@@ -23,6 +162,67 @@ namespace Graphics
         return img;
     }
 
+    bool Image::ReadHeader(const uint8_t * encoded, size_t size, ImageHeader & header)
+    {
+        int x, y, c;
+
+        if (!stbi_info_from_memory(encoded, (int)size, &x, &y, &c))
+        {
+            return false;
+        }
+
+        header.Width = (uint32_t)x;
+        header.Height = (uint32_t)y;
+        header.Channels = 4;
+        return true;
+    }
+
+    void Image::Decode(const uint8_t * encoded, size_t size, uint8_t * destination, size_t rowPitch)
+    {
+        thread_local DecodeArena arena;
+
+        struct ArenaScope
+        {
+            ArenaScope(DecodeArena & arena) { activeArena = &arena; }
+            ~ArenaScope() { activeArena->Reset(); activeArena = nullptr; }
+        } scope(arena);
+
+        // Decoded with the file's own channels; RGB, the common case, is widened by the SIMD kernel
+        // while copying out instead of by stb_image's per pixel loop.
+        int x, y, c;
+        auto pixels = stbi_load_from_memory(encoded, (int)size, &x, &y, &c, 0);
+
+        if (pixels == nullptr)
+        {
+            throw std::runtime_error("Could not decode image");
+        }
+
+        if (c != 3 && c != 4)
+        {
+            pixels = stbi__convert_format(pixels, c, 4, (unsigned int)x, (unsigned int)y);
+            c = 4;
+
+            if (pixels == nullptr)
+            {
+                throw std::runtime_error("Could not convert image");
+            }
+        }
+
+        const size_t rowSize = (size_t)x * c;
+
+        for (int row = 0; row < y; row++)
+        {
+            if (c == 3)
+            {
+                PixelConvert::RgbToRgba(pixels + row * rowSize, destination + row * rowPitch, (size_t)x);
+            }
+            else
+            {
+                memcpy(destination + row * rowPitch, pixels + row * rowSize, rowSize);
+            }
+        }
+    }
+
     Image::~Image()
     {
         if (data != nullptr)
@@ -53,6 +253,6 @@ namespace Graphics
 
     uint64_t Image::Size()
     {
-        return width * height * channels;
+        return (uint64_t)width * height * channels;
     }
-}
\ No newline at end of file
+}
@@ -1,10 +1,22 @@
 #ifndef IMAGE_H
 #define IMAGE_H
+#include <stddef.h>
 #include <stdint.h>
 #include <string>
 
 namespace Graphics
 {
+    struct ImageHeader
+    {
+        uint32_t Width;
+        uint32_t Height;
+
+        // Channels after decoding, images are always expanded to RGBA.
+        uint8_t Channels;
+
+        uint64_t Size() const;
+    };
+
     class Image
     {
     private:
@@ -24,6 +36,14 @@ namespace Graphics
         uint64_t Size();
 
         static Image * Open(const std::string & path);
+
+        // Parses only the header of an encoded image, returns false if the format isn't recognised.
+        static bool ReadHeader(const uint8_t * encoded, size_t size, ImageHeader & header);
+
+        // Decodes into caller owned memory, e.g. a mapped staging buffer, rowPitch bytes apart.
+        // Decoder scratch comes from a per-thread arena that is reused between images.
+        static void Decode(const uint8_t * encoded, size_t size, uint8_t * destination, size_t rowPitch);
+
         ~Image();
     };
 }
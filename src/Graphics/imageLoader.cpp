@@ -0,0 +1,194 @@
+#include "imageLoader.h"
+#include "../Utils/mappedFile.h"
+#include "../Utils/profiler.h"
+#include <memory>
+#include <stdexcept>
+
+namespace Graphics
+{
+    double ImageLoaderStats::ImagesPerSecond() const
+    {
+        return WallSeconds > 0.0 ? Images / WallSeconds : 0.0;
+    }
+
+    ImageLoader::ImageLoader(Util::Threading::ThreadPool * pool, uint64_t memoryBudget) :
+        pool(pool),
+        memoryBudget(memoryBudget)
+    {
+    }
+
+    std::future<ImageHeader> ImageLoader::Load(const std::string & path, DestinationFunction destination)
+    {
+        {
+            std::lock_guard<std::mutex> lock(statsMutex);
+            if (!started)
+            {
+                started = true;
+                firstLoad = std::chrono::steady_clock::now();
+            }
+        }
+
+        uint64_t ticket;
+
+        {
+            std::lock_guard<std::mutex> lock(budgetMutex);
+            ticket = nextTicket++;
+        }
+
+        auto promise = std::make_shared<std::promise<ImageHeader>>();
+        auto future = promise->get_future();
+
+        pool->Submit([this, path, ticket, destination, promise]()
+        {
+            try
+            {
+                ImageHeader header;
+                Decode(path, ticket, destination, header);
+                promise->set_value(header);
+            }
+            catch (...)
+            {
+                promise->set_exception(std::current_exception());
+            }
+        });
+
+        return future;
+    }
+
+    void ImageLoader::Decode(const std::string & path, uint64_t ticket, const DestinationFunction & destination, ImageHeader & header)
+    {
+        PROFILE_ZONE("Decode image");
+        const auto start = std::chrono::steady_clock::now();
+
+        std::unique_ptr<Util::IO::MappedFile> file;
+
+        try
+        {
+            file = std::make_unique<Util::IO::MappedFile>(path);
+
+            if (!Image::ReadHeader(file->Data(), file->Size(), header))
+            {
+                throw std::runtime_error("Unrecognised image format: " + path);
+            }
+        }
+        catch (...)
+        {
+            // Still take the turn, later loads wait for it.
+            Acquire(ticket, 0);
+            throw;
+        }
+
+        auto pixels = destination(header, Acquire(ticket, header.Size()));
+
+        try
+        {
+            Image::Decode(file->Data(), file->Size(), pixels, (size_t)header.Width * header.Channels);
+        }
+        catch (const std::runtime_error & e)
+        {
+            throw std::runtime_error(std::string(e.what()) + ": " + path);
+        }
+
+        const auto end = std::chrono::steady_clock::now();
+
+        std::lock_guard<std::mutex> lock(statsMutex);
+        images++;
+        decodedBytes += header.Size();
+        workerSeconds += std::chrono::duration<double>(end - start).count();
+        lastCompletion = end;
+    }
+
+    ImageLoader::Reservation ImageLoader::Acquire(uint64_t ticket, uint64_t bytes)
+    {
+        // Without workers every decode runs on the caller, which is also the only one who can free memory.
+        const bool wait = pool->ThreadCount() > 0;
+
+        {
+            std::unique_lock<std::mutex> lock(budgetMutex);
+            budgetAvailable.wait(lock, [this, ticket, bytes, wait]()
+            {
+                return !wait || (admitted == ticket && (inFlight == 0 || inFlight + bytes <= memoryBudget));
+            });
+
+            inFlight += bytes;
+            admitted++;
+        }
+
+        budgetAvailable.notify_all();
+        return Reservation(this, bytes);
+    }
+
+    void ImageLoader::Release(uint64_t bytes)
+    {
+        {
+            std::lock_guard<std::mutex> lock(budgetMutex);
+            inFlight -= bytes;
+        }
+
+        budgetAvailable.notify_all();
+    }
+
+    ImageLoader::Reservation::Reservation(ImageLoader * loader, uint64_t bytes) :
+        loader(loader),
+        bytes(bytes)
+    {
+    }
+
+    ImageLoader::Reservation::Reservation(Reservation && other) noexcept :
+        loader(other.loader),
+        bytes(other.bytes)
+    {
+        other.loader = nullptr;
+        other.bytes = 0;
+    }
+
+    ImageLoader::Reservation & ImageLoader::Reservation::operator=(Reservation && other) noexcept
+    {
+        if (this != &other)
+        {
+            Reset();
+            loader = other.loader;
+            bytes = other.bytes;
+            other.loader = nullptr;
+            other.bytes = 0;
+        }
+
+        return *this;
+    }
+
+    ImageLoader::Reservation::~Reservation()
+    {
+        Reset();
+    }
+
+    void ImageLoader::Reservation::Reset()
+    {
+        if (loader)
+        {
+            loader->Release(bytes);
+            loader = nullptr;
+            bytes = 0;
+        }
+    }
+
+    ImageLoaderStats ImageLoader::Stats() const
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+
+        ImageLoaderStats stats;
+        stats.Images = images;
+        stats.DecodedBytes = decodedBytes;
+        stats.WorkerSeconds = workerSeconds;
+        stats.WallSeconds = images > 0 ? std::chrono::duration<double>(lastCompletion - firstLoad).count() : 0.0;
+        return stats;
+    }
+
+    void ImageLoader::ResetStats()
+    {
+        std::lock_guard<std::mutex> lock(statsMutex);
+        images = 0;
+        decodedBytes = 0;
+        workerSeconds = 0.0;
+        started = false;
+    }
+}
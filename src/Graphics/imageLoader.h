@@ -0,0 +1,90 @@
+#ifndef IMAGELOADER_H
+#define IMAGELOADER_H
+#include <stdint.h>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <string>
+#include "image.h"
+#include "../Utils/threadPool.h"
+
+namespace Graphics
+{
+    struct ImageLoaderStats
+    {
+        uint64_t Images;
+        uint64_t DecodedBytes;
+
+        // Time from the first Load to the last completion, and the sum of time spent on workers.
+        double WallSeconds;
+        double WorkerSeconds;
+
+        double ImagesPerSecond() const;
+    };
+
+    // Decodes images on a thread pool straight into caller provided memory. Files are memory mapped and
+    // at most memoryBudget bytes of decoded pixels are alive at once, counted until the caller frees them;
+    // a single image larger than the budget still goes through once nothing else is held.
+    // Loads are admitted in the order they were made, so callers must free pixels in that order too.
+    class ImageLoader
+    {
+    public:
+        // Keeps an image's bytes counted against the budget until destroyed, store it with the pixels.
+        class Reservation
+        {
+        public:
+            Reservation() = default;
+            Reservation(Reservation && other) noexcept;
+            Reservation & operator=(Reservation && other) noexcept;
+            ~Reservation();
+
+            Reservation(const Reservation &) = delete;
+            Reservation & operator=(const Reservation &) = delete;
+
+            void Reset();
+
+        private:
+            friend class ImageLoader;
+            Reservation(ImageLoader * loader, uint64_t bytes);
+
+            ImageLoader * loader = nullptr;
+            uint64_t bytes = 0;
+        };
+
+        // Called on a worker once the image size is known; must return Size() writable bytes for the pixels
+        // and keep the reservation for as long as they live.
+        typedef std::function<uint8_t *(const ImageHeader & header, Reservation reservation)> DestinationFunction;
+
+        ImageLoader(Util::Threading::ThreadPool * pool, uint64_t memoryBudget);
+
+        std::future<ImageHeader> Load(const std::string & path, DestinationFunction destination);
+
+        ImageLoaderStats Stats() const;
+        void ResetStats();
+
+    private:
+        void Decode(const std::string & path, uint64_t ticket, const DestinationFunction & destination, ImageHeader & header);
+        Reservation Acquire(uint64_t ticket, uint64_t bytes);
+        void Release(uint64_t bytes);
+
+        Util::Threading::ThreadPool * pool;
+        uint64_t memoryBudget;
+
+        std::mutex budgetMutex;
+        std::condition_variable budgetAvailable;
+        uint64_t inFlight = 0;
+        uint64_t nextTicket = 0;
+        uint64_t admitted = 0;
+
+        mutable std::mutex statsMutex;
+        uint64_t images = 0;
+        uint64_t decodedBytes = 0;
+        double workerSeconds = 0.0;
+        bool started = false;
+        std::chrono::steady_clock::time_point firstLoad;
+        std::chrono::steady_clock::time_point lastCompletion;
+    };
+}
+#endif // !IMAGELOADER_H
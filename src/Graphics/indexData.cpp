@@ -0,0 +1,55 @@
+#include "indexData.h"
+#include <string.h>
+
+namespace Graphics
+{
+    IndexData::IndexData() : type(IndexType::UInt32), count(0)
+    {
+    }
+
+    IndexData::IndexData(const std::vector<uint32_t> & indices, size_t vertexCount) : count(indices.size())
+    {
+        if (Fits16Bit(vertexCount))
+        {
+            type = IndexType::UInt16;
+            bytes.resize(count * sizeof(uint16_t));
+
+            auto packed = reinterpret_cast<uint16_t *>(bytes.data());
+            for (size_t i = 0; i < count; i++)
+            {
+                packed[i] = (uint16_t)indices[i];
+            }
+        }
+        else
+        {
+            type = IndexType::UInt32;
+            bytes.resize(count * sizeof(uint32_t));
+            memcpy(bytes.data(), indices.data(), bytes.size());
+        }
+    }
+
+    IndexType IndexData::Type() const
+    {
+        return type;
+    }
+
+    uint32_t IndexData::Stride() const
+    {
+        return type == IndexType::UInt16 ? sizeof(uint16_t) : sizeof(uint32_t);
+    }
+
+    size_t IndexData::Count() const
+    {
+        return count;
+    }
+
+    size_t IndexData::Size() const
+    {
+        return bytes.size();
+    }
+
+    const uint8_t * IndexData::Data() const
+    {
+        return bytes.data();
+    }
+}
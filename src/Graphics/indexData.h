@@ -0,0 +1,40 @@
+#ifndef INDEXDATA_H
+#define INDEXDATA_H
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace Graphics
+{
+    enum class IndexType
+    {
+        UInt16,
+        UInt32
+    };
+
+    // Index buffer contents packed to the narrowest type that can address the mesh.
+    class IndexData
+    {
+    public:
+        IndexData();
+        IndexData(const std::vector<uint32_t> & indices, size_t vertexCount);
+
+        IndexType Type() const;
+        uint32_t Stride() const;
+        size_t Count() const;
+        size_t Size() const;
+        const uint8_t * Data() const;
+
+        // Primitive restart is disabled, so 0xFFFF is an ordinary index.
+        static bool Fits16Bit(size_t vertexCount)
+        {
+            return vertexCount <= 0x10000;
+        }
+
+    private:
+        IndexType type;
+        size_t count;
+        std::vector<uint8_t> bytes;
+    };
+}
+#endif // !INDEXDATA_H
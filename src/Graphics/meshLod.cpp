@@ -0,0 +1,104 @@
+#include "meshLod.h"
+#include "meshOptimizer.h"
+#include "meshSimplifier.h"
+#include <algorithm>
+
+namespace Graphics
+{
+    BoundingSphere BoundingSphere::FromVertices(const std::vector<Vertex> & vertices)
+    {
+        BoundingSphere sphere = { glm::vec3(0.0f), 0.0f };
+
+        if (vertices.empty())
+        {
+            return sphere;
+        }
+
+        glm::vec3 minimum = vertices[0].position;
+        glm::vec3 maximum = vertices[0].position;
+
+        for (const auto & vertex : vertices)
+        {
+            minimum = glm::min(minimum, vertex.position);
+            maximum = glm::max(maximum, vertex.position);
+        }
+
+        sphere.Center = (minimum + maximum) * 0.5f;
+
+        for (const auto & vertex : vertices)
+        {
+            sphere.Radius = std::max(sphere.Radius, glm::length(vertex.position - sphere.Center));
+        }
+
+        return sphere;
+    }
+
+    std::vector<MeshLod> LodChain::Build(const std::vector<Vertex> & vertices, const std::vector<uint32_t> & indices)
+    {
+        std::vector<MeshLod> lods;
+        lods.push_back({ indices, 0.0f });
+
+        const float errorLimit = BoundingSphere::FromVertices(vertices).Radius * 0.25f;
+
+        while (lods.size() < MaxLods)
+        {
+            const auto & previous = lods.back();
+            const size_t target = previous.Indices.size() / 2 / 3 * 3;
+
+            if (target < 3)
+            {
+                break;
+            }
+
+            float error = 0.0f;
+            auto simplified = MeshSimplifier::Simplify(vertices, previous.Indices, target, errorLimit, &error);
+
+            if (simplified.empty() || simplified.size() * 100 > previous.Indices.size() * 85)
+            {
+                break;
+            }
+
+            MeshOptimizer::OptimizeVertexCache(simplified, vertices.size());
+
+            // Each level is simplified from the previous one, so deviations accumulate.
+            lods.push_back({ std::move(simplified), previous.Error + error });
+        }
+
+        return lods;
+    }
+
+    size_t LodChain::Select(
+        const std::vector<float> & errors,
+        const BoundingSphere & bounds,
+        const glm::mat4 & modelView,
+        const glm::mat4 & proj,
+        float viewportHeight,
+        float pixelThreshold)
+    {
+        const auto center = glm::vec3(modelView * glm::vec4(bounds.Center, 1.0f));
+
+        const float scale = std::max(
+            glm::length(glm::vec3(modelView[0])),
+            std::max(glm::length(glm::vec3(modelView[1])), glm::length(glm::vec3(modelView[2]))));
+
+        // The camera looks down -z; anything touching the near side of the sphere gets full detail.
+        const float distance = -center.z - bounds.Radius * scale;
+
+        if (distance <= 0.0f)
+        {
+            return 0;
+        }
+
+        const float pixelsPerUnit = fabsf(proj[1][1]) * 0.5f * viewportHeight / distance;
+
+        for (size_t lod = errors.size(); lod > 0; lod--)
+        {
+            if (errors[lod - 1] * scale * pixelsPerUnit <= pixelThreshold)
+            {
+                return lod - 1;
+            }
+        }
+
+        return 0;
+    }
+}
@@ -0,0 +1,43 @@
+#ifndef MESHLOD_H
+#define MESHLOD_H
+#include <stdint.h>
+#include <vector>
+#include "vertex.h"
+
+namespace Graphics
+{
+    struct BoundingSphere
+    {
+        glm::vec3 Center;
+        float Radius;
+
+        static BoundingSphere FromVertices(const std::vector<Vertex> & vertices);
+    };
+
+    struct MeshLod
+    {
+        std::vector<uint32_t> Indices;
+
+        // Object space distance the simplified surface may deviate from the full detail mesh.
+        float Error;
+    };
+
+    class LodChain
+    {
+    public:
+        // Builds successively halved index buffers over the shared vertex buffer, LOD 0 being the input.
+        static std::vector<MeshLod> Build(const std::vector<Vertex> & vertices, const std::vector<uint32_t> & indices);
+
+        // Picks the coarsest LOD whose error projects to at most pixelThreshold pixels on screen.
+        static size_t Select(
+            const std::vector<float> & errors,
+            const BoundingSphere & bounds,
+            const glm::mat4 & modelView,
+            const glm::mat4 & proj,
+            float viewportHeight,
+            float pixelThreshold);
+
+        static const size_t MaxLods = 6;
+    };
+}
+#endif // !MESHLOD_H
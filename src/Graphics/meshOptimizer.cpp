@@ -0,0 +1,455 @@
+#include "meshOptimizer.h"
+#include <algorithm>
+#include <math.h>
+
+namespace Graphics
+{
+    const uint32_t ForsythCacheSize = 32;
+    const uint32_t ForsythMaxValence = 64;
+    const float ForsythCacheDecayPower = 1.5f;
+    const float ForsythLastTriangleScore = 0.75f;
+    const float ForsythValenceBoostScale = 2.0f;
+    const float ForsythValenceBoostPower = 0.5f;
+
+    class ForsythScoreTable
+    {
+    public:
+        ForsythScoreTable()
+        {
+            for (uint32_t i = 0; i < ForsythCacheSize; i++)
+            {
+                if (i < 3)
+                {
+                    cacheScore[i] = ForsythLastTriangleScore;
+                }
+                else
+                {
+                    const float scaler = 1.0f / (ForsythCacheSize - 3);
+                    cacheScore[i] = powf(1.0f - (i - 3) * scaler, ForsythCacheDecayPower);
+                }
+            }
+
+            valenceScore[0] = 0.0f;
+            for (uint32_t i = 1; i < ForsythMaxValence; i++)
+            {
+                valenceScore[i] = ForsythValenceBoostScale * powf((float)i, -ForsythValenceBoostPower);
+            }
+        }
+
+        float Score(int32_t cachePosition, uint32_t remainingTriangles) const
+        {
+            if (remainingTriangles == 0)
+            {
+                return -1.0f;
+            }
+
+            float score = cachePosition >= 0 ? cacheScore[cachePosition] : 0.0f;
+
+            if (remainingTriangles < ForsythMaxValence)
+            {
+                score += valenceScore[remainingTriangles];
+            }
+            else
+            {
+                score += ForsythValenceBoostScale * powf((float)remainingTriangles, -ForsythValenceBoostPower);
+            }
+
+            return score;
+        }
+
+    private:
+        float cacheScore[ForsythCacheSize];
+        float valenceScore[ForsythMaxValence];
+    };
+
+    // FIFO post-transform cache model, returns the number of misses for one triangle.
+    class FifoCacheSimulator
+    {
+    public:
+        FifoCacheSimulator(size_t vertexCount, uint32_t cacheSize) :
+            timestamps(vertexCount, 0),
+            cacheSize(cacheSize),
+            timestamp(cacheSize + 1)
+        {
+        }
+
+        uint32_t Triangle(const uint32_t * tri)
+        {
+            uint32_t misses = 0;
+
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                if (timestamp - timestamps[tri[k]] > cacheSize)
+                {
+                    timestamps[tri[k]] = timestamp++;
+                    misses++;
+                }
+            }
+
+            return misses;
+        }
+
+        void Flush()
+        {
+            timestamp += cacheSize + 1;
+        }
+
+    private:
+        std::vector<uint32_t> timestamps;
+        uint32_t cacheSize;
+        uint32_t timestamp;
+    };
+
+    void MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t> & indices, size_t vertexCount)
+    {
+        const size_t triangleCount = indices.size() / 3;
+
+        if (triangleCount == 0)
+        {
+            return;
+        }
+
+        static const ForsythScoreTable scores;
+
+        std::vector<uint32_t> remaining(vertexCount, 0);
+        for (const auto index : indices)
+        {
+            remaining[index]++;
+        }
+
+        std::vector<uint32_t> offsets(vertexCount + 1, 0);
+        for (size_t v = 0; v < vertexCount; v++)
+        {
+            offsets[v + 1] = offsets[v] + remaining[v];
+        }
+
+        std::vector<uint32_t> adjacency(triangleCount * 3);
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            for (size_t k = 0; k < 3; k++)
+            {
+                adjacency[fill[indices[t * 3 + k]]++] = (uint32_t)t;
+            }
+        }
+
+        std::vector<int32_t> cachePosition(vertexCount, -1);
+        std::vector<float> vertexScore(vertexCount);
+        for (size_t v = 0; v < vertexCount; v++)
+        {
+            vertexScore[v] = scores.Score(-1, remaining[v]);
+        }
+
+        std::vector<float> triangleScore(triangleCount);
+        std::vector<bool> emitted(triangleCount, false);
+
+        int64_t best = 0;
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            triangleScore[t] =
+                vertexScore[indices[t * 3 + 0]] +
+                vertexScore[indices[t * 3 + 1]] +
+                vertexScore[indices[t * 3 + 2]];
+
+            if (triangleScore[t] > triangleScore[best])
+            {
+                best = t;
+            }
+        }
+
+        std::vector<uint32_t> output;
+        output.reserve(indices.size());
+
+        std::vector<uint32_t> cache;
+        std::vector<uint32_t> newCache;
+        cache.reserve(ForsythCacheSize + 3);
+        newCache.reserve(ForsythCacheSize + 3);
+
+        size_t scanCursor = 0;
+
+        while (best >= 0)
+        {
+            const uint32_t * tri = &indices[best * 3];
+            emitted[best] = true;
+            output.insert(output.end(), tri, tri + 3);
+
+            newCache.clear();
+            for (size_t k = 0; k < 3; k++)
+            {
+                const auto v = tri[k];
+
+                if (std::find(newCache.begin(), newCache.end(), v) != newCache.end())
+                {
+                    continue;
+                }
+
+                newCache.push_back(v);
+
+                // A degenerate triangle lists the same vertex twice, so every entry has to go.
+                auto begin = adjacency.begin() + offsets[v];
+                auto end = begin + remaining[v];
+                auto it = std::find(begin, end, (uint32_t)best);
+                while (it != end)
+                {
+                    std::iter_swap(it, --end);
+                    remaining[v]--;
+                    it = std::find(it, end, (uint32_t)best);
+                }
+            }
+
+            for (const auto v : cache)
+            {
+                if (v != tri[0] && v != tri[1] && v != tri[2])
+                {
+                    newCache.push_back(v);
+                }
+            }
+
+            for (size_t i = 0; i < newCache.size(); i++)
+            {
+                const auto v = newCache[i];
+                cachePosition[v] = i < ForsythCacheSize ? (int32_t)i : -1;
+                vertexScore[v] = scores.Score(cachePosition[v], remaining[v]);
+            }
+
+            best = -1;
+            float bestScore = -1.0f;
+
+            for (const auto v : newCache)
+            {
+                for (uint32_t a = offsets[v]; a < offsets[v] + remaining[v]; a++)
+                {
+                    const auto t = adjacency[a];
+
+                    if (emitted[t])
+                    {
+                        continue;
+                    }
+
+                    triangleScore[t] =
+                        vertexScore[indices[t * 3 + 0]] +
+                        vertexScore[indices[t * 3 + 1]] +
+                        vertexScore[indices[t * 3 + 2]];
+
+                    if (triangleScore[t] > bestScore)
+                    {
+                        bestScore = triangleScore[t];
+                        best = t;
+                    }
+                }
+            }
+
+            if (newCache.size() > ForsythCacheSize)
+            {
+                newCache.resize(ForsythCacheSize);
+            }
+            cache.swap(newCache);
+
+            if (best < 0)
+            {
+                while (scanCursor < triangleCount && emitted[scanCursor])
+                {
+                    scanCursor++;
+                }
+
+                if (scanCursor < triangleCount)
+                {
+                    best = scanCursor;
+                }
+            }
+        }
+
+        indices.swap(output);
+    }
+
+    void MeshOptimizer::OptimizeOverdraw(std::vector<uint32_t> & indices, const std::vector<Vertex> & vertices, float threshold)
+    {
+        const size_t triangleCount = indices.size() / 3;
+
+        if (triangleCount == 0)
+        {
+            return;
+        }
+
+        FifoCacheSimulator cache(vertices.size(), AnalysisCacheSize);
+
+        // A triangle missing on all three vertices usually starts a new, disjoint patch.
+        std::vector<uint32_t> hardBoundaries;
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            if (cache.Triangle(&indices[t * 3]) == 3 || t == 0)
+            {
+                hardBoundaries.push_back((uint32_t)t);
+            }
+        }
+        hardBoundaries.push_back((uint32_t)triangleCount);
+
+        // Split patches further wherever the running ACMR is already within threshold of the patch ACMR.
+        std::vector<uint32_t> clusters;
+        for (size_t c = 0; c + 1 < hardBoundaries.size(); c++)
+        {
+            const auto start = hardBoundaries[c];
+            const auto end = hardBoundaries[c + 1];
+
+            cache.Flush();
+            uint32_t clusterMisses = 0;
+            for (auto t = start; t < end; t++)
+            {
+                clusterMisses += cache.Triangle(&indices[t * 3]);
+            }
+
+            const float clusterThreshold = threshold * clusterMisses / float(end - start);
+
+            cache.Flush();
+            clusters.push_back(start);
+
+            auto runStart = start;
+            uint32_t runMisses = 0;
+            for (auto t = start; t < end; t++)
+            {
+                runMisses += cache.Triangle(&indices[t * 3]);
+
+                if (t + 1 < end && runMisses / float(t + 1 - runStart) <= clusterThreshold)
+                {
+                    clusters.push_back(t + 1);
+                    runStart = t + 1;
+                    runMisses = 0;
+                    cache.Flush();
+                }
+            }
+        }
+        clusters.push_back((uint32_t)triangleCount);
+
+        glm::vec3 meshCentroid(0.0f);
+        for (const auto & vertex : vertices)
+        {
+            meshCentroid += vertex.position;
+        }
+        meshCentroid /= float(std::max<size_t>(vertices.size(), 1));
+
+        const size_t clusterCount = clusters.size() - 1;
+        std::vector<float> sortKeys(clusterCount);
+
+        for (size_t c = 0; c < clusterCount; c++)
+        {
+            glm::vec3 centroid(0.0f);
+            glm::vec3 normal(0.0f);
+            float area = 0.0f;
+
+            for (auto t = clusters[c]; t < clusters[c + 1]; t++)
+            {
+                const auto & a = vertices[indices[t * 3 + 0]].position;
+                const auto & b = vertices[indices[t * 3 + 1]].position;
+                const auto & d = vertices[indices[t * 3 + 2]].position;
+
+                const auto faceNormal = glm::cross(b - a, d - a);
+                const auto faceArea = glm::length(faceNormal);
+
+                centroid += (a + b + d) * (faceArea / 3.0f);
+                normal += faceNormal;
+                area += faceArea;
+            }
+
+            if (area > 0.0f)
+            {
+                centroid /= area;
+            }
+
+            const auto normalLength = glm::length(normal);
+            sortKeys[c] = normalLength > 0.0f ? glm::dot(centroid - meshCentroid, normal / normalLength) : 0.0f;
+        }
+
+        std::vector<uint32_t> order(clusterCount);
+        for (size_t c = 0; c < clusterCount; c++)
+        {
+            order[c] = (uint32_t)c;
+        }
+
+        std::stable_sort(order.begin(), order.end(), [&](uint32_t lhs, uint32_t rhs)
+        {
+            return sortKeys[lhs] > sortKeys[rhs];
+        });
+
+        std::vector<uint32_t> output;
+        output.reserve(indices.size());
+
+        for (const auto c : order)
+        {
+            output.insert(output.end(), indices.begin() + clusters[c] * 3, indices.begin() + clusters[c + 1] * 3);
+        }
+
+        indices.swap(output);
+    }
+
+    void MeshOptimizer::OptimizeVertexFetch(std::vector<Vertex> & vertices, std::vector<uint32_t> & indices)
+    {
+        std::vector<uint32_t> remap(vertices.size(), UINT32_MAX);
+        std::vector<Vertex> reordered;
+        reordered.reserve(vertices.size());
+
+        for (auto & index : indices)
+        {
+            if (remap[index] == UINT32_MAX)
+            {
+                remap[index] = (uint32_t)reordered.size();
+                reordered.push_back(vertices[index]);
+            }
+
+            index = remap[index];
+        }
+
+        vertices.swap(reordered);
+    }
+
+    VertexCacheStatistics MeshOptimizer::AnalyzeVertexCache(const std::vector<uint32_t> & indices, size_t vertexCount, uint32_t cacheSize)
+    {
+        VertexCacheStatistics stats = {};
+
+        const size_t triangleCount = indices.size() / 3;
+
+        if (triangleCount == 0)
+        {
+            return stats;
+        }
+
+        FifoCacheSimulator cache(vertexCount, cacheSize);
+        std::vector<bool> referenced(vertexCount, false);
+
+        uint32_t misses = 0;
+        uint32_t uniqueVertices = 0;
+
+        for (size_t t = 0; t < triangleCount; t++)
+        {
+            misses += cache.Triangle(&indices[t * 3]);
+
+            for (size_t k = 0; k < 3; k++)
+            {
+                if (!referenced[indices[t * 3 + k]])
+                {
+                    referenced[indices[t * 3 + k]] = true;
+                    uniqueVertices++;
+                }
+            }
+        }
+
+        stats.ACMR = misses / float(triangleCount);
+        stats.ATVR = misses / float(uniqueVertices);
+
+        return stats;
+    }
+
+    MeshOptimizationResult MeshOptimizer::Optimize(std::vector<Vertex> & vertices, std::vector<uint32_t> & indices)
+    {
+        MeshOptimizationResult result;
+
+        result.Before = AnalyzeVertexCache(indices, vertices.size(), AnalysisCacheSize);
+
+        OptimizeVertexCache(indices, vertices.size());
+        OptimizeOverdraw(indices, vertices, 1.05f);
+        OptimizeVertexFetch(vertices, indices);
+
+        result.After = AnalyzeVertexCache(indices, vertices.size(), AnalysisCacheSize);
+
+        return result;
+    }
+}
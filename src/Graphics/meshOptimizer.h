@@ -0,0 +1,45 @@
+#ifndef MESHOPTIMIZER_H
+#define MESHOPTIMIZER_H
+#include <stdint.h>
+#include <vector>
+#include "vertex.h"
+
+namespace Graphics
+{
+    struct VertexCacheStatistics
+    {
+        // Vertex shader invocations per triangle.
+        float ACMR;
+
+        // Vertex shader invocations per referenced vertex, 1.0 is optimal.
+        float ATVR;
+    };
+
+    struct MeshOptimizationResult
+    {
+        VertexCacheStatistics Before;
+        VertexCacheStatistics After;
+    };
+
+    class MeshOptimizer
+    {
+    public:
+        // Reorders triangles for post-transform cache locality (Forsyth's linear-speed algorithm).
+        static void OptimizeVertexCache(std::vector<uint32_t> & indices, size_t vertexCount);
+
+        // Splits cache-optimized triangles into clusters and sorts them front to back from the mesh centre,
+        // threshold controls how much ACMR can be traded for less overdraw (1.05 = 5% worse).
+        static void OptimizeOverdraw(std::vector<uint32_t> & indices, const std::vector<Vertex> & vertices, float threshold);
+
+        // Reorders vertices in order of first use, dropping unreferenced vertices.
+        static void OptimizeVertexFetch(std::vector<Vertex> & vertices, std::vector<uint32_t> & indices);
+
+        static VertexCacheStatistics AnalyzeVertexCache(const std::vector<uint32_t> & indices, size_t vertexCount, uint32_t cacheSize);
+
+        // Runs the full import pass: cache, overdraw, then fetch.
+        static MeshOptimizationResult Optimize(std::vector<Vertex> & vertices, std::vector<uint32_t> & indices);
+
+        static const uint32_t AnalysisCacheSize = 16;
+    };
+}
+#endif // !MESHOPTIMIZER_H
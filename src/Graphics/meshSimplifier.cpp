@@ -0,0 +1,513 @@
+#include "meshSimplifier.h"
+#include <algorithm>
+#include <numeric>
+#include <unordered_map>
+#include <math.h>
+
+namespace Graphics
+{
+    enum class VertexKind : uint8_t
+    {
+        Manifold,
+        Border,
+        Seam,
+        Locked
+    };
+
+    struct Quadric
+    {
+        double a00, a11, a22, a01, a02, a12;
+        double b0, b1, b2;
+        double c;
+        double w;
+    };
+
+    Quadric quadricFromPlane(const glm::dvec3 & n, double d, double w)
+    {
+        Quadric q;
+        q.a00 = w * n.x * n.x;
+        q.a11 = w * n.y * n.y;
+        q.a22 = w * n.z * n.z;
+        q.a01 = w * n.x * n.y;
+        q.a02 = w * n.x * n.z;
+        q.a12 = w * n.y * n.z;
+        q.b0 = w * n.x * d;
+        q.b1 = w * n.y * d;
+        q.b2 = w * n.z * d;
+        q.c = w * d * d;
+        q.w = w;
+        return q;
+    }
+
+    void quadricAdd(Quadric & q, const Quadric & r)
+    {
+        q.a00 += r.a00; q.a11 += r.a11; q.a22 += r.a22;
+        q.a01 += r.a01; q.a02 += r.a02; q.a12 += r.a12;
+        q.b0 += r.b0; q.b1 += r.b1; q.b2 += r.b2;
+        q.c += r.c;
+        q.w += r.w;
+    }
+
+    // Weighted mean squared distance from p to the planes accumulated in q.
+    double quadricError(const Quadric & q, const glm::vec3 & p)
+    {
+        const double x = p.x, y = p.y, z = p.z;
+
+        double r =
+            q.a00 * x * x + q.a11 * y * y + q.a22 * z * z +
+            2.0 * (q.a01 * x * y + q.a02 * x * z + q.a12 * y * z) +
+            2.0 * (q.b0 * x + q.b1 * y + q.b2 * z) +
+            q.c;
+
+        return fabs(r) / (q.w > 0.0 ? q.w : 1.0);
+    }
+
+    class TriangleAdjacency
+    {
+    public:
+        void Build(const std::vector<uint32_t> & indices, size_t vertexCount)
+        {
+            offsets.assign(vertexCount + 1, 0);
+
+            for (const auto index : indices)
+            {
+                offsets[index + 1]++;
+            }
+
+            for (size_t v = 0; v < vertexCount; v++)
+            {
+                offsets[v + 1] += offsets[v];
+            }
+
+            triangles.resize(indices.size());
+            std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+
+            for (size_t i = 0; i < indices.size(); i++)
+            {
+                triangles[fill[indices[i]]++] = (uint32_t)(i / 3);
+            }
+        }
+
+        const uint32_t * Begin(uint32_t v) const
+        {
+            return triangles.data() + offsets[v];
+        }
+
+        const uint32_t * End(uint32_t v) const
+        {
+            return triangles.data() + offsets[v + 1];
+        }
+
+    private:
+        std::vector<uint32_t> offsets;
+        std::vector<uint32_t> triangles;
+    };
+
+    bool hasEdge(const TriangleAdjacency & adjacency, const std::vector<uint32_t> & indices, uint32_t a, uint32_t b)
+    {
+        for (auto tri = adjacency.Begin(a); tri != adjacency.End(a); tri++)
+        {
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                if (indices[*tri * 3 + k] == a && indices[*tri * 3 + (k + 1) % 3] == b)
+                {
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    struct OpenEdges
+    {
+        uint32_t Out;
+        uint32_t In;
+        uint32_t OutCount;
+        uint32_t InCount;
+    };
+
+    OpenEdges findOpenEdges(const TriangleAdjacency & adjacency, const std::vector<uint32_t> & indices, uint32_t v)
+    {
+        OpenEdges edges = { v, v, 0, 0 };
+
+        for (auto tri = adjacency.Begin(v); tri != adjacency.End(v); tri++)
+        {
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                if (indices[*tri * 3 + k] != v)
+                {
+                    continue;
+                }
+
+                const auto next = indices[*tri * 3 + (k + 1) % 3];
+                const auto prev = indices[*tri * 3 + (k + 2) % 3];
+
+                if (!hasEdge(adjacency, indices, next, v))
+                {
+                    edges.Out = next;
+                    edges.OutCount++;
+                }
+
+                if (!hasEdge(adjacency, indices, v, prev))
+                {
+                    edges.In = prev;
+                    edges.InCount++;
+                }
+            }
+        }
+
+        return edges;
+    }
+
+    bool collapseFlipsTriangle(
+        const TriangleAdjacency & adjacency,
+        const std::vector<uint32_t> & indices,
+        const std::vector<uint32_t> & positionRemap,
+        const std::vector<Vertex> & vertices,
+        uint32_t v,
+        uint32_t t)
+    {
+        const auto & target = vertices[t].position;
+
+        for (auto tri = adjacency.Begin(v); tri != adjacency.End(v); tri++)
+        {
+            const uint32_t * corner = &indices[*tri * 3];
+
+            if (positionRemap[corner[0]] == positionRemap[t] ||
+                positionRemap[corner[1]] == positionRemap[t] ||
+                positionRemap[corner[2]] == positionRemap[t])
+            {
+                continue;
+            }
+
+            glm::vec3 before[3];
+            glm::vec3 after[3];
+
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                before[k] = vertices[corner[k]].position;
+                after[k] = corner[k] == v ? target : before[k];
+            }
+
+            const auto n0 = glm::cross(before[1] - before[0], before[2] - before[0]);
+            const auto n1 = glm::cross(after[1] - after[0], after[2] - after[0]);
+
+            if (glm::dot(n0, n1) <= 0.0f)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    struct Collapse
+    {
+        uint32_t V;
+        uint32_t T;
+        double Error;
+    };
+
+    std::vector<uint32_t> MeshSimplifier::Simplify(
+        const std::vector<Vertex> & vertices,
+        const std::vector<uint32_t> & indices,
+        size_t targetIndexCount,
+        float targetError,
+        float * resultError)
+    {
+        const auto vertexCount = vertices.size();
+        std::vector<uint32_t> result = indices;
+
+        double maxError = 0.0;
+        const double errorLimit = double(targetError) * double(targetError);
+
+        std::vector<bool> referenced(vertexCount, false);
+        for (const auto index : indices)
+        {
+            referenced[index] = true;
+        }
+
+        // Vertices that share a position form a ring of wedges; the first one seen is canonical.
+        std::vector<uint32_t> positionRemap(vertexCount);
+        std::vector<uint32_t> wedge(vertexCount);
+        std::unordered_map<glm::vec3, uint32_t> firstByPosition;
+
+        for (uint32_t v = 0; v < vertexCount; v++)
+        {
+            wedge[v] = v;
+            positionRemap[v] = v;
+
+            if (referenced[v])
+            {
+                auto found = firstByPosition.emplace(vertices[v].position, v);
+                positionRemap[v] = found.first->second;
+
+                if (positionRemap[v] != v)
+                {
+                    const auto r = positionRemap[v];
+                    wedge[v] = wedge[r];
+                    wedge[r] = v;
+                }
+            }
+        }
+
+        TriangleAdjacency adjacency;
+        adjacency.Build(result, vertexCount);
+
+        std::vector<VertexKind> kind(vertexCount, VertexKind::Locked);
+        std::vector<uint32_t> openNext(vertexCount);
+        std::vector<uint32_t> openPrev(vertexCount);
+
+        for (uint32_t v = 0; v < vertexCount; v++)
+        {
+            if (!referenced[v])
+            {
+                continue;
+            }
+
+            auto edges = findOpenEdges(adjacency, result, v);
+            openNext[v] = edges.Out;
+            openPrev[v] = edges.In;
+
+            if (wedge[v] == v)
+            {
+                if (edges.OutCount == 0 && edges.InCount == 0)
+                {
+                    kind[v] = VertexKind::Manifold;
+                }
+                else if (edges.OutCount == 1 && edges.InCount == 1)
+                {
+                    kind[v] = VertexKind::Border;
+                }
+            }
+            else if (wedge[wedge[v]] == v && edges.OutCount == 1 && edges.InCount == 1)
+            {
+                // A seam pairs each open edge of this wedge with the reversed open edge of its sibling.
+                auto sibling = findOpenEdges(adjacency, result, wedge[v]);
+
+                if (sibling.OutCount == 1 && sibling.InCount == 1 &&
+                    positionRemap[sibling.In] == positionRemap[edges.Out] &&
+                    positionRemap[sibling.Out] == positionRemap[edges.In])
+                {
+                    kind[v] = VertexKind::Seam;
+                }
+            }
+        }
+
+        std::vector<Quadric> quadrics(vertexCount, Quadric());
+
+        for (size_t i = 0; i + 2 < result.size(); i += 3)
+        {
+            const auto & p0 = vertices[result[i + 0]].position;
+            const auto & p1 = vertices[result[i + 1]].position;
+            const auto & p2 = vertices[result[i + 2]].position;
+
+            glm::dvec3 normal = glm::cross(glm::dvec3(p1 - p0), glm::dvec3(p2 - p0));
+            const double length = glm::length(normal);
+
+            if (length == 0.0)
+            {
+                continue;
+            }
+
+            normal /= length;
+
+            auto plane = quadricFromPlane(normal, -glm::dot(normal, glm::dvec3(p0)), length * 0.5);
+
+            for (uint32_t k = 0; k < 3; k++)
+            {
+                const auto a = result[i + k];
+                const auto b = result[i + (k + 1) % 3];
+
+                quadricAdd(quadrics[positionRemap[a]], plane);
+
+                // Open edges (borders and seams) get a plane through the edge, perpendicular to the face.
+                if (!hasEdge(adjacency, result, b, a))
+                {
+                    const auto & pa = vertices[a].position;
+                    const auto & pb = vertices[b].position;
+
+                    glm::dvec3 edge = glm::dvec3(pb - pa);
+                    const double edgeLength = glm::length(edge);
+                    glm::dvec3 edgeNormal = glm::cross(edge, normal);
+                    const double edgeNormalLength = glm::length(edgeNormal);
+
+                    if (edgeNormalLength > 0.0)
+                    {
+                        edgeNormal /= edgeNormalLength;
+
+                        auto border = quadricFromPlane(
+                            edgeNormal,
+                            -glm::dot(edgeNormal, glm::dvec3(pa)),
+                            edgeLength * edgeLength * 10.0);
+
+                        quadricAdd(quadrics[positionRemap[a]], border);
+                        quadricAdd(quadrics[positionRemap[b]], border);
+                    }
+                }
+            }
+        }
+
+        std::vector<Collapse> candidates;
+        std::vector<uint32_t> collapseRemap(vertexCount);
+        std::vector<bool> locked(vertexCount);
+
+        while (result.size() > targetIndexCount)
+        {
+            adjacency.Build(result, vertexCount);
+
+            candidates.clear();
+
+            for (size_t i = 0; i + 2 < result.size(); i += 3)
+            {
+                for (uint32_t k = 0; k < 3; k++)
+                {
+                    const uint32_t edge[2] = { result[i + k], result[i + (k + 1) % 3] };
+
+                    for (uint32_t e = 0; e < 2; e++)
+                    {
+                        const auto v = edge[e];
+                        const auto t = edge[1 - e];
+
+                        bool allowed = false;
+
+                        switch (kind[v])
+                        {
+                        case VertexKind::Manifold:
+                            allowed = true;
+                            break;
+
+                        case VertexKind::Border:
+                        case VertexKind::Seam:
+                            allowed = t == openNext[v] || t == openPrev[v];
+                            break;
+
+                        default:
+                            break;
+                        }
+
+                        if (allowed)
+                        {
+                            candidates.push_back({ v, t, quadricError(quadrics[positionRemap[v]], vertices[t].position) });
+                        }
+                    }
+                }
+            }
+
+            std::sort(candidates.begin(), candidates.end(), [](const Collapse & lhs, const Collapse & rhs)
+            {
+                return lhs.Error < rhs.Error;
+            });
+
+            std::iota(collapseRemap.begin(), collapseRemap.end(), 0);
+            std::fill(locked.begin(), locked.end(), false);
+
+            const size_t goal = std::max<size_t>(1, (result.size() - targetIndexCount) / 6);
+            size_t collapses = 0;
+
+            for (const auto & candidate : candidates)
+            {
+                if (candidate.Error > errorLimit || collapses >= goal)
+                {
+                    break;
+                }
+
+                const auto v = candidate.V;
+                const auto t = candidate.T;
+
+                if (locked[positionRemap[v]] || locked[positionRemap[t]] || collapseRemap[v] != v)
+                {
+                    continue;
+                }
+
+                uint32_t sibling = v;
+                uint32_t siblingTarget = t;
+
+                if (kind[v] == VertexKind::Seam)
+                {
+                    sibling = wedge[v];
+                    siblingTarget = t == openNext[v] ? openPrev[sibling] : openNext[sibling];
+
+                    if (positionRemap[siblingTarget] != positionRemap[t])
+                    {
+                        continue;
+                    }
+                }
+
+                if (collapseFlipsTriangle(adjacency, result, positionRemap, vertices, v, t) ||
+                    (sibling != v && collapseFlipsTriangle(adjacency, result, positionRemap, vertices, sibling, siblingTarget)))
+                {
+                    continue;
+                }
+
+                const uint32_t moved[2] = { v, sibling };
+                const uint32_t targets[2] = { t, siblingTarget };
+
+                for (uint32_t m = 0; m < (sibling != v ? 2u : 1u); m++)
+                {
+                    const auto from = moved[m];
+                    const auto to = targets[m];
+
+                    collapseRemap[from] = to;
+
+                    if (kind[from] != VertexKind::Manifold)
+                    {
+                        if (to == openNext[from])
+                        {
+                            openNext[openPrev[from]] = to;
+                            openPrev[to] = openPrev[from];
+                        }
+                        else
+                        {
+                            openPrev[openNext[from]] = to;
+                            openNext[to] = openNext[from];
+                        }
+                    }
+
+                    for (auto tri = adjacency.Begin(from); tri != adjacency.End(from); tri++)
+                    {
+                        for (uint32_t k = 0; k < 3; k++)
+                        {
+                            locked[positionRemap[result[*tri * 3 + k]]] = true;
+                        }
+                    }
+                }
+
+                quadricAdd(quadrics[positionRemap[t]], quadrics[positionRemap[v]]);
+                maxError = std::max(maxError, candidate.Error);
+                collapses++;
+            }
+
+            if (collapses == 0)
+            {
+                break;
+            }
+
+            size_t write = 0;
+            for (size_t i = 0; i + 2 < result.size(); i += 3)
+            {
+                const auto a = collapseRemap[result[i + 0]];
+                const auto b = collapseRemap[result[i + 1]];
+                const auto c = collapseRemap[result[i + 2]];
+
+                if (positionRemap[a] != positionRemap[b] &&
+                    positionRemap[b] != positionRemap[c] &&
+                    positionRemap[a] != positionRemap[c])
+                {
+                    result[write++] = a;
+                    result[write++] = b;
+                    result[write++] = c;
+                }
+            }
+            result.resize(write);
+        }
+
+        if (resultError != nullptr)
+        {
+            *resultError = (float)sqrt(maxError);
+        }
+
+        return result;
+    }
+}
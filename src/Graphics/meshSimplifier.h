@@ -0,0 +1,25 @@
+#ifndef MESHSIMPLIFIER_H
+#define MESHSIMPLIFIER_H
+#include <stdint.h>
+#include <vector>
+#include "vertex.h"
+
+namespace Graphics
+{
+    class MeshSimplifier
+    {
+    public:
+        // Quadric error edge collapse. Collapses edges until the index count reaches targetIndexCount or the
+        // next collapse would move the surface further than targetError (object space units).
+        // The vertex buffer is shared with the input, only a new index buffer is produced. Vertices split
+        // by an attribute discontinuity (UV seam, hard normal, colour) only move along the seam, together
+        // with their sibling, and open borders only move along the border.
+        static std::vector<uint32_t> Simplify(
+            const std::vector<Vertex> & vertices,
+            const std::vector<uint32_t> & indices,
+            size_t targetIndexCount,
+            float targetError,
+            float * resultError);
+    };
+}
+#endif // !MESHSIMPLIFIER_H
@@ -0,0 +1,251 @@
+#include "meshlet.h"
+#include <algorithm>
+#include <math.h>
+
+namespace Graphics
+{
+    namespace
+    {
+        MeshletBounds ComputeBounds(const MeshletData & data, const Meshlet & meshlet, const std::vector<Vertex> & vertices)
+        {
+            MeshletBounds bounds = {};
+
+            const uint32_t * meshletVertices = &data.Vertices[meshlet.VertexOffset];
+            const uint8_t * triangles = &data.Triangles[meshlet.TriangleOffset * 3];
+
+            glm::vec3 minimum = vertices[meshletVertices[0]].position;
+            glm::vec3 maximum = minimum;
+
+            for (uint32_t i = 1; i < meshlet.VertexCount; i++)
+            {
+                minimum = glm::min(minimum, vertices[meshletVertices[i]].position);
+                maximum = glm::max(maximum, vertices[meshletVertices[i]].position);
+            }
+
+            bounds.Center = (minimum + maximum) * 0.5f;
+
+            for (uint32_t i = 0; i < meshlet.VertexCount; i++)
+            {
+                bounds.Radius = std::max(bounds.Radius, glm::length(vertices[meshletVertices[i]].position - bounds.Center));
+            }
+
+            std::vector<glm::vec3> normals;
+            std::vector<glm::vec3> corners;
+            normals.reserve(meshlet.TriangleCount);
+            corners.reserve(meshlet.TriangleCount);
+
+            glm::vec3 axis(0.0f);
+
+            for (uint32_t i = 0; i < meshlet.TriangleCount; i++)
+            {
+                const auto & a = vertices[meshletVertices[triangles[i * 3 + 0]]].position;
+                const auto & b = vertices[meshletVertices[triangles[i * 3 + 1]]].position;
+                const auto & c = vertices[meshletVertices[triangles[i * 3 + 2]]].position;
+
+                auto normal = glm::cross(b - a, c - a);
+                const float length = glm::length(normal);
+
+                if (length == 0.0f)
+                {
+                    continue;
+                }
+
+                normal /= length;
+                normals.push_back(normal);
+                corners.push_back(a);
+                axis += normal;
+            }
+
+            bounds.Apex = bounds.Center;
+            bounds.Axis = glm::vec3(0.0f, 0.0f, 1.0f);
+            bounds.Cutoff = 2.0f;
+
+            const float axisLength = glm::length(axis);
+
+            if (normals.empty() || axisLength == 0.0f)
+            {
+                return bounds;
+            }
+
+            axis /= axisLength;
+
+            float minDot = 1.0f;
+
+            for (const auto & normal : normals)
+            {
+                minDot = std::min(minDot, glm::dot(axis, normal));
+            }
+
+            // Past ~84 degrees the cone is too wide to ever reject anything and the apex below blows up.
+            if (minDot <= 0.1f)
+            {
+                return bounds;
+            }
+
+            // Move the apex back along the axis until it lies behind every triangle plane, so the test
+            // stays conservative for viewers close to the cluster.
+            float maxT = 0.0f;
+
+            for (size_t i = 0; i < normals.size(); i++)
+            {
+                const float t = glm::dot(bounds.Center - corners[i], normals[i]) / glm::dot(axis, normals[i]);
+                maxT = std::max(maxT, t);
+            }
+
+            bounds.Apex = bounds.Center - axis * maxT;
+            bounds.Axis = axis;
+            bounds.Cutoff = sqrtf(1.0f - minDot * minDot);
+
+            return bounds;
+        }
+    }
+
+    void MeshletData::AppendIndices(size_t meshlet, std::vector<uint32_t> & indices) const
+    {
+        const auto & m = Meshlets[meshlet];
+
+        for (uint32_t i = 0; i < m.TriangleCount * 3; i++)
+        {
+            indices.push_back(Vertices[m.VertexOffset + Triangles[m.TriangleOffset * 3 + i]]);
+        }
+    }
+
+    MeshletData MeshletBuilder::Build(const std::vector<Vertex> & vertices, const std::vector<uint32_t> & indices)
+    {
+        MeshletData data;
+
+        const size_t triangleCount = indices.size() / 3;
+
+        if (triangleCount == 0)
+        {
+            return data;
+        }
+
+        // Triangles touching each vertex, packed as offsets + list.
+        std::vector<uint32_t> adjacencyOffsets(vertices.size() + 1, 0);
+        std::vector<uint32_t> adjacency(triangleCount * 3);
+
+        for (auto index : indices)
+        {
+            adjacencyOffsets[index + 1]++;
+        }
+
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+        }
+
+        {
+            std::vector<uint32_t> fill(adjacencyOffsets.begin(), adjacencyOffsets.end() - 1);
+
+            for (size_t i = 0; i < indices.size(); i++)
+            {
+                adjacency[fill[indices[i]]++] = (uint32_t)(i / 3);
+            }
+        }
+
+        std::vector<bool> emitted(triangleCount, false);
+        std::vector<int32_t> localIndex(vertices.size(), -1);
+
+        Meshlet current = {};
+        size_t cursor = 0;
+
+        auto newVertices = [&](size_t triangle)
+        {
+            uint32_t count = 0;
+
+            for (int k = 0; k < 3; k++)
+            {
+                count += localIndex[indices[triangle * 3 + k]] < 0 ? 1 : 0;
+            }
+
+            return count;
+        };
+
+        auto finish = [&]()
+        {
+            if (current.TriangleCount == 0)
+            {
+                return;
+            }
+
+            data.Meshlets.push_back(current);
+            data.Bounds.push_back(ComputeBounds(data, current, vertices));
+
+            for (uint32_t i = 0; i < current.VertexCount; i++)
+            {
+                localIndex[data.Vertices[current.VertexOffset + i]] = -1;
+            }
+
+            current = {};
+            current.VertexOffset = (uint32_t)data.Vertices.size();
+            current.TriangleOffset = (uint32_t)(data.Triangles.size() / 3);
+        };
+
+        for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++)
+        {
+            // Prefer the neighbouring triangle that adds the fewest vertices, keeping clusters compact.
+            size_t best = triangleCount;
+            uint32_t bestCost = 4;
+
+            for (uint32_t i = 0; i < current.VertexCount && bestCost > 0; i++)
+            {
+                const auto vertex = data.Vertices[current.VertexOffset + i];
+
+                for (uint32_t j = adjacencyOffsets[vertex]; j < adjacencyOffsets[vertex + 1]; j++)
+                {
+                    const auto triangle = adjacency[j];
+
+                    if (emitted[triangle])
+                    {
+                        continue;
+                    }
+
+                    const auto cost = newVertices(triangle);
+
+                    if (cost < bestCost)
+                    {
+                        best = triangle;
+                        bestCost = cost;
+                    }
+                }
+            }
+
+            if (best == triangleCount || current.VertexCount + bestCost > MaxVertices)
+            {
+                while (emitted[cursor])
+                {
+                    cursor++;
+                }
+
+                best = cursor;
+                bestCost = newVertices(best);
+            }
+
+            if (current.VertexCount + bestCost > MaxVertices || current.TriangleCount + 1 > MaxTriangles)
+            {
+                finish();
+            }
+
+            for (int k = 0; k < 3; k++)
+            {
+                const auto vertex = indices[best * 3 + k];
+
+                if (localIndex[vertex] < 0)
+                {
+                    localIndex[vertex] = (int32_t)current.VertexCount++;
+                    data.Vertices.push_back(vertex);
+                }
+
+                data.Triangles.push_back((uint8_t)localIndex[vertex]);
+            }
+
+            current.TriangleCount++;
+            emitted[best] = true;
+        }
+
+        finish();
+
+        return data;
+    }
+}
@@ -0,0 +1,52 @@
+#ifndef MESHLET_H
+#define MESHLET_H
+#include <stdint.h>
+#include <vector>
+#include "vertex.h"
+
+namespace Graphics
+{
+    struct Meshlet
+    {
+        // Offsets into MeshletData::Vertices and MeshletData::Triangles (3 local indices per triangle).
+        uint32_t VertexOffset;
+        uint32_t TriangleOffset;
+        uint32_t VertexCount;
+        uint32_t TriangleCount;
+    };
+
+    struct MeshletBounds
+    {
+        glm::vec3 Center;
+        float Radius;
+
+        // Every triangle faces away from a viewer inside the cone at Apex around -Axis, which is the case
+        // when dot(normalize(Apex - eye), Axis) > Cutoff. Cutoff above 1 means the cluster is never culled.
+        glm::vec3 Apex;
+        glm::vec3 Axis;
+        float Cutoff;
+    };
+
+    struct MeshletData
+    {
+        std::vector<Meshlet> Meshlets;
+        std::vector<MeshletBounds> Bounds;
+        std::vector<uint32_t> Vertices;
+        std::vector<uint8_t> Triangles;
+
+        // Expands the meshlet back into a regular triangle list over the original vertex buffer.
+        void AppendIndices(size_t meshlet, std::vector<uint32_t> & indices) const;
+    };
+
+    class MeshletBuilder
+    {
+    public:
+        // Greedily grows clusters over shared edges, starting new clusters in index buffer order so
+        // cache optimized input keeps its locality.
+        static MeshletData Build(const std::vector<Vertex> & vertices, const std::vector<uint32_t> & indices);
+
+        static const uint32_t MaxVertices = 64;
+        static const uint32_t MaxTriangles = 124;
+    };
+}
+#endif // !MESHLET_H
@@ -0,0 +1,540 @@
+#include "mipChain.h"
+#include "pixelConvert.h"
+#include "../Utils/threadPool.h"
+#include <math.h>
+#include <string.h>
+#include <algorithm>
+#include <array>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define MIP_CHAIN_SSE
+#include <immintrin.h>
+
+// GCC and Clang only allow wider intrinsics in functions built for them, MSVC always does.
+#if defined(__GNUC__) || defined(__clang__)
+#define MIP_CHAIN_TARGET(isa) __attribute__((target(isa)))
+#else
+#define MIP_CHAIN_TARGET(isa)
+#endif
+#endif
+
+namespace Graphics
+{
+    namespace
+    {
+        const uint32_t BandRows = 16;
+
+        // Support in destination texels and shape of the Kaiser window, 4 is the usual compromise
+        // between sharpness and ringing.
+        const float KaiserRadius = 2.0f;
+        const float KaiserAlpha = 4.0f;
+
+#ifdef MIP_CHAIN_SSE
+        typedef __m128 Pixel;
+
+        inline Pixel Zero() { return _mm_setzero_ps(); }
+        inline Pixel Load(const float * p) { return _mm_loadu_ps(p); }
+        inline void Store(float * p, Pixel v) { _mm_storeu_ps(p, v); }
+        inline Pixel MulAdd(Pixel acc, float w, Pixel v) { return _mm_add_ps(acc, _mm_mul_ps(_mm_set1_ps(w), v)); }
+        inline Pixel Saturate(Pixel v) { return _mm_min_ps(_mm_max_ps(v, _mm_setzero_ps()), _mm_set1_ps(1.0f)); }
+#else
+        struct Pixel
+        {
+            float v[4];
+        };
+
+        inline Pixel Zero() { return { { 0.0f, 0.0f, 0.0f, 0.0f } }; }
+        inline Pixel Load(const float * p) { return { { p[0], p[1], p[2], p[3] } }; }
+        inline void Store(float * p, Pixel v) { memcpy(p, v.v, sizeof(v.v)); }
+
+        inline Pixel MulAdd(Pixel acc, float w, Pixel x)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                acc.v[i] += w * x.v[i];
+            }
+            return acc;
+        }
+
+        inline Pixel Saturate(Pixel x)
+        {
+            for (int i = 0; i < 4; i++)
+            {
+                x.v[i] = std::min(std::max(x.v[i], 0.0f), 1.0f);
+            }
+            return x;
+        }
+#endif
+
+        const float * UnormTable()
+        {
+            static const auto table = []()
+            {
+                std::array<float, 256> values;
+
+                for (int i = 0; i < 256; i++)
+                {
+                    values[i] = i / 255.0f;
+                }
+
+                return values;
+            }();
+
+            return table.data();
+        }
+
+        // Weights for one axis, Taps per destination texel starting at First, all in range of the source.
+        struct Filter1D
+        {
+            uint32_t Taps;
+            std::vector<uint32_t> First;
+            std::vector<float> Weights;
+        };
+
+        float BesselI0(float x)
+        {
+            float sum = 1.0f;
+            float term = 1.0f;
+            const float quarterSq = x * x * 0.25f;
+
+            for (int k = 1; k < 20; k++)
+            {
+                term *= quarterSq / (float)(k * k);
+                sum += term;
+            }
+
+            return sum;
+        }
+
+        float Kaiser(float x, float radius)
+        {
+            const float t = x / radius;
+
+            if (fabsf(t) >= 1.0f)
+            {
+                return 0.0f;
+            }
+
+            const float sinc = x == 0.0f ? 1.0f : sinf(3.14159265f * x) / (3.14159265f * x);
+            return sinc * BesselI0(KaiserAlpha * sqrtf(1.0f - t * t)) / BesselI0(KaiserAlpha);
+        }
+
+        Filter1D BuildFilter(uint32_t source, uint32_t destination, MipFilter filter)
+        {
+            const float scale = source / (float)destination;
+
+            std::vector<std::vector<float>> weights(destination);
+            std::vector<int32_t> minimum(destination);
+            uint32_t maxCount = 1;
+
+            for (uint32_t i = 0; i < destination; i++)
+            {
+                std::vector<std::pair<int32_t, float>> taps;
+
+                if (filter == MipFilter::Box)
+                {
+                    const float begin = i * scale;
+                    const float end = begin + scale;
+
+                    for (int32_t j = (int32_t)floorf(begin); j < (int32_t)ceilf(end); j++)
+                    {
+                        const float overlap = std::min(end, j + 1.0f) - std::max(begin, (float)j);
+                        taps.push_back({ j, overlap });
+                    }
+                }
+                else
+                {
+                    const float centre = (i + 0.5f) * scale - 0.5f;
+                    const float radius = KaiserRadius * std::max(scale, 1.0f);
+
+                    for (int32_t j = (int32_t)ceilf(centre - radius); j <= (int32_t)floorf(centre + radius); j++)
+                    {
+                        taps.push_back({ j, Kaiser((j - centre) / std::max(scale, 1.0f), KaiserRadius) });
+                    }
+                }
+
+                // Clamp to edge by folding taps outside the image onto the border texel.
+                int32_t low = (int32_t)source;
+                int32_t high = -1;
+
+                for (auto & tap : taps)
+                {
+                    tap.first = std::min(std::max(tap.first, 0), (int32_t)source - 1);
+                    low = std::min(low, tap.first);
+                    high = std::max(high, tap.first);
+                }
+
+                weights[i].assign(high - low + 1, 0.0f);
+                float total = 0.0f;
+
+                for (const auto & tap : taps)
+                {
+                    weights[i][tap.first - low] += tap.second;
+                    total += tap.second;
+                }
+
+                for (auto & w : weights[i])
+                {
+                    w /= total;
+                }
+
+                minimum[i] = low;
+                maxCount = std::max(maxCount, (uint32_t)weights[i].size());
+            }
+
+            Filter1D result;
+            result.Taps = std::min(maxCount, source);
+            result.First.resize(destination);
+            result.Weights.assign((size_t)destination * result.Taps, 0.0f);
+
+            for (uint32_t i = 0; i < destination; i++)
+            {
+                // Shift windows near the far edge back so every read stays inside the source.
+                const uint32_t first = std::min((uint32_t)minimum[i], source - result.Taps);
+                const uint32_t shift = minimum[i] - first;
+
+                result.First[i] = first;
+
+                for (size_t k = 0; k < weights[i].size(); k++)
+                {
+                    result.Weights[(size_t)i * result.Taps + shift + k] = weights[i][k];
+                }
+            }
+
+            return result;
+        }
+
+        // Colour goes through the sRGB table when one is given.
+        inline void EncodePixel(Pixel linear, const uint8_t * encode, uint8_t * out)
+        {
+            alignas(16) float c[4];
+            Store(c, Saturate(linear));
+
+            for (int i = 0; i < 3; i++)
+            {
+                out[i] = encode
+                    ? encode[(uint32_t)(c[i] * (PixelConvert::SrgbEncodeSize - 1) + 0.5f)]
+                    : (uint8_t)(c[i] * 255.0f + 0.5f);
+            }
+
+            out[3] = (uint8_t)(c[3] * 255.0f + 0.5f);
+        }
+
+        // Alpha is always linear, so it reads unorm even when colour reads the sRGB table.
+        void DecodeRow(const uint8_t * encoded, const float * decode, const float * unorm, uint32_t width, float * out)
+        {
+            for (size_t i = 0; i < (size_t)width * 4; i += 4)
+            {
+                out[i + 0] = decode[encoded[i + 0]];
+                out[i + 1] = decode[encoded[i + 1]];
+                out[i + 2] = decode[encoded[i + 2]];
+                out[i + 3] = unorm[encoded[i + 3]];
+            }
+        }
+
+        void HorizontalRow(const float * row, const Filter1D & filter, uint32_t first, uint32_t width, float * out)
+        {
+            for (uint32_t x = first; x < width; x++)
+            {
+                const float * weights = &filter.Weights[(size_t)x * filter.Taps];
+                const float * texel = row + (size_t)filter.First[x] * 4;
+
+                Pixel acc = Zero();
+
+                for (uint32_t k = 0; k < filter.Taps; k++)
+                {
+                    acc = MulAdd(acc, weights[k], Load(texel + k * 4));
+                }
+
+                Store(out + x * 4, acc);
+            }
+        }
+
+        // Taps rows stride floats apart from base. Next, when given, gets the float texels for the following level.
+        void VerticalRow(const float * base, size_t stride, const float * weights, uint32_t taps, uint32_t first, uint32_t width,
+            const uint8_t * encode, float * next, uint8_t * encoded)
+        {
+            for (uint32_t x = first; x < width; x++)
+            {
+                Pixel acc = Zero();
+
+                for (uint32_t k = 0; k < taps; k++)
+                {
+                    acc = MulAdd(acc, weights[k], Load(base + k * stride + x * 4));
+                }
+
+                acc = Saturate(acc);
+
+                if (next)
+                {
+                    Store(next + x * 4, acc);
+                }
+
+                EncodePixel(acc, encode, encoded + x * 4);
+            }
+        }
+
+#ifdef MIP_CHAIN_SSE
+        // Two texels per register. The sums run in the same order as the SSE path, without FMA, so
+        // both produce the same bytes.
+        // Linear rows are converted in registers, the division rounding exactly like the table's i / 255.
+        // sRGB rows keep the scalar lookups, which measured faster than two gathers per pair of texels.
+        MIP_CHAIN_TARGET("avx2")
+        void DecodeRowAvx2(const uint8_t * encoded, const float * decode, const float * unorm, uint32_t width, float * out)
+        {
+            uint32_t x = 0;
+
+            if (decode == unorm)
+            {
+                for (; x + 2 <= width; x += 2)
+                {
+                    const __m256i values = _mm256_cvtepu8_epi32(_mm_loadl_epi64((const __m128i *)(encoded + x * 4)));
+                    _mm256_storeu_ps(out + x * 4, _mm256_div_ps(_mm256_cvtepi32_ps(values), _mm256_set1_ps(255.0f)));
+                }
+            }
+
+            DecodeRow(encoded + x * 4, decode, unorm, width - x, out + x * 4);
+        }
+
+        MIP_CHAIN_TARGET("avx2")
+        void HorizontalRowAvx2(const float * row, const Filter1D & filter, uint32_t first, uint32_t width, float * out)
+        {
+            uint32_t x = first;
+
+            for (; x + 2 <= width; x += 2)
+            {
+                const float * weights = &filter.Weights[(size_t)x * filter.Taps];
+                const float * left = row + (size_t)filter.First[x] * 4;
+                const float * right = row + (size_t)filter.First[x + 1] * 4;
+
+                __m256 acc = _mm256_setzero_ps();
+
+                for (uint32_t k = 0; k < filter.Taps; k++)
+                {
+                    const __m256 w = _mm256_blend_ps(_mm256_broadcast_ss(weights + k), _mm256_broadcast_ss(weights + filter.Taps + k), 0xF0);
+                    const __m256 texels = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(left + k * 4)), _mm_loadu_ps(right + k * 4), 1);
+                    acc = _mm256_add_ps(acc, _mm256_mul_ps(w, texels));
+                }
+
+                _mm256_storeu_ps(out + x * 4, acc);
+            }
+
+            HorizontalRow(row, filter, x, width, out);
+        }
+
+        MIP_CHAIN_TARGET("avx2")
+        void VerticalRowAvx2(const float * base, size_t stride, const float * weights, uint32_t taps, uint32_t first, uint32_t width,
+            const uint8_t * encode, float * next, uint8_t * encoded)
+        {
+            // Colour and alpha scales for two texels, the colour one indexing the sRGB table when there is one.
+            const float colourScale = encode ? (float)(PixelConvert::SrgbEncodeSize - 1) : 255.0f;
+            const __m256 scale = _mm256_setr_ps(colourScale, colourScale, colourScale, 255.0f, colourScale, colourScale, colourScale, 255.0f);
+
+            uint32_t x = first;
+
+            for (; x + 2 <= width; x += 2)
+            {
+                __m256 acc = _mm256_setzero_ps();
+
+                for (uint32_t k = 0; k < taps; k++)
+                {
+                    acc = _mm256_add_ps(acc, _mm256_mul_ps(_mm256_set1_ps(weights[k]), _mm256_loadu_ps(base + k * stride + x * 4)));
+                }
+
+                acc = _mm256_min_ps(_mm256_max_ps(acc, _mm256_setzero_ps()), _mm256_set1_ps(1.0f));
+
+                if (next)
+                {
+                    _mm256_storeu_ps(next + x * 4, acc);
+                }
+
+                const __m256i scaled = _mm256_cvttps_epi32(_mm256_add_ps(_mm256_mul_ps(acc, scale), _mm256_set1_ps(0.5f)));
+                uint8_t * out = encoded + x * 4;
+
+                if (encode)
+                {
+                    alignas(32) uint32_t index[8];
+                    _mm256_store_si256((__m256i *)index, scaled);
+
+                    for (int i = 0; i < 8; i++)
+                    {
+                        out[i] = (i & 3) == 3 ? (uint8_t)index[i] : encode[index[i]];
+                    }
+                }
+                else
+                {
+                    // Every value is already 0 to 255, so the saturating packs only narrow.
+                    const __m256i words = _mm256_packus_epi32(scaled, scaled);
+                    const __m256i bytes = _mm256_packus_epi16(words, words);
+                    const uint32_t low = (uint32_t)_mm_cvtsi128_si32(_mm256_castsi256_si128(bytes));
+                    const uint32_t high = (uint32_t)_mm_cvtsi128_si32(_mm256_extracti128_si256(bytes, 1));
+                    memcpy(out, &low, 4);
+                    memcpy(out + 4, &high, 4);
+                }
+            }
+
+            VerticalRow(base, stride, weights, taps, x, width, encode, next, encoded);
+        }
+#endif
+
+        // One row of each pass, the widest set the CPU runs is picked on first use.
+        struct Kernels
+        {
+            void (*Decode)(const uint8_t * encoded, const float * decode, const float * unorm, uint32_t width, float * out);
+            void (*Horizontal)(const float * row, const Filter1D & filter, uint32_t first, uint32_t width, float * out);
+            void (*Vertical)(const float * base, size_t stride, const float * weights, uint32_t taps, uint32_t first, uint32_t width,
+                const uint8_t * encode, float * next, uint8_t * encoded);
+        };
+
+        Kernels Choose(const Util::Cpu::Features & features)
+        {
+            Kernels kernels = { DecodeRow, HorizontalRow, VerticalRow };
+
+#ifdef MIP_CHAIN_SSE
+            if (features.Avx2)
+            {
+                kernels = { DecodeRowAvx2, HorizontalRowAvx2, VerticalRowAvx2 };
+            }
+#endif
+
+            return kernels;
+        }
+
+        Kernels & Active()
+        {
+            static Kernels kernels = Choose(Util::Cpu::Current());
+            return kernels;
+        }
+    }
+
+    void MipChain::Select(const Util::Cpu::Features & features)
+    {
+        Active() = Choose(features);
+    }
+
+    uint32_t MipChain::LevelCount(uint32_t width, uint32_t height)
+    {
+        uint32_t levels = 1;
+
+        while (width > 1 || height > 1)
+        {
+            width = std::max(width / 2, 1u);
+            height = std::max(height / 2, 1u);
+            levels++;
+        }
+
+        return levels;
+    }
+
+    std::vector<MipLevel> MipChain::Layout(uint32_t width, uint32_t height, uint32_t bytesPerPixel)
+    {
+        std::vector<MipLevel> levels(LevelCount(width, height));
+        uint64_t offset = 0;
+
+        for (auto & level : levels)
+        {
+            level.Width = width;
+            level.Height = height;
+            level.Offset = offset;
+            level.Size = (uint64_t)width * height * bytesPerPixel;
+
+            offset = (offset + level.Size + 15) & ~15ull;
+            width = std::max(width / 2, 1u);
+            height = std::max(height / 2, 1u);
+        }
+
+        return levels;
+    }
+
+    uint64_t MipChain::TotalSize(const std::vector<MipLevel> & levels)
+    {
+        return levels.empty() ? 0 : levels.back().Offset + levels.back().Size;
+    }
+
+    void MipChain::Generate(const uint8_t * source, uint32_t width, uint32_t height, MipFilter filter, bool srgb, uint8_t * chain)
+    {
+        const auto levels = Layout(width, height, 4);
+        const float * unorm = UnormTable();
+        const float * decode = srgb ? PixelConvert::SrgbDecodeTable() : unorm;
+        const uint8_t * encode = srgb ? PixelConvert::SrgbEncodeTable() : nullptr;
+
+        memcpy(chain, source, levels[0].Size);
+
+        auto pool = Util::Threading::ThreadPool::GetInstance();
+
+        // Linear float copy of the previous level; level 1 is filtered straight from the 8 bit source.
+        std::vector<float> previous;
+        std::vector<float> next;
+
+        for (size_t l = 1; l < levels.size(); l++)
+        {
+            const auto & src = levels[l - 1];
+            const auto & dst = levels[l];
+            const bool fromSource = l == 1;
+            const bool keep = l + 1 < levels.size();
+
+            const auto horizontal = BuildFilter(src.Width, dst.Width, filter);
+            const auto vertical = BuildFilter(src.Height, dst.Height, filter);
+
+            if (keep)
+            {
+                next.resize((size_t)dst.Width * dst.Height * 4);
+            }
+
+            const uint32_t bands = (dst.Height + BandRows - 1) / BandRows;
+
+            const Kernels kernels = Active();
+
+            pool->ParallelFor(bands, 1, [&](size_t firstBand, size_t lastBand)
+            {
+                std::vector<float> decoded((size_t)src.Width * 4);
+                std::vector<float> rows;
+
+                for (size_t band = firstBand; band < lastBand; band++)
+                {
+                    const uint32_t y0 = (uint32_t)band * BandRows;
+                    const uint32_t y1 = std::min(dst.Height, y0 + BandRows);
+                    const uint32_t sy0 = vertical.First[y0];
+                    const uint32_t sy1 = vertical.First[y1 - 1] + vertical.Taps;
+
+                    rows.resize((size_t)(sy1 - sy0) * dst.Width * 4);
+
+                    // Horizontal pass over every source row the band's vertical taps touch.
+                    for (uint32_t sy = sy0; sy < sy1; sy++)
+                    {
+                        const float * row;
+
+                        if (fromSource)
+                        {
+                            kernels.Decode(source + (size_t)sy * src.Width * 4, decode, unorm, src.Width, decoded.data());
+                            row = decoded.data();
+                        }
+                        else
+                        {
+                            row = &previous[(size_t)sy * src.Width * 4];
+                        }
+
+                        kernels.Horizontal(row, horizontal, 0, dst.Width, &rows[(size_t)(sy - sy0) * dst.Width * 4]);
+                    }
+
+                    // Vertical pass, writing both the float level for the next iteration and the encoded texels.
+                    for (uint32_t y = y0; y < y1; y++)
+                    {
+                        kernels.Vertical(
+                            &rows[(size_t)(vertical.First[y] - sy0) * dst.Width * 4],
+                            (size_t)dst.Width * 4,
+                            &vertical.Weights[(size_t)y * vertical.Taps],
+                            vertical.Taps,
+                            0,
+                            dst.Width,
+                            encode,
+                            keep ? &next[(size_t)y * dst.Width * 4] : nullptr,
+                            chain + dst.Offset + (size_t)y * dst.Width * 4);
+                    }
+                }
+            });
+
+            previous.swap(next);
+        }
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef MIPCHAIN_H
+#define MIPCHAIN_H
+#include "../Utils/cpuFeatures.h"
+#include <stdint.h>
+#include <vector>
+
+namespace Graphics
+{
+    enum class MipFilter
+    {
+        // Averages the footprint of each texel, cheap and soft.
+        Box,
+
+        // Kaiser windowed sinc, keeps more detail at the cost of slight ringing.
+        Kaiser
+    };
+
+    struct MipLevel
+    {
+        uint32_t Width;
+        uint32_t Height;
+        uint64_t Offset;
+        uint64_t Size;
+    };
+
+    class MipChain
+    {
+    public:
+        static uint32_t LevelCount(uint32_t width, uint32_t height);
+
+        // Tightly packed levels, largest first, each starting on a 16 byte boundary.
+        static std::vector<MipLevel> Layout(uint32_t width, uint32_t height, uint32_t bytesPerPixel);
+        static uint64_t TotalSize(const std::vector<MipLevel> & levels);
+
+        // Writes every level, including a copy of level 0, of an RGBA8 image into chain laid out as
+        // Layout(width, height, 4). The chain is only written, so it can be mapped upload memory.
+        // With srgb the colour channels are filtered in linear space, alpha is always linear.
+        static void Generate(const uint8_t * source, uint32_t width, uint32_t height, MipFilter filter, bool srgb, uint8_t * chain);
+
+        // The row kernels are picked for the CPU on first use, AVX2 when it has it. Like
+        // PixelConvert::Select this swaps them, and must not race with Generate.
+        static void Select(const Util::Cpu::Features & features);
+    };
+}
+#endif // !MIPCHAIN_H
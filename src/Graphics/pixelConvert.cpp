@@ -0,0 +1,421 @@
+#include "pixelConvert.h"
+#include <math.h>
+#include <string.h>
+#include <array>
+#include <vector>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define PIXEL_CONVERT_SSE
+#include <immintrin.h>
+
+// GCC and Clang only allow wider intrinsics in functions built for them, MSVC always does.
+#if defined(__GNUC__) || defined(__clang__)
+#define PIXEL_CONVERT_TARGET(isa) __attribute__((target(isa)))
+#else
+#define PIXEL_CONVERT_TARGET(isa)
+#endif
+#endif
+
+namespace Graphics
+{
+    namespace
+    {
+        const uint32_t EncodeTableSize = PixelConvert::SrgbEncodeSize;
+
+        struct Kernels
+        {
+            void (*RgbToRgba)(const uint8_t * rgb, uint8_t * rgba, size_t pixels);
+            void (*LinearToSrgb)(const float * linear, uint8_t * srgb, size_t count);
+            void (*PremultiplyAlpha)(uint8_t * rgba, size_t pixels);
+            void (*RgbaToR8)(const uint8_t * rgba, uint8_t * r, size_t pixels);
+            void (*RgbaToRg8)(const uint8_t * rgba, uint8_t * rg, size_t pixels);
+            void (*FloatToHalf)(const float * source, uint16_t * half, size_t count);
+            const char * Level;
+        };
+
+        const std::array<float, 256> & DecodeTable()
+        {
+            static const auto table = []()
+            {
+                std::array<float, 256> values;
+
+                for (int i = 0; i < 256; i++)
+                {
+                    const float c = i / 255.0f;
+                    values[i] = c <= 0.04045f ? c / 12.92f : powf((c + 0.055f) / 1.055f, 2.4f);
+                }
+
+                return values;
+            }();
+
+            return table;
+        }
+
+        // Fine enough that the darkest step, where the curve is steepest, stays well under one output level.
+        const std::vector<uint8_t> & EncodeTable()
+        {
+            static const auto table = []()
+            {
+                std::vector<uint8_t> values(EncodeTableSize);
+
+                for (uint32_t i = 0; i < EncodeTableSize; i++)
+                {
+                    const float l = i / (float)(EncodeTableSize - 1);
+                    const float c = l <= 0.0031308f ? l * 12.92f : 1.055f * powf(l, 1.0f / 2.4f) - 0.055f;
+                    values[i] = (uint8_t)(c * 255.0f + 0.5f);
+                }
+
+                return values;
+            }();
+
+            return table;
+        }
+
+        inline uint8_t MultiplyUnorm(uint32_t c, uint32_t a)
+        {
+            const uint32_t t = c * a + 128;
+            return (uint8_t)((t + (t >> 8)) >> 8);
+        }
+
+        void RgbToRgbaScalar(const uint8_t * rgb, uint8_t * rgba, size_t pixels)
+        {
+            for (size_t i = 0; i < pixels; i++)
+            {
+                rgba[i * 4 + 0] = rgb[i * 3 + 0];
+                rgba[i * 4 + 1] = rgb[i * 3 + 1];
+                rgba[i * 4 + 2] = rgb[i * 3 + 2];
+                rgba[i * 4 + 3] = 255;
+            }
+        }
+
+        void LinearToSrgbScalar(const float * linear, uint8_t * srgb, size_t count)
+        {
+            const uint8_t * table = EncodeTable().data();
+
+            for (size_t i = 0; i < count; i++)
+            {
+                // Written so NaN fails both tests and lands on 0.
+                const float l = linear[i] > 0.0f ? (linear[i] < 1.0f ? linear[i] : 1.0f) : 0.0f;
+                srgb[i] = table[(uint32_t)(l * (EncodeTableSize - 1) + 0.5f)];
+            }
+        }
+
+        void PremultiplyAlphaScalar(uint8_t * rgba, size_t pixels)
+        {
+            for (size_t i = 0; i < pixels; i++)
+            {
+                uint8_t * p = rgba + i * 4;
+                p[0] = MultiplyUnorm(p[0], p[3]);
+                p[1] = MultiplyUnorm(p[1], p[3]);
+                p[2] = MultiplyUnorm(p[2], p[3]);
+            }
+        }
+
+        void RgbaToR8Scalar(const uint8_t * rgba, uint8_t * r, size_t pixels)
+        {
+            for (size_t i = 0; i < pixels; i++)
+            {
+                r[i] = rgba[i * 4];
+            }
+        }
+
+        void RgbaToRg8Scalar(const uint8_t * rgba, uint8_t * rg, size_t pixels)
+        {
+            for (size_t i = 0; i < pixels; i++)
+            {
+                rg[i * 2 + 0] = rgba[i * 4 + 0];
+                rg[i * 2 + 1] = rgba[i * 4 + 1];
+            }
+        }
+
+        inline uint16_t FloatToHalf(float value)
+        {
+            uint32_t bits;
+            memcpy(&bits, &value, sizeof(bits));
+
+            const uint16_t sign = (uint16_t)((bits >> 16) & 0x8000);
+            uint32_t magnitude = bits & 0x7FFFFFFF;
+
+            if (magnitude >= 0x7F800000)
+            {
+                // Infinity stays infinity, NaNs keep their top payload bits and stay quiet.
+                return sign | 0x7C00 | (magnitude > 0x7F800000 ? 0x200 | ((magnitude >> 13) & 0x3FF) : 0);
+            }
+
+            // 65520 and up round to infinity.
+            if (magnitude >= 0x477FF000)
+            {
+                return sign | 0x7C00;
+            }
+
+            // Below the smallest normal half, adding 0.5 lines the half's denormal bits up with the
+            // bottom of the float's mantissa and the FPU does the rounding.
+            if (magnitude < 0x38800000)
+            {
+                float shifted;
+                memcpy(&shifted, &magnitude, sizeof(shifted));
+                shifted += 0.5f;
+
+                uint32_t shiftedBits;
+                memcpy(&shiftedBits, &shifted, sizeof(shiftedBits));
+                return sign | (uint16_t)(shiftedBits - 0x3F000000);
+            }
+
+            // Rebias the exponent and round the 13 dropped bits to nearest even.
+            const uint32_t odd = (magnitude >> 13) & 1;
+            magnitude += 0xC8000FFF + odd;
+            return sign | (uint16_t)(magnitude >> 13);
+        }
+
+        void FloatToHalfScalar(const float * source, uint16_t * half, size_t count)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                half[i] = FloatToHalf(source[i]);
+            }
+        }
+
+#ifdef PIXEL_CONVERT_SSE
+        void LinearToSrgbSse2(const float * linear, uint8_t * srgb, size_t count)
+        {
+            const __m128 zero = _mm_setzero_ps();
+            const __m128 one = _mm_set1_ps(1.0f);
+            const __m128 threshold = _mm_set1_ps(0.0031308f);
+
+            size_t i = 0;
+
+            for (; i + 4 <= count; i += 4)
+            {
+                // max returns its second operand for NaN, so NaN becomes 0 like the scalar path.
+                const __m128 l = _mm_min_ps(_mm_max_ps(_mm_loadu_ps(linear + i), zero), one);
+
+                // Fit of 1.055 * l^(1/2.4) - 0.055 from l^(1/2), l^(1/4) and l^(1/8).
+                const __m128 s1 = _mm_sqrt_ps(l);
+                const __m128 s2 = _mm_sqrt_ps(s1);
+                const __m128 s3 = _mm_sqrt_ps(s2);
+
+                __m128 curve = _mm_mul_ps(_mm_set1_ps(0.585122381f), s1);
+                curve = _mm_add_ps(curve, _mm_mul_ps(_mm_set1_ps(0.783140355f), s2));
+                curve = _mm_sub_ps(curve, _mm_mul_ps(_mm_set1_ps(0.368262736f), s3));
+
+                const __m128 ramp = _mm_mul_ps(l, _mm_set1_ps(12.92f));
+                const __m128 useRamp = _mm_cmple_ps(l, threshold);
+                const __m128 c = _mm_or_ps(_mm_and_ps(useRamp, ramp), _mm_andnot_ps(useRamp, curve));
+
+                const __m128i values = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(c, _mm_set1_ps(255.0f)), _mm_set1_ps(0.5f)));
+                const __m128i bytes = _mm_packus_epi16(_mm_packs_epi32(values, values), _mm_setzero_si128());
+
+                const int packed = _mm_cvtsi128_si32(bytes);
+                memcpy(srgb + i, &packed, 4);
+            }
+
+            LinearToSrgbScalar(linear + i, srgb + i, count - i);
+        }
+
+        void PremultiplyAlphaSse2(uint8_t * rgba, size_t pixels)
+        {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i round = _mm_set1_epi16(128);
+            const __m128i alphaLanes = _mm_set_epi16(-1, 0, 0, 0, -1, 0, 0, 0);
+
+            size_t i = 0;
+
+            for (; i + 4 <= pixels; i += 4)
+            {
+                const __m128i v = _mm_loadu_si128((const __m128i *)(rgba + i * 4));
+                __m128i halves[2] = { _mm_unpacklo_epi8(v, zero), _mm_unpackhi_epi8(v, zero) };
+
+                for (auto & half : halves)
+                {
+                    const __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(half, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(3, 3, 3, 3));
+
+                    __m128i t = _mm_add_epi16(_mm_mullo_epi16(half, alpha), round);
+                    t = _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+
+                    half = _mm_or_si128(_mm_and_si128(alphaLanes, half), _mm_andnot_si128(alphaLanes, t));
+                }
+
+                _mm_storeu_si128((__m128i *)(rgba + i * 4), _mm_packus_epi16(halves[0], halves[1]));
+            }
+
+            PremultiplyAlphaScalar(rgba + i * 4, pixels - i);
+        }
+
+        void RgbaToR8Sse2(const uint8_t * rgba, uint8_t * r, size_t pixels)
+        {
+            const __m128i mask = _mm_set1_epi32(0xFF);
+            size_t i = 0;
+
+            for (; i + 16 <= pixels; i += 16)
+            {
+                const __m128i * source = (const __m128i *)(rgba + i * 4);
+
+                const __m128i a = _mm_and_si128(_mm_loadu_si128(source + 0), mask);
+                const __m128i b = _mm_and_si128(_mm_loadu_si128(source + 1), mask);
+                const __m128i c = _mm_and_si128(_mm_loadu_si128(source + 2), mask);
+                const __m128i d = _mm_and_si128(_mm_loadu_si128(source + 3), mask);
+
+                _mm_storeu_si128((__m128i *)(r + i), _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d)));
+            }
+
+            RgbaToR8Scalar(rgba + i * 4, r + i, pixels - i);
+        }
+
+        void RgbaToRg8Sse2(const uint8_t * rgba, uint8_t * rg, size_t pixels)
+        {
+            size_t i = 0;
+
+            for (; i + 8 <= pixels; i += 8)
+            {
+                const __m128i * source = (const __m128i *)(rgba + i * 4);
+
+                // Sign extending the low 16 bits lets the signed pack pass every pattern through unchanged.
+                const __m128i a = _mm_srai_epi32(_mm_slli_epi32(_mm_loadu_si128(source + 0), 16), 16);
+                const __m128i b = _mm_srai_epi32(_mm_slli_epi32(_mm_loadu_si128(source + 1), 16), 16);
+
+                _mm_storeu_si128((__m128i *)(rg + i * 2), _mm_packs_epi32(a, b));
+            }
+
+            RgbaToRg8Scalar(rgba + i * 4, rg + i * 2, pixels - i);
+        }
+
+        PIXEL_CONVERT_TARGET("ssse3")
+        void RgbToRgbaSsse3(const uint8_t * rgb, uint8_t * rgba, size_t pixels)
+        {
+            const __m128i shuffle = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+            const __m128i alpha = _mm_set1_epi32((int)0xFF000000);
+
+            size_t i = 0;
+
+            // Each step reads 16 bytes for 4 pixels, so stop while the 4 bytes past them are still in range.
+            for (; i + 6 <= pixels; i += 4)
+            {
+                const __m128i v = _mm_loadu_si128((const __m128i *)(rgb + i * 3));
+                _mm_storeu_si128((__m128i *)(rgba + i * 4), _mm_or_si128(_mm_shuffle_epi8(v, shuffle), alpha));
+            }
+
+            RgbToRgbaScalar(rgb + i * 3, rgba + i * 4, pixels - i);
+        }
+
+        PIXEL_CONVERT_TARGET("avx,f16c")
+        void FloatToHalfF16c(const float * source, uint16_t * half, size_t count)
+        {
+            size_t i = 0;
+
+            for (; i + 8 <= count; i += 8)
+            {
+                const __m128i packed = _mm256_cvtps_ph(_mm256_loadu_ps(source + i), _MM_FROUND_TO_NEAREST_INT);
+                _mm_storeu_si128((__m128i *)(half + i), packed);
+            }
+
+            FloatToHalfScalar(source + i, half + i, count - i);
+        }
+#endif
+
+        Kernels Choose(const Util::Cpu::Features & features)
+        {
+            Kernels kernels =
+            {
+                RgbToRgbaScalar,
+                LinearToSrgbScalar,
+                PremultiplyAlphaScalar,
+                RgbaToR8Scalar,
+                RgbaToRg8Scalar,
+                FloatToHalfScalar,
+                "Scalar"
+            };
+
+#ifdef PIXEL_CONVERT_SSE
+            if (features.Sse2)
+            {
+                kernels.LinearToSrgb = LinearToSrgbSse2;
+                kernels.PremultiplyAlpha = PremultiplyAlphaSse2;
+                kernels.RgbaToR8 = RgbaToR8Sse2;
+                kernels.RgbaToRg8 = RgbaToRg8Sse2;
+                kernels.Level = "SSE2";
+            }
+
+            if (features.Ssse3)
+            {
+                kernels.RgbToRgba = RgbToRgbaSsse3;
+                kernels.Level = "SSSE3";
+            }
+
+            if (features.F16c)
+            {
+                kernels.FloatToHalf = FloatToHalfF16c;
+                kernels.Level = "AVX F16C";
+            }
+#endif
+
+            return kernels;
+        }
+
+        Kernels & Active()
+        {
+            static Kernels kernels = Choose(Util::Cpu::Current());
+            return kernels;
+        }
+    }
+
+    void PixelConvert::RgbToRgba(const uint8_t * rgb, uint8_t * rgba, size_t pixels)
+    {
+        Active().RgbToRgba(rgb, rgba, pixels);
+    }
+
+    void PixelConvert::SrgbToLinear(const uint8_t * srgb, float * linear, size_t count)
+    {
+        // 256 entries fit in L1, a lookup beats any vector evaluation of the curve.
+        const float * table = DecodeTable().data();
+
+        for (size_t i = 0; i < count; i++)
+        {
+            linear[i] = table[srgb[i]];
+        }
+    }
+
+    void PixelConvert::LinearToSrgb(const float * linear, uint8_t * srgb, size_t count)
+    {
+        Active().LinearToSrgb(linear, srgb, count);
+    }
+
+    const float * PixelConvert::SrgbDecodeTable()
+    {
+        return DecodeTable().data();
+    }
+
+    const uint8_t * PixelConvert::SrgbEncodeTable()
+    {
+        return EncodeTable().data();
+    }
+
+    void PixelConvert::PremultiplyAlpha(uint8_t * rgba, size_t pixels)
+    {
+        Active().PremultiplyAlpha(rgba, pixels);
+    }
+
+    void PixelConvert::RgbaToR8(const uint8_t * rgba, uint8_t * r, size_t pixels)
+    {
+        Active().RgbaToR8(rgba, r, pixels);
+    }
+
+    void PixelConvert::RgbaToRg8(const uint8_t * rgba, uint8_t * rg, size_t pixels)
+    {
+        Active().RgbaToRg8(rgba, rg, pixels);
+    }
+
+    void PixelConvert::FloatToHalf(const float * source, uint16_t * half, size_t count)
+    {
+        Active().FloatToHalf(source, half, count);
+    }
+
+    void PixelConvert::Select(const Util::Cpu::Features & features)
+    {
+        Active() = Choose(features);
+    }
+
+    const char * PixelConvert::Level()
+    {
+        return Active().Level;
+    }
+}
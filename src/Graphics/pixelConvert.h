@@ -0,0 +1,44 @@
+#ifndef PIXELCONVERT_H
+#define PIXELCONVERT_H
+#include "../Utils/cpuFeatures.h"
+#include <stddef.h>
+#include <stdint.h>
+
+namespace Graphics
+{
+    // Channel and colour space conversions for imported pixels. Every kernel has a scalar version and
+    // the widest the CPU supports is picked on first use. Select swaps the set, e.g. to time them
+    // against each other, and must not race with conversions.
+    class PixelConvert
+    {
+    public:
+        static void RgbToRgba(const uint8_t * rgb, uint8_t * rgba, size_t pixels);
+
+        static void SrgbToLinear(const uint8_t * srgb, float * linear, size_t count);
+
+        // The scalar path rounds through a table, the SSE2 one evaluates a fitted curve and lands one
+        // step off for roughly an eighth of inputs.
+        static void LinearToSrgb(const float * linear, uint8_t * srgb, size_t count);
+
+        // In place on RGBA8 UNORM, rounded like c * a / 255.
+        static void PremultiplyAlpha(uint8_t * rgba, size_t pixels);
+
+        static void RgbaToR8(const uint8_t * rgba, uint8_t * r, size_t pixels);
+        static void RgbaToRg8(const uint8_t * rgba, uint8_t * rg, size_t pixels);
+
+        // Round to nearest even, overflow goes to infinity and NaNs stay NaN.
+        static void FloatToHalf(const float * source, uint16_t * half, size_t count);
+
+        // The tables behind the scalar sRGB paths, also used by MipChain so both round the same way.
+        // Encode is indexed by a clamped linear value times SrgbEncodeSize - 1.
+        static constexpr uint32_t SrgbEncodeSize = 65536;
+        static const float * SrgbDecodeTable();
+        static const uint8_t * SrgbEncodeTable();
+
+        static void Select(const Util::Cpu::Features & features);
+
+        // Widest instruction set among the selected kernels, for logging.
+        static const char * Level();
+    };
+}
+#endif // !PIXELCONVERT_H
@@ -0,0 +1,548 @@
+#include "tangentSpace.h"
+#include "../Utils/cpuFeatures.h"
+#include "../Utils/threadPool.h"
+#include <float.h>
+#include <math.h>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE2__)
+#define TANGENT_SPACE_SSE
+#include <immintrin.h>
+
+// GCC and Clang only allow wider intrinsics in functions built for them, MSVC always does.
+#if defined(__GNUC__) || defined(__clang__)
+#define TANGENT_SPACE_TARGET(isa) __attribute__((target(isa)))
+#else
+#define TANGENT_SPACE_TARGET(isa)
+#endif
+#endif
+
+namespace Graphics
+{
+    namespace
+    {
+        const size_t TrianglesPerTask = 16384;
+        const size_t VerticesPerTask = 16384;
+        const float Pi = 3.14159265358979f;
+
+        // Per face results kept as structure of arrays so the SIMD paths can store four or eight faces at once.
+        struct FaceData
+        {
+            std::vector<float> normalX, normalY, normalZ;
+            std::vector<float> tangentX, tangentY, tangentZ;
+
+            // +1 or -1 for the UV handedness, 0 when the UVs are degenerate.
+            std::vector<float> sign;
+            std::vector<float> angle[3];
+
+            void Resize(size_t count)
+            {
+                for (auto * v : { &normalX, &normalY, &normalZ, &tangentX, &tangentY, &tangentZ, &sign, &angle[0], &angle[1], &angle[2] })
+                {
+                    v->resize(count);
+                }
+            }
+        };
+
+        // Abramowitz and Stegun 4.4.45, good to 7e-5 radians which is plenty for a weight.
+        float FastAcos(float x)
+        {
+            x = fminf(fmaxf(x, -1.0f), 1.0f);
+            const float a = fabsf(x);
+            const float r = sqrtf(1.0f - a) * (((-0.0187293f * a + 0.0742610f) * a - 0.2121144f) * a + 1.5707288f);
+            return x < 0.0f ? Pi - r : r;
+        }
+
+        float SafeCos(const glm::vec3 & a, const glm::vec3 & b)
+        {
+            const float lengths = sqrtf(glm::dot(a, a) * glm::dot(b, b));
+            return lengths > 0.0f ? glm::dot(a, b) / lengths : 1.0f;
+        }
+
+        void ProcessFace(const std::vector<Vertex> & vertices, const std::vector<uint32_t> & indices, size_t t, FaceData & faces)
+        {
+            const auto & v0 = vertices[indices[t * 3 + 0]];
+            const auto & v1 = vertices[indices[t * 3 + 1]];
+            const auto & v2 = vertices[indices[t * 3 + 2]];
+
+            const auto e1 = v1.position - v0.position;
+            const auto e2 = v2.position - v0.position;
+            const auto e3 = v2.position - v1.position;
+
+            auto normal = glm::cross(e1, e2);
+            const float area = glm::length(normal);
+            normal = area > 0.0f ? normal / area : glm::vec3(0.0f);
+
+            const float du1 = v1.texcoord0.x - v0.texcoord0.x;
+            const float dv1 = v1.texcoord0.y - v0.texcoord0.y;
+            const float du2 = v2.texcoord0.x - v0.texcoord0.x;
+            const float dv2 = v2.texcoord0.y - v0.texcoord0.y;
+            const float det = du1 * dv2 - du2 * dv1;
+
+            // Scaled by det, which cancels out in the handedness and only flips the tangent's direction.
+            auto tangent = e1 * dv2 - e2 * dv1;
+            const auto bitangent = e2 * du1 - e1 * du2;
+            const float tangentLength = glm::length(tangent);
+
+            float sign = 0.0f;
+
+            if (det != 0.0f && tangentLength > 0.0f)
+            {
+                sign = glm::dot(glm::cross(normal, tangent), bitangent) < 0.0f ? -1.0f : 1.0f;
+                tangent *= (det < 0.0f ? -1.0f : 1.0f) / tangentLength;
+            }
+            else
+            {
+                tangent = glm::vec3(0.0f);
+            }
+
+            faces.normalX[t] = normal.x;
+            faces.normalY[t] = normal.y;
+            faces.normalZ[t] = normal.z;
+            faces.tangentX[t] = tangent.x;
+            faces.tangentY[t] = tangent.y;
+            faces.tangentZ[t] = tangent.z;
+            faces.sign[t] = sign;
+            faces.angle[0][t] = FastAcos(SafeCos(e1, e2));
+            faces.angle[1][t] = FastAcos(SafeCos(-e1, e3));
+            faces.angle[2][t] = FastAcos(SafeCos(e2, e3));
+        }
+
+#ifdef TANGENT_SPACE_SSE
+        struct Vec3x4
+        {
+            __m128 x, y, z;
+        };
+
+        inline Vec3x4 Sub(const Vec3x4 & a, const Vec3x4 & b)
+        {
+            return { _mm_sub_ps(a.x, b.x), _mm_sub_ps(a.y, b.y), _mm_sub_ps(a.z, b.z) };
+        }
+
+        inline Vec3x4 Scale(const Vec3x4 & a, __m128 s)
+        {
+            return { _mm_mul_ps(a.x, s), _mm_mul_ps(a.y, s), _mm_mul_ps(a.z, s) };
+        }
+
+        inline __m128 Dot(const Vec3x4 & a, const Vec3x4 & b)
+        {
+            return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.x, b.x), _mm_mul_ps(a.y, b.y)), _mm_mul_ps(a.z, b.z));
+        }
+
+        inline Vec3x4 Cross(const Vec3x4 & a, const Vec3x4 & b)
+        {
+            return
+            {
+                _mm_sub_ps(_mm_mul_ps(a.y, b.z), _mm_mul_ps(a.z, b.y)),
+                _mm_sub_ps(_mm_mul_ps(a.z, b.x), _mm_mul_ps(a.x, b.z)),
+                _mm_sub_ps(_mm_mul_ps(a.x, b.y), _mm_mul_ps(a.y, b.x))
+            };
+        }
+
+        // Returns a / b, or zero where b is not positive.
+        inline __m128 SafeDiv(__m128 a, __m128 b)
+        {
+            const __m128 valid = _mm_cmpgt_ps(b, _mm_setzero_ps());
+            return _mm_and_ps(valid, _mm_div_ps(a, _mm_or_ps(b, _mm_andnot_ps(valid, _mm_set1_ps(1.0f)))));
+        }
+
+        inline __m128 FastAcos4(__m128 x)
+        {
+            const __m128 one = _mm_set1_ps(1.0f);
+            x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-1.0f)), one);
+
+            const __m128 negative = _mm_cmplt_ps(x, _mm_setzero_ps());
+            const __m128 a = _mm_andnot_ps(_mm_set1_ps(-0.0f), x);
+
+            __m128 p = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(-0.0187293f), a), _mm_set1_ps(0.0742610f));
+            p = _mm_add_ps(_mm_mul_ps(p, a), _mm_set1_ps(-0.2121144f));
+            p = _mm_add_ps(_mm_mul_ps(p, a), _mm_set1_ps(1.5707288f));
+
+            const __m128 r = _mm_mul_ps(_mm_sqrt_ps(_mm_sub_ps(one, a)), p);
+            return _mm_or_ps(_mm_and_ps(negative, _mm_sub_ps(_mm_set1_ps(Pi), r)), _mm_andnot_ps(negative, r));
+        }
+
+        inline __m128 Cos4(const Vec3x4 & a, const Vec3x4 & b)
+        {
+            const __m128 lengths = _mm_sqrt_ps(_mm_mul_ps(Dot(a, a), Dot(b, b)));
+            const __m128 valid = _mm_cmpgt_ps(lengths, _mm_setzero_ps());
+            return _mm_or_ps(SafeDiv(Dot(a, b), lengths), _mm_andnot_ps(valid, _mm_set1_ps(1.0f)));
+        }
+
+        void ProcessFaces4(const std::vector<Vertex> & vertices, const std::vector<uint32_t> & indices, size_t t, FaceData & faces)
+        {
+            alignas(16) float gathered[3][5][4];
+
+            for (int lane = 0; lane < 4; lane++)
+            {
+                for (int k = 0; k < 3; k++)
+                {
+                    const auto & v = vertices[indices[(t + lane) * 3 + k]];
+                    gathered[k][0][lane] = v.position.x;
+                    gathered[k][1][lane] = v.position.y;
+                    gathered[k][2][lane] = v.position.z;
+                    gathered[k][3][lane] = v.texcoord0.x;
+                    gathered[k][4][lane] = v.texcoord0.y;
+                }
+            }
+
+            Vec3x4 p[3];
+            __m128 u[3], v[3];
+
+            for (int k = 0; k < 3; k++)
+            {
+                p[k] = { _mm_load_ps(gathered[k][0]), _mm_load_ps(gathered[k][1]), _mm_load_ps(gathered[k][2]) };
+                u[k] = _mm_load_ps(gathered[k][3]);
+                v[k] = _mm_load_ps(gathered[k][4]);
+            }
+
+            const auto e1 = Sub(p[1], p[0]);
+            const auto e2 = Sub(p[2], p[0]);
+            const auto e3 = Sub(p[2], p[1]);
+
+            auto normal = Cross(e1, e2);
+            const __m128 area = _mm_sqrt_ps(Dot(normal, normal));
+            normal = Scale(normal, SafeDiv(_mm_set1_ps(1.0f), area));
+
+            const __m128 du1 = _mm_sub_ps(u[1], u[0]);
+            const __m128 dv1 = _mm_sub_ps(v[1], v[0]);
+            const __m128 du2 = _mm_sub_ps(u[2], u[0]);
+            const __m128 dv2 = _mm_sub_ps(v[2], v[0]);
+            const __m128 det = _mm_sub_ps(_mm_mul_ps(du1, dv2), _mm_mul_ps(du2, dv1));
+
+            const auto tangentRaw = Sub(Scale(e1, dv2), Scale(e2, dv1));
+            const auto bitangent = Sub(Scale(e2, du1), Scale(e1, du2));
+            const __m128 tangentLength = _mm_sqrt_ps(Dot(tangentRaw, tangentRaw));
+
+            const __m128 signMask = _mm_set1_ps(-0.0f);
+            const __m128 valid = _mm_andnot_ps(_mm_cmpeq_ps(det, _mm_setzero_ps()), _mm_cmpgt_ps(tangentLength, _mm_setzero_ps()));
+
+            // Flip by the sign of det, then normalise.
+            const __m128 detSign = _mm_and_ps(det, signMask);
+            const __m128 inverseLength = _mm_xor_ps(SafeDiv(_mm_set1_ps(1.0f), tangentLength), detSign);
+            auto tangent = Scale(tangentRaw, _mm_and_ps(valid, inverseLength));
+
+            const __m128 handedness = Dot(Cross(normal, tangentRaw), bitangent);
+            const __m128 sign = _mm_and_ps(valid, _mm_or_ps(_mm_set1_ps(1.0f), _mm_and_ps(handedness, signMask)));
+
+            const Vec3x4 negE1 = Scale(e1, _mm_set1_ps(-1.0f));
+
+            _mm_storeu_ps(&faces.normalX[t], normal.x);
+            _mm_storeu_ps(&faces.normalY[t], normal.y);
+            _mm_storeu_ps(&faces.normalZ[t], normal.z);
+            _mm_storeu_ps(&faces.tangentX[t], tangent.x);
+            _mm_storeu_ps(&faces.tangentY[t], tangent.y);
+            _mm_storeu_ps(&faces.tangentZ[t], tangent.z);
+            _mm_storeu_ps(&faces.sign[t], sign);
+            _mm_storeu_ps(&faces.angle[0][t], FastAcos4(Cos4(e1, e2)));
+            _mm_storeu_ps(&faces.angle[1][t], FastAcos4(Cos4(negE1, e3)));
+            _mm_storeu_ps(&faces.angle[2][t], FastAcos4(Cos4(e2, e3)));
+        }
+
+        struct Vec3x8
+        {
+            __m256 x, y, z;
+        };
+
+        TANGENT_SPACE_TARGET("avx")
+        inline Vec3x8 Sub(const Vec3x8 & a, const Vec3x8 & b)
+        {
+            return { _mm256_sub_ps(a.x, b.x), _mm256_sub_ps(a.y, b.y), _mm256_sub_ps(a.z, b.z) };
+        }
+
+        TANGENT_SPACE_TARGET("avx")
+        inline Vec3x8 Scale(const Vec3x8 & a, __m256 s)
+        {
+            return { _mm256_mul_ps(a.x, s), _mm256_mul_ps(a.y, s), _mm256_mul_ps(a.z, s) };
+        }
+
+        TANGENT_SPACE_TARGET("avx")
+        inline __m256 Dot(const Vec3x8 & a, const Vec3x8 & b)
+        {
+            return _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(a.x, b.x), _mm256_mul_ps(a.y, b.y)), _mm256_mul_ps(a.z, b.z));
+        }
+
+        TANGENT_SPACE_TARGET("avx")
+        inline Vec3x8 Cross(const Vec3x8 & a, const Vec3x8 & b)
+        {
+            return
+            {
+                _mm256_sub_ps(_mm256_mul_ps(a.y, b.z), _mm256_mul_ps(a.z, b.y)),
+                _mm256_sub_ps(_mm256_mul_ps(a.z, b.x), _mm256_mul_ps(a.x, b.z)),
+                _mm256_sub_ps(_mm256_mul_ps(a.x, b.y), _mm256_mul_ps(a.y, b.x))
+            };
+        }
+
+        // 1 / sqrt(x) from the estimate and one Newton step, about 23 bits, and zero where x is too
+        // small to normalise. 256-bit divides and square roots run at half the rate of 128-bit ones on
+        // most cores, so the AVX path avoids them.
+        TANGENT_SPACE_TARGET("avx")
+        inline __m256 InverseSqrt(__m256 x)
+        {
+            const __m256 r = _mm256_rsqrt_ps(x);
+            const __m256 refined = _mm256_mul_ps(r, _mm256_sub_ps(_mm256_set1_ps(1.5f), _mm256_mul_ps(_mm256_mul_ps(_mm256_set1_ps(0.5f), x), _mm256_mul_ps(r, r))));
+            return _mm256_and_ps(_mm256_cmp_ps(x, _mm256_set1_ps(FLT_MIN), _CMP_GE_OQ), refined);
+        }
+
+        TANGENT_SPACE_TARGET("avx")
+        inline __m256 FastAcos8(__m256 x)
+        {
+            const __m256 one = _mm256_set1_ps(1.0f);
+            x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-1.0f)), one);
+
+            const __m256 negative = _mm256_cmp_ps(x, _mm256_setzero_ps(), _CMP_LT_OQ);
+            const __m256 a = _mm256_andnot_ps(_mm256_set1_ps(-0.0f), x);
+
+            __m256 p = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(-0.0187293f), a), _mm256_set1_ps(0.0742610f));
+            p = _mm256_add_ps(_mm256_mul_ps(p, a), _mm256_set1_ps(-0.2121144f));
+            p = _mm256_add_ps(_mm256_mul_ps(p, a), _mm256_set1_ps(1.5707288f));
+
+            const __m256 d = _mm256_sub_ps(one, a);
+            const __m256 r = _mm256_mul_ps(_mm256_mul_ps(d, InverseSqrt(d)), p);
+            return _mm256_blendv_ps(r, _mm256_sub_ps(_mm256_set1_ps(Pi), r), negative);
+        }
+
+        TANGENT_SPACE_TARGET("avx")
+        inline __m256 Cos8(const Vec3x8 & a, const Vec3x8 & b)
+        {
+            const __m256 lengths = _mm256_mul_ps(Dot(a, a), Dot(b, b));
+            const __m256 valid = _mm256_cmp_ps(lengths, _mm256_set1_ps(FLT_MIN), _CMP_GE_OQ);
+            return _mm256_blendv_ps(_mm256_set1_ps(1.0f), _mm256_mul_ps(Dot(a, b), InverseSqrt(lengths)), valid);
+        }
+
+        // Corner k of eight faces, transposed in registers. The position is read as four floats, the
+        // fourth being colour.r, and lanes j and j + 4 share a register until the in-lane shuffles.
+        TANGENT_SPACE_TARGET("avx")
+        inline void GatherCorner8(const Vertex * vertices, const uint32_t * corners, Vec3x8 & p, __m256 & u, __m256 & v)
+        {
+            const Vertex * c[8];
+
+            for (int lane = 0; lane < 8; lane++)
+            {
+                c[lane] = vertices + corners[lane * 3];
+            }
+
+            __m256 rows[4];
+
+            for (int j = 0; j < 4; j++)
+            {
+                rows[j] = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(&c[j]->position.x)), _mm_loadu_ps(&c[j + 4]->position.x), 1);
+            }
+
+            const __m256 xy01 = _mm256_unpacklo_ps(rows[0], rows[1]);
+            const __m256 xy23 = _mm256_unpacklo_ps(rows[2], rows[3]);
+            const __m256 zw01 = _mm256_unpackhi_ps(rows[0], rows[1]);
+            const __m256 zw23 = _mm256_unpackhi_ps(rows[2], rows[3]);
+
+            p.x = _mm256_shuffle_ps(xy01, xy23, _MM_SHUFFLE(1, 0, 1, 0));
+            p.y = _mm256_shuffle_ps(xy01, xy23, _MM_SHUFFLE(3, 2, 3, 2));
+            p.z = _mm256_shuffle_ps(zw01, zw23, _MM_SHUFFLE(1, 0, 1, 0));
+
+            // Texcoords of lanes a and a + 1 as u, v, u, v.
+            const auto pair = [&c](int a)
+            {
+                return _mm_castpd_ps(_mm_loadh_pd(_mm_load_sd((const double *)&c[a]->texcoord0), (const double *)&c[a + 1]->texcoord0));
+            };
+
+            const __m256 uv0145 = _mm256_insertf128_ps(_mm256_castps128_ps256(pair(0)), pair(4), 1);
+            const __m256 uv2367 = _mm256_insertf128_ps(_mm256_castps128_ps256(pair(2)), pair(6), 1);
+
+            u = _mm256_shuffle_ps(uv0145, uv2367, _MM_SHUFFLE(2, 0, 2, 0));
+            v = _mm256_shuffle_ps(uv0145, uv2367, _MM_SHUFFLE(3, 1, 3, 1));
+        }
+
+        // ProcessFaces4 for eight faces at once.
+        TANGENT_SPACE_TARGET("avx")
+        void ProcessFaces8(const std::vector<Vertex> & vertices, const std::vector<uint32_t> & indices, size_t t, FaceData & faces)
+        {
+            Vec3x8 p[3];
+            __m256 u[3], v[3];
+
+            for (int k = 0; k < 3; k++)
+            {
+                GatherCorner8(vertices.data(), &indices[t * 3 + k], p[k], u[k], v[k]);
+            }
+
+            const auto e1 = Sub(p[1], p[0]);
+            const auto e2 = Sub(p[2], p[0]);
+            const auto e3 = Sub(p[2], p[1]);
+
+            auto normal = Cross(e1, e2);
+            normal = Scale(normal, InverseSqrt(Dot(normal, normal)));
+
+            const __m256 du1 = _mm256_sub_ps(u[1], u[0]);
+            const __m256 dv1 = _mm256_sub_ps(v[1], v[0]);
+            const __m256 du2 = _mm256_sub_ps(u[2], u[0]);
+            const __m256 dv2 = _mm256_sub_ps(v[2], v[0]);
+            const __m256 det = _mm256_sub_ps(_mm256_mul_ps(du1, dv2), _mm256_mul_ps(du2, dv1));
+
+            const auto tangentRaw = Sub(Scale(e1, dv2), Scale(e2, dv1));
+            const auto bitangent = Sub(Scale(e2, du1), Scale(e1, du2));
+            const __m256 inverseLength = InverseSqrt(Dot(tangentRaw, tangentRaw));
+
+            const __m256 signMask = _mm256_set1_ps(-0.0f);
+            const __m256 valid = _mm256_and_ps(
+                _mm256_cmp_ps(det, _mm256_setzero_ps(), _CMP_NEQ_UQ),
+                _mm256_cmp_ps(inverseLength, _mm256_setzero_ps(), _CMP_GT_OQ));
+
+            // Flip by the sign of det, then normalise.
+            const __m256 detSign = _mm256_and_ps(det, signMask);
+            auto tangent = Scale(tangentRaw, _mm256_and_ps(valid, _mm256_xor_ps(inverseLength, detSign)));
+
+            const __m256 handedness = Dot(Cross(normal, tangentRaw), bitangent);
+            const __m256 sign = _mm256_and_ps(valid, _mm256_or_ps(_mm256_set1_ps(1.0f), _mm256_and_ps(handedness, signMask)));
+
+            const Vec3x8 negE1 = Scale(e1, _mm256_set1_ps(-1.0f));
+
+            _mm256_storeu_ps(&faces.normalX[t], normal.x);
+            _mm256_storeu_ps(&faces.normalY[t], normal.y);
+            _mm256_storeu_ps(&faces.normalZ[t], normal.z);
+            _mm256_storeu_ps(&faces.tangentX[t], tangent.x);
+            _mm256_storeu_ps(&faces.tangentY[t], tangent.y);
+            _mm256_storeu_ps(&faces.tangentZ[t], tangent.z);
+            _mm256_storeu_ps(&faces.sign[t], sign);
+            _mm256_storeu_ps(&faces.angle[0][t], FastAcos8(Cos8(e1, e2)));
+            _mm256_storeu_ps(&faces.angle[1][t], FastAcos8(Cos8(negE1, e3)));
+            _mm256_storeu_ps(&faces.angle[2][t], FastAcos8(Cos8(e2, e3)));
+        }
+#endif
+
+        // Fills Width consecutive faces per call.
+        struct FaceKernel
+        {
+            void (*Process)(const std::vector<Vertex> & vertices, const std::vector<uint32_t> & indices, size_t t, FaceData & faces);
+            size_t Width;
+        };
+
+        FaceKernel ChooseFaceKernel(const Util::Cpu::Features & features)
+        {
+            FaceKernel kernel = { ProcessFace, 1 };
+
+#ifdef TANGENT_SPACE_SSE
+            if (features.Sse2)
+            {
+                kernel = { ProcessFaces4, 4 };
+            }
+
+            if (features.Avx)
+            {
+                kernel = { ProcessFaces8, 8 };
+            }
+#endif
+
+            return kernel;
+        }
+
+        glm::vec3 AnyPerpendicular(const glm::vec3 & n)
+        {
+            const auto axis = fabsf(n.x) < 0.9f ? glm::vec3(1.0f, 0.0f, 0.0f) : glm::vec3(0.0f, 1.0f, 0.0f);
+            return glm::normalize(glm::cross(n, axis));
+        }
+    }
+
+    void TangentSpace::Generate(std::vector<Vertex> & vertices, const std::vector<uint32_t> & indices, bool generateNormals)
+    {
+        const size_t triangleCount = indices.size() / 3;
+
+        if (triangleCount == 0)
+        {
+            return;
+        }
+
+        auto pool = Util::Threading::ThreadPool::GetInstance();
+
+        static const FaceKernel kernel = ChooseFaceKernel(Util::Cpu::Current());
+
+        FaceData faces;
+        faces.Resize(triangleCount);
+
+        pool->ParallelFor(triangleCount, TrianglesPerTask, [&](size_t begin, size_t end)
+        {
+            size_t t = begin;
+
+            for (; t + kernel.Width <= end; t += kernel.Width)
+            {
+                kernel.Process(vertices, indices, t, faces);
+            }
+
+            for (; t < end; t++)
+            {
+                ProcessFace(vertices, indices, t, faces);
+            }
+        });
+
+        // Corners around each vertex, packed as offsets + list, so the gather below needs no atomics.
+        std::vector<uint32_t> cornerOffsets(vertices.size() + 1, 0);
+        std::vector<uint32_t> corners(triangleCount * 3);
+
+        for (size_t i = 0; i < triangleCount * 3; i++)
+        {
+            cornerOffsets[indices[i] + 1]++;
+        }
+
+        for (size_t i = 0; i < vertices.size(); i++)
+        {
+            cornerOffsets[i + 1] += cornerOffsets[i];
+        }
+
+        {
+            std::vector<uint32_t> fill(cornerOffsets.begin(), cornerOffsets.end() - 1);
+
+            for (size_t i = 0; i < triangleCount * 3; i++)
+            {
+                corners[fill[indices[i]]++] = (uint32_t)i;
+            }
+        }
+
+        pool->ParallelFor(vertices.size(), VerticesPerTask, [&](size_t begin, size_t end)
+        {
+            for (size_t i = begin; i < end; i++)
+            {
+                auto & vertex = vertices[i];
+
+                if (generateNormals)
+                {
+                    glm::vec3 normal(0.0f);
+
+                    for (uint32_t c = cornerOffsets[i]; c < cornerOffsets[i + 1]; c++)
+                    {
+                        const auto t = corners[c] / 3;
+                        const float weight = faces.angle[corners[c] % 3][t];
+                        normal += glm::vec3(faces.normalX[t], faces.normalY[t], faces.normalZ[t]) * weight;
+                    }
+
+                    const float length = glm::length(normal);
+                    vertex.normal = length > 0.0f ? normal / length : glm::vec3(0.0f, 0.0f, 1.0f);
+                }
+
+                const auto n = vertex.normal;
+
+                glm::vec3 tangent(0.0f);
+                float sign = 0.0f;
+
+                for (uint32_t c = cornerOffsets[i]; c < cornerOffsets[i + 1]; c++)
+                {
+                    const auto t = corners[c] / 3;
+                    const float weight = faces.angle[corners[c] % 3][t];
+
+                    auto faceTangent = glm::vec3(faces.tangentX[t], faces.tangentY[t], faces.tangentZ[t]);
+                    faceTangent -= n * glm::dot(n, faceTangent);
+
+                    const float length = glm::length(faceTangent);
+
+                    if (length > 0.0f)
+                    {
+                        tangent += faceTangent * (weight / length);
+                        sign += faces.sign[t] * weight;
+                    }
+                }
+
+                // Gram-Schmidt once more since the weighted sum is only approximately in the plane.
+                tangent -= n * glm::dot(n, tangent);
+                const float length = glm::length(tangent);
+
+                vertex.tangent = length > 0.0f ? tangent / length : AnyPerpendicular(n);
+                vertex.bitangent = glm::cross(n, vertex.tangent) * (sign < 0.0f ? -1.0f : 1.0f);
+            }
+        });
+    }
+}
@@ -0,0 +1,19 @@
+#ifndef TANGENTSPACE_H
+#define TANGENTSPACE_H
+#include <stdint.h>
+#include <vector>
+#include "vertex.h"
+
+namespace Graphics
+{
+    class TangentSpace
+    {
+    public:
+        // Fills tangent and bitangent following MikkTSpace's conventions: per corner tangents are projected
+        // onto the vertex normal and weighted by corner angle, and the bitangent is cross(normal, tangent)
+        // flipped for mirrored UVs. With generateNormals the normals are rebuilt first as angle weighted
+        // face normals. Vertices already split in the input (hard edges, UV seams) stay split.
+        static void Generate(std::vector<Vertex> & vertices, const std::vector<uint32_t> & indices, bool generateNormals);
+    };
+}
+#endif // !TANGENTSPACE_H
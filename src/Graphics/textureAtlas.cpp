@@ -0,0 +1,252 @@
+#include "textureAtlas.h"
+#include <string.h>
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+#include <string>
+
+namespace Graphics
+{
+    SkylinePacker::SkylinePacker(uint32_t width, uint32_t height) :
+        width(width),
+        height(height)
+    {
+        skyline.push_back({ 0, 0, width });
+    }
+
+    bool SkylinePacker::Fits(size_t index, uint32_t width, uint32_t height, uint32_t & y) const
+    {
+        if (skyline[index].X + width > this->width)
+        {
+            return false;
+        }
+
+        // The rectangle rests on the highest segment it spans.
+        uint32_t remaining = width;
+        y = 0;
+
+        for (size_t i = index; remaining > 0; i++)
+        {
+            y = std::max(y, skyline[i].Y);
+
+            if (y + height > this->height)
+            {
+                return false;
+            }
+
+            remaining -= std::min(remaining, skyline[i].Width);
+        }
+
+        return true;
+    }
+
+    bool SkylinePacker::Pack(uint32_t width, uint32_t height, uint32_t & x, uint32_t & y)
+    {
+        size_t best = skyline.size();
+        uint32_t bestTop = UINT32_MAX;
+        uint32_t bestY = 0;
+
+        for (size_t i = 0; i < skyline.size(); i++)
+        {
+            uint32_t top;
+
+            if (!Fits(i, width, height, top))
+            {
+                continue;
+            }
+
+            // Lowest top wins, ties go to the narrower segment so wide gaps stay open.
+            if (top + height < bestTop || (top + height == bestTop && skyline[i].Width < skyline[best].Width))
+            {
+                best = i;
+                bestTop = top + height;
+                bestY = top;
+            }
+        }
+
+        if (best == skyline.size())
+        {
+            return false;
+        }
+
+        x = skyline[best].X;
+        y = bestY;
+
+        skyline.insert(skyline.begin() + best, { x, y + height, width });
+
+        // Trim whatever the new segment now covers.
+        for (size_t i = best + 1; i < skyline.size();)
+        {
+            const uint32_t end = x + width;
+
+            if (skyline[i].X >= end)
+            {
+                break;
+            }
+
+            const uint32_t covered = end - skyline[i].X;
+
+            if (skyline[i].Width <= covered)
+            {
+                skyline.erase(skyline.begin() + i);
+                continue;
+            }
+
+            skyline[i].X += covered;
+            skyline[i].Width -= covered;
+            break;
+        }
+
+        for (size_t i = 0; i + 1 < skyline.size();)
+        {
+            if (skyline[i].Y == skyline[i + 1].Y)
+            {
+                skyline[i].Width += skyline[i + 1].Width;
+                skyline.erase(skyline.begin() + i + 1);
+            }
+            else
+            {
+                i++;
+            }
+        }
+
+        usedArea += (uint64_t)width * height;
+        return true;
+    }
+
+    float SkylinePacker::Occupancy() const
+    {
+        return (float)((double)usedArea / ((double)width * height));
+    }
+
+    TextureAtlas::TextureAtlas(uint32_t pageSize, uint32_t padding) :
+        pageSize(pageSize),
+        padding(padding)
+    {
+        // The mip filters read up to two texels of the level being built past an edge, so a level
+        // is clean while the gutter, halved once per level, is still that wide.
+        levelCount = 1;
+
+        while ((2u << levelCount) <= padding)
+        {
+            levelCount++;
+        }
+
+        // Cells start on a 4x4 block of the smallest clean level.
+        alignment = 4u << (levelCount - 1);
+
+        if (pageSize == 0 || pageSize % alignment != 0)
+        {
+            throw std::invalid_argument("Atlas page size must be a multiple of " + std::to_string(alignment));
+        }
+    }
+
+    std::vector<AtlasRegion> TextureAtlas::Build(const std::vector<AtlasImage> & images)
+    {
+        packers.clear();
+        pages.clear();
+
+        // Tallest first keeps the skyline flat.
+        std::vector<size_t> order(images.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&images](size_t a, size_t b)
+        {
+            return images[a].Height != images[b].Height ? images[a].Height > images[b].Height : images[a].Width > images[b].Width;
+        });
+
+        std::vector<AtlasRegion> regions(images.size());
+        const uint32_t cellsPerSide = pageSize / alignment;
+
+        for (const size_t index : order)
+        {
+            const auto & image = images[index];
+
+            // The packer works in whole cells, which keeps every position aligned for free.
+            const uint32_t cellsX = (image.Width + 2 * padding + alignment - 1) / alignment;
+            const uint32_t cellsY = (image.Height + 2 * padding + alignment - 1) / alignment;
+
+            if (image.Width == 0 || image.Height == 0 || cellsX > cellsPerSide || cellsY > cellsPerSide)
+            {
+                throw std::runtime_error("Image of " + std::to_string(image.Width) + "x" + std::to_string(image.Height) + " does not fit an atlas page");
+            }
+
+            uint32_t page = 0;
+            uint32_t cellX;
+            uint32_t cellY;
+
+            while (page < packers.size() && !packers[page].Pack(cellsX, cellsY, cellX, cellY))
+            {
+                page++;
+            }
+
+            if (page == packers.size())
+            {
+                packers.emplace_back(cellsPerSide, cellsPerSide);
+                pages.emplace_back((size_t)pageSize * pageSize * 4, 0);
+                packers.back().Pack(cellsX, cellsY, cellX, cellY);
+            }
+
+            auto & region = regions[index];
+            region.Page = page;
+            region.X = cellX * alignment + padding;
+            region.Y = cellY * alignment + padding;
+            region.Width = image.Width;
+            region.Height = image.Height;
+            region.Offset = glm::vec2(region.X, region.Y) / (float)pageSize;
+            region.Scale = glm::vec2(region.Width, region.Height) / (float)pageSize;
+
+            Blit(image, pages[page].data(), region.X, region.Y);
+        }
+
+        return regions;
+    }
+
+    void TextureAtlas::Blit(const AtlasImage & image, uint8_t * page, uint32_t x, uint32_t y)
+    {
+        const size_t rowBytes = (size_t)image.Width * 4;
+
+        for (int32_t row = -(int32_t)padding; row < (int32_t)(image.Height + padding); row++)
+        {
+            const uint32_t sourceRow = (uint32_t)std::min(std::max(row, 0), (int32_t)image.Height - 1);
+            const uint8_t * source = image.Pixels + sourceRow * rowBytes;
+            uint8_t * destination = page + ((size_t)(y + row) * pageSize + x) * 4;
+
+            memcpy(destination, source, rowBytes);
+
+            // The gutter repeats the edge texels.
+            for (uint32_t i = 1; i <= padding; i++)
+            {
+                memcpy(destination - i * 4, source, 4);
+                memcpy(destination + rowBytes + (i - 1) * 4, source + rowBytes - 4, 4);
+            }
+        }
+    }
+
+    const std::vector<std::vector<uint8_t>> & TextureAtlas::Pages() const
+    {
+        return pages;
+    }
+
+    uint32_t TextureAtlas::PageSize() const
+    {
+        return pageSize;
+    }
+
+    uint32_t TextureAtlas::LevelCount() const
+    {
+        return levelCount;
+    }
+
+    float TextureAtlas::Occupancy(uint32_t page) const
+    {
+        return packers.at(page).Occupancy();
+    }
+
+    void TextureAtlas::RemapTexcoords(std::vector<Vertex> & vertices, size_t first, size_t count, const AtlasRegion & region)
+    {
+        for (size_t i = first; i < first + count && i < vertices.size(); i++)
+        {
+            vertices[i].texcoord0 = region.Remap(vertices[i].texcoord0);
+        }
+    }
+}
@@ -0,0 +1,96 @@
+#ifndef TEXTUREATLAS_H
+#define TEXTUREATLAS_H
+#include "vertex.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace Graphics
+{
+    // Where one image ended up: its page, its texels within the page, and the transform from the
+    // image's own UVs to the page's.
+    struct AtlasRegion
+    {
+        uint32_t Page;
+        uint32_t X;
+        uint32_t Y;
+        uint32_t Width;
+        uint32_t Height;
+        glm::vec2 Offset;
+        glm::vec2 Scale;
+
+        glm::vec2 Remap(const glm::vec2 & uv) const
+        {
+            return Offset + uv * Scale;
+        }
+    };
+
+    // Bottom-left skyline packing: the page is described by the height of its filled area along x,
+    // and each rectangle goes where its top ends up lowest.
+    class SkylinePacker
+    {
+    public:
+        SkylinePacker(uint32_t width, uint32_t height);
+
+        bool Pack(uint32_t width, uint32_t height, uint32_t & x, uint32_t & y);
+
+        // Fraction of the page covered by packed rectangles.
+        float Occupancy() const;
+
+    private:
+        struct Segment
+        {
+            uint32_t X;
+            uint32_t Y;
+            uint32_t Width;
+        };
+
+        bool Fits(size_t index, uint32_t width, uint32_t height, uint32_t & y) const;
+
+        uint32_t width;
+        uint32_t height;
+        uint64_t usedArea = 0;
+        std::vector<Segment> skyline;
+    };
+
+    // An RGBA8 image to be packed.
+    struct AtlasImage
+    {
+        const uint8_t * Pixels;
+        uint32_t Width;
+        uint32_t Height;
+    };
+
+    // Packs many small images into square RGBA8 pages so they share one image and descriptor.
+    // Every image gets a gutter of its own edge texels, and cells are aligned so neither the mip
+    // filter nor 4x4 compression blocks mix neighbours on the first LevelCount() levels.
+    class TextureAtlas
+    {
+    public:
+        TextureAtlas(uint32_t pageSize, uint32_t padding);
+
+        // Returns a region per image in input order. Images that can't fit a page throw.
+        std::vector<AtlasRegion> Build(const std::vector<AtlasImage> & images);
+
+        const std::vector<std::vector<uint8_t>> & Pages() const;
+        uint32_t PageSize() const;
+        uint32_t LevelCount() const;
+        float Occupancy(uint32_t page) const;
+
+        // Moves texcoord0 of the given vertices into the region. Atlased images can't repeat, UVs
+        // outside 0..1 would land on the neighbours.
+        static void RemapTexcoords(std::vector<Vertex> & vertices, size_t first, size_t count, const AtlasRegion & region);
+
+    private:
+        void Blit(const AtlasImage & image, uint8_t * page, uint32_t x, uint32_t y);
+
+        uint32_t pageSize;
+        uint32_t padding;
+        uint32_t levelCount;
+        uint32_t alignment;
+
+        std::vector<SkylinePacker> packers;
+        std::vector<std::vector<uint8_t>> pages;
+    };
+}
+#endif // !TEXTUREATLAS_H
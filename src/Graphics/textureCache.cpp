@@ -0,0 +1,216 @@
+#include "textureCache.h"
+#include <string.h>
+#include <stdexcept>
+
+namespace Graphics
+{
+    namespace
+    {
+        const uint64_t Prime1 = 0x9E3779B185EBCA87ull;
+        const uint64_t Prime2 = 0xC2B2AE3D27D4EB4Full;
+
+        inline uint64_t Rotate(uint64_t x, int bits)
+        {
+            return (x << bits) | (x >> (64 - bits));
+        }
+
+        inline uint64_t Round(uint64_t accumulator, uint64_t word)
+        {
+            return Rotate(accumulator + word * Prime2, 31) * Prime1;
+        }
+
+        inline uint64_t Avalanche(uint64_t h)
+        {
+            h ^= h >> 33;
+            h *= 0xFF51AFD7ED558CCDull;
+            h ^= h >> 33;
+            h *= 0xC4CEB9FE1A85EC53ull;
+            h ^= h >> 33;
+            return h;
+        }
+    }
+
+    TextureCache::TextureCache(uint64_t budget, EvictFunction evict) :
+        evict(evict)
+    {
+        stats.BudgetBytes = budget;
+    }
+
+    uint64_t TextureCache::Hash(const uint8_t * data, size_t size)
+    {
+        // Four independent lanes so the multiplies overlap, then folded together.
+        uint64_t lanes[4] = { Prime1 + Prime2, Prime2, 0, (uint64_t)0 - Prime1 };
+        size_t i = 0;
+
+        for (; i + 32 <= size; i += 32)
+        {
+            for (int l = 0; l < 4; l++)
+            {
+                uint64_t word;
+                memcpy(&word, data + i + l * 8, 8);
+                lanes[l] = Round(lanes[l], word);
+            }
+        }
+
+        uint64_t h = Rotate(lanes[0], 1) + Rotate(lanes[1], 7) + Rotate(lanes[2], 12) + Rotate(lanes[3], 18);
+        h ^= size;
+
+        for (; i < size; i += 8)
+        {
+            uint64_t word = 0;
+            memcpy(&word, data + i, size - i < 8 ? size - i : 8);
+            h = Round(h, word);
+        }
+
+        return Avalanche(h);
+    }
+
+    bool TextureCache::Acquire(const std::string & path, Id & id)
+    {
+        const auto found = byPath.find(path);
+
+        if (found == byPath.end())
+        {
+            return false;
+        }
+
+        id = found->second;
+
+        auto & entry = entries.at(id);
+        entry.References++;
+        Touch(entry);
+
+        stats.Hits++;
+        return true;
+    }
+
+    bool TextureCache::Acquire(const std::string & path, uint64_t contentHash, Id & id)
+    {
+        const auto found = byContent.find(contentHash);
+
+        if (found == byContent.end())
+        {
+            stats.Misses++;
+            return false;
+        }
+
+        id = found->second;
+
+        auto & entry = entries.at(id);
+        entry.References++;
+        Touch(entry);
+
+        if (byPath.emplace(path, id).second)
+        {
+            entry.Paths.push_back(path);
+        }
+
+        stats.Hits++;
+        return true;
+    }
+
+    bool TextureCache::Contains(uint64_t contentHash) const
+    {
+        return byContent.count(contentHash) != 0;
+    }
+
+    TextureCache::Id TextureCache::Insert(const std::string & path, uint64_t contentHash, uint64_t bytes)
+    {
+        if (byContent.count(contentHash) != 0)
+        {
+            throw std::logic_error("Texture is already cached: " + path);
+        }
+
+        const Id id = nextId++;
+
+        recent.push_front(id);
+
+        Entry entry;
+        entry.ContentHash = contentHash;
+        entry.Bytes = bytes;
+        entry.References = 1;
+        entry.Paths.push_back(path);
+        entry.Recent = recent.begin();
+
+        entries.emplace(id, std::move(entry));
+        byPath[path] = id;
+        byContent[contentHash] = id;
+
+        stats.ResidentBytes += bytes;
+        stats.Resident++;
+
+        Trim();
+        return id;
+    }
+
+    void TextureCache::Release(Id id)
+    {
+        auto & entry = entries.at(id);
+
+        if (entry.References == 0)
+        {
+            throw std::logic_error("Texture released more times than it was acquired");
+        }
+
+        entry.References--;
+        Trim();
+    }
+
+    void TextureCache::Resize(Id id, uint64_t bytes)
+    {
+        auto & entry = entries.at(id);
+        stats.ResidentBytes = stats.ResidentBytes - entry.Bytes + bytes;
+        entry.Bytes = bytes;
+        Trim();
+    }
+
+    void TextureCache::SetBudget(uint64_t bytes)
+    {
+        stats.BudgetBytes = bytes;
+        Trim();
+    }
+
+    TextureCacheStats TextureCache::Stats() const
+    {
+        return stats;
+    }
+
+    void TextureCache::Touch(Entry & entry)
+    {
+        recent.splice(recent.begin(), recent, entry.Recent);
+    }
+
+    void TextureCache::Trim()
+    {
+        auto candidate = recent.end();
+
+        while (stats.ResidentBytes > stats.BudgetBytes && candidate != recent.begin())
+        {
+            --candidate;
+
+            const Id id = *candidate;
+            auto found = entries.find(id);
+
+            // Referenced textures are in use by someone, keep looking further up the list.
+            if (found->second.References > 0)
+            {
+                continue;
+            }
+
+            for (const auto & path : found->second.Paths)
+            {
+                byPath.erase(path);
+            }
+
+            byContent.erase(found->second.ContentHash);
+            stats.ResidentBytes -= found->second.Bytes;
+            stats.Resident--;
+            stats.Evictions++;
+
+            candidate = recent.erase(candidate);
+            entries.erase(found);
+
+            evict(id);
+        }
+    }
+}
@@ -0,0 +1,85 @@
+#ifndef TEXTURECACHE_H
+#define TEXTURECACHE_H
+#include <stddef.h>
+#include <stdint.h>
+#include <functional>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Graphics
+{
+    struct TextureCacheStats
+    {
+        uint64_t Hits = 0;
+        uint64_t Misses = 0;
+        uint64_t Evictions = 0;
+        uint64_t ResidentBytes = 0;
+        uint64_t BudgetBytes = 0;
+        uint32_t Resident = 0;
+    };
+
+    // Book-keeping for resident textures, keyed by path and by a hash of the file contents so the same
+    // image under two names is only uploaded once. Entries nobody references stay resident until the
+    // budget is exceeded, then go least recently used first. Only the render thread touches it.
+    class TextureCache
+    {
+    public:
+        typedef uint32_t Id;
+        static constexpr Id InvalidId = 0;
+
+        // Called for each evicted texture so the backend can free its image.
+        typedef std::function<void(Id)> EvictFunction;
+
+        TextureCache(uint64_t budget, EvictFunction evict);
+
+        static uint64_t Hash(const uint8_t * data, size_t size);
+
+        // Looks a path up, adding a reference on a hit. A path that isn't known yet isn't a miss until
+        // its contents have been checked too.
+        bool Acquire(const std::string & path, Id & id);
+
+        // Looks contents up, remembering path as another name for them on a hit.
+        bool Acquire(const std::string & path, uint64_t contentHash, Id & id);
+
+        bool Contains(uint64_t contentHash) const;
+
+        // Adds a newly uploaded texture with one reference held by the caller, then evicts down to budget.
+        Id Insert(const std::string & path, uint64_t contentHash, uint64_t bytes);
+
+        void Release(Id id);
+
+        // A texture's image changed size, e.g. streamed mips arrived or were dropped.
+        void Resize(Id id, uint64_t bytes);
+
+        void SetBudget(uint64_t bytes);
+
+        TextureCacheStats Stats() const;
+
+    private:
+        struct Entry
+        {
+            uint64_t ContentHash;
+            uint64_t Bytes;
+            uint32_t References;
+            std::vector<std::string> Paths;
+            std::list<Id>::iterator Recent;
+        };
+
+        void Touch(Entry & entry);
+        void Trim();
+
+        EvictFunction evict;
+        TextureCacheStats stats;
+        Id nextId = 1;
+
+        std::unordered_map<Id, Entry> entries;
+        std::unordered_map<std::string, Id> byPath;
+        std::unordered_map<uint64_t, Id> byContent;
+
+        // Most recently used at the front.
+        std::list<Id> recent;
+    };
+}
+#endif // !TEXTURECACHE_H
@@ -0,0 +1,455 @@
+#include "textureContainer.h"
+#include <string.h>
+#include <algorithm>
+#include <cctype>
+#include <stdexcept>
+
+namespace Graphics
+{
+    namespace
+    {
+        struct FormatInfo
+        {
+            VkFormat Format;
+            uint32_t BlockDim;
+            uint32_t BlockBytes;
+
+            // DXGI_FORMAT used by DDS DX10 headers, 0 where there is no exact match.
+            uint32_t Dxgi;
+        };
+
+        const FormatInfo Formats[] =
+        {
+            { VK_FORMAT_R8G8B8A8_UNORM, 1, 4, 28 },
+            { VK_FORMAT_R8G8B8A8_SRGB, 1, 4, 29 },
+            { VK_FORMAT_B8G8R8A8_UNORM, 1, 4, 87 },
+            { VK_FORMAT_B8G8R8A8_SRGB, 1, 4, 91 },
+            { VK_FORMAT_R16G16B16A16_SFLOAT, 1, 8, 10 },
+            { VK_FORMAT_R32G32B32A32_SFLOAT, 1, 16, 2 },
+            { VK_FORMAT_BC1_RGB_UNORM_BLOCK, 4, 8, 0 },
+            { VK_FORMAT_BC1_RGB_SRGB_BLOCK, 4, 8, 0 },
+            { VK_FORMAT_BC1_RGBA_UNORM_BLOCK, 4, 8, 71 },
+            { VK_FORMAT_BC1_RGBA_SRGB_BLOCK, 4, 8, 72 },
+            { VK_FORMAT_BC2_UNORM_BLOCK, 4, 16, 74 },
+            { VK_FORMAT_BC2_SRGB_BLOCK, 4, 16, 75 },
+            { VK_FORMAT_BC3_UNORM_BLOCK, 4, 16, 77 },
+            { VK_FORMAT_BC3_SRGB_BLOCK, 4, 16, 78 },
+            { VK_FORMAT_BC4_UNORM_BLOCK, 4, 8, 80 },
+            { VK_FORMAT_BC5_UNORM_BLOCK, 4, 16, 83 },
+            { VK_FORMAT_BC7_UNORM_BLOCK, 4, 16, 98 },
+            { VK_FORMAT_BC7_SRGB_BLOCK, 4, 16, 99 }
+        };
+
+        const FormatInfo * FindFormat(VkFormat format)
+        {
+            for (const auto & info : Formats)
+            {
+                if (info.Format == format)
+                {
+                    return &info;
+                }
+            }
+
+            return nullptr;
+        }
+
+        const FormatInfo * FindDxgiFormat(uint32_t dxgi)
+        {
+            for (const auto & info : Formats)
+            {
+                if (dxgi != 0 && info.Dxgi == dxgi)
+                {
+                    return &info;
+                }
+            }
+
+            return nullptr;
+        }
+
+        // Both containers are little endian, as is every platform this builds for.
+        template<typename T>
+        T Read(const uint8_t * p)
+        {
+            T value;
+            memcpy(&value, p, sizeof(T));
+            return value;
+        }
+
+        constexpr uint32_t FourCC(char a, char b, char c, char d)
+        {
+            return (uint32_t)(uint8_t)a | ((uint32_t)(uint8_t)b << 8) | ((uint32_t)(uint8_t)c << 16) | ((uint32_t)(uint8_t)d << 24);
+        }
+
+        const uint8_t Ktx2Identifier[12] = { 0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n' };
+        const size_t Ktx2HeaderSize = 80;
+        const size_t Ktx2LevelEntrySize = 24;
+
+        const uint32_t DdsMagic = FourCC('D', 'D', 'S', ' ');
+        const size_t DdsHeaderSize = 124;
+        const size_t DdsDx10HeaderSize = 20;
+        const uint32_t DdsMipMapCountFlag = 0x20000;
+        const uint32_t DdsDepthFlag = 0x800000;
+        const uint32_t DdsPixelFormatFourCC = 0x4;
+        const uint32_t DdsPixelFormatRgb = 0x40;
+        const uint32_t DdsCubemap = 0x200;
+        const uint32_t DdsCubemapAllFaces = 0xFC00;
+        const uint32_t DxgiDimensionTexture2D = 3;
+        const uint32_t DxgiMiscTextureCube = 0x4;
+    }
+
+    TextureContainer::TextureContainer(const std::string & path) :
+        file(path),
+        path(path)
+    {
+        const uint8_t * data = file.Data();
+
+        if (file.Size() >= sizeof(Ktx2Identifier) && memcmp(data, Ktx2Identifier, sizeof(Ktx2Identifier)) == 0)
+        {
+            ParseKtx2();
+        }
+        else if (file.Size() >= 4 && Read<uint32_t>(data) == DdsMagic)
+        {
+            ParseDds();
+        }
+        else
+        {
+            throw std::runtime_error("Unrecognised texture container: " + path);
+        }
+    }
+
+    bool TextureContainer::IsContainer(const std::string & path)
+    {
+        const auto dot = path.find_last_of('.');
+
+        if (dot == std::string::npos)
+        {
+            return false;
+        }
+
+        std::string extension = path.substr(dot + 1);
+        std::transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return (char)tolower(c); });
+
+        return extension == "ktx2" || extension == "dds";
+    }
+
+    uint32_t TextureContainer::Width() const
+    {
+        return width;
+    }
+
+    uint32_t TextureContainer::Height() const
+    {
+        return height;
+    }
+
+    uint32_t TextureContainer::LayerCount() const
+    {
+        return layers;
+    }
+
+    VkFormat TextureContainer::Format() const
+    {
+        return format;
+    }
+
+    const std::vector<MipLevel> & TextureContainer::Levels() const
+    {
+        return levels;
+    }
+
+    std::vector<MipLevel> TextureContainer::Levels(uint32_t firstLevel) const
+    {
+        if (firstLevel >= levels.size())
+        {
+            throw std::out_of_range("Texture container level out of range: " + path);
+        }
+
+        std::vector<MipLevel> tail(levels.begin() + firstLevel, levels.end());
+
+        for (auto & level : tail)
+        {
+            level.Offset -= levels[firstLevel].Offset;
+        }
+
+        return tail;
+    }
+
+    uint64_t TextureContainer::UploadSize() const
+    {
+        return MipChain::TotalSize(levels);
+    }
+
+    uint64_t TextureContainer::UploadSize(uint32_t firstLevel) const
+    {
+        return MipChain::TotalSize(Levels(firstLevel));
+    }
+
+    void TextureContainer::CopyTo(uint8_t * destination) const
+    {
+        for (const auto & span : spans)
+        {
+            memcpy(destination + span.Destination, file.Data() + span.Source, span.Size);
+        }
+    }
+
+    void TextureContainer::CopyTo(uint8_t * destination, uint32_t firstLevel) const
+    {
+        if (firstLevel >= levels.size())
+        {
+            throw std::out_of_range("Texture container level out of range: " + path);
+        }
+
+        const uint64_t base = levels[firstLevel].Offset;
+
+        // Only the mapped pages of the levels asked for get touched.
+        for (const auto & span : spans)
+        {
+            if (span.Level >= firstLevel)
+            {
+                memcpy(destination + span.Destination - base, file.Data() + span.Source, span.Size);
+            }
+        }
+    }
+
+    void TextureContainer::BuildLayout(uint32_t levelCount)
+    {
+        if (width == 0 || height == 0)
+        {
+            throw std::runtime_error("Texture container has no pixels: " + path);
+        }
+
+        if (levelCount > MipChain::LevelCount(width, height))
+        {
+            throw std::runtime_error("Texture container has more mips than its size allows: " + path);
+        }
+
+        levels.resize(levelCount);
+        uint64_t offset = 0;
+
+        for (uint32_t l = 0; l < levelCount; l++)
+        {
+            auto & level = levels[l];
+            level.Width = std::max(width >> l, 1u);
+            level.Height = std::max(height >> l, 1u);
+            level.Offset = offset;
+
+            const uint64_t blocksX = (level.Width + blockDim - 1) / blockDim;
+            const uint64_t blocksY = (level.Height + blockDim - 1) / blockDim;
+            level.Size = blocksX * blocksY * blockBytes * layers;
+
+            offset = (offset + level.Size + 15) & ~15ull;
+        }
+    }
+
+    void TextureContainer::ParseKtx2()
+    {
+        const uint8_t * data = file.Data();
+        const uint64_t size = file.Size();
+
+        if (size < Ktx2HeaderSize)
+        {
+            throw std::runtime_error("Truncated KTX2 header: " + path);
+        }
+
+        const uint32_t vkFormat = Read<uint32_t>(data + 12);
+        width = Read<uint32_t>(data + 20);
+        height = Read<uint32_t>(data + 24);
+        const uint32_t depth = Read<uint32_t>(data + 28);
+        const uint32_t layerCount = Read<uint32_t>(data + 32);
+        const uint32_t faceCount = Read<uint32_t>(data + 36);
+        const uint32_t levelCount = Read<uint32_t>(data + 40);
+        const uint32_t supercompression = Read<uint32_t>(data + 44);
+
+        // Basis and zstd payloads would need a CPU transcode, which is what this path exists to avoid.
+        if (supercompression != 0)
+        {
+            throw std::runtime_error("Supercompressed KTX2 files are not supported: " + path);
+        }
+
+        if (depth > 1)
+        {
+            throw std::runtime_error("3D KTX2 textures are not supported: " + path);
+        }
+
+        if (faceCount != 1 && faceCount != 6)
+        {
+            throw std::runtime_error("Invalid KTX2 face count: " + path);
+        }
+
+        // A level count of 0 asks the loader to generate mips, only pre-built chains are accepted here.
+        if (levelCount == 0)
+        {
+            throw std::runtime_error("KTX2 file has no pre-built mips: " + path);
+        }
+
+        const auto info = FindFormat((VkFormat)vkFormat);
+
+        if (info == nullptr)
+        {
+            throw std::runtime_error("Unsupported KTX2 format " + std::to_string(vkFormat) + ": " + path);
+        }
+
+        format = info->Format;
+        blockDim = info->BlockDim;
+        blockBytes = info->BlockBytes;
+        layers = std::max(layerCount, 1u) * faceCount;
+
+        if (size < Ktx2HeaderSize + (uint64_t)levelCount * Ktx2LevelEntrySize)
+        {
+            throw std::runtime_error("Truncated KTX2 level index: " + path);
+        }
+
+        BuildLayout(levelCount);
+
+        // Within a level KTX2 already stores layers then faces back to back, the order Vulkan numbers
+        // array layers in, so each level is a single span.
+        for (uint32_t l = 0; l < levelCount; l++)
+        {
+            const uint8_t * entry = data + Ktx2HeaderSize + l * Ktx2LevelEntrySize;
+            const uint64_t byteOffset = Read<uint64_t>(entry);
+            const uint64_t byteLength = Read<uint64_t>(entry + 8);
+
+            if (byteLength != levels[l].Size)
+            {
+                throw std::runtime_error("KTX2 level " + std::to_string(l) + " size does not match its format: " + path);
+            }
+
+            if (byteOffset > size || byteLength > size - byteOffset)
+            {
+                throw std::runtime_error("KTX2 level " + std::to_string(l) + " lies outside the file: " + path);
+            }
+
+            spans.push_back({ byteOffset, levels[l].Offset, byteLength, l });
+        }
+    }
+
+    void TextureContainer::ParseDds()
+    {
+        const uint8_t * data = file.Data();
+        const uint64_t size = file.Size();
+
+        if (size < 4 + DdsHeaderSize || Read<uint32_t>(data + 4) != DdsHeaderSize)
+        {
+            throw std::runtime_error("Truncated DDS header: " + path);
+        }
+
+        const uint8_t * header = data + 4;
+        const uint32_t flags = Read<uint32_t>(header + 4);
+        height = Read<uint32_t>(header + 8);
+        width = Read<uint32_t>(header + 12);
+        const uint32_t depth = Read<uint32_t>(header + 20);
+        const uint32_t mipCount = Read<uint32_t>(header + 24);
+        const uint32_t pixelFlags = Read<uint32_t>(header + 76);
+        const uint32_t fourCC = Read<uint32_t>(header + 80);
+        const uint32_t bitCount = Read<uint32_t>(header + 84);
+        const uint32_t redMask = Read<uint32_t>(header + 88);
+        const uint32_t greenMask = Read<uint32_t>(header + 92);
+        const uint32_t blueMask = Read<uint32_t>(header + 96);
+        const uint32_t caps2 = Read<uint32_t>(header + 108);
+
+        if ((flags & DdsDepthFlag) && depth > 1)
+        {
+            throw std::runtime_error("3D DDS textures are not supported: " + path);
+        }
+
+        uint64_t offset = 4 + DdsHeaderSize;
+        const FormatInfo * info = nullptr;
+        layers = 1;
+
+        if ((pixelFlags & DdsPixelFormatFourCC) && fourCC == FourCC('D', 'X', '1', '0'))
+        {
+            if (size < offset + DdsDx10HeaderSize)
+            {
+                throw std::runtime_error("Truncated DDS DX10 header: " + path);
+            }
+
+            const uint32_t dxgi = Read<uint32_t>(data + offset);
+            const uint32_t dimension = Read<uint32_t>(data + offset + 4);
+            const uint32_t misc = Read<uint32_t>(data + offset + 8);
+            const uint32_t arraySize = Read<uint32_t>(data + offset + 12);
+
+            if (dimension != DxgiDimensionTexture2D)
+            {
+                throw std::runtime_error("Only 2D DDS textures are supported: " + path);
+            }
+
+            info = FindDxgiFormat(dxgi);
+            layers = std::max(arraySize, 1u) * ((misc & DxgiMiscTextureCube) ? 6 : 1);
+            offset += DdsDx10HeaderSize;
+        }
+        else if (pixelFlags & DdsPixelFormatFourCC)
+        {
+            switch (fourCC)
+            {
+            case FourCC('D', 'X', 'T', '1'):
+                info = FindFormat(VK_FORMAT_BC1_RGBA_UNORM_BLOCK);
+                break;
+            case FourCC('D', 'X', 'T', '3'):
+                info = FindFormat(VK_FORMAT_BC2_UNORM_BLOCK);
+                break;
+            case FourCC('D', 'X', 'T', '5'):
+                info = FindFormat(VK_FORMAT_BC3_UNORM_BLOCK);
+                break;
+            case FourCC('A', 'T', 'I', '1'):
+            case FourCC('B', 'C', '4', 'U'):
+                info = FindFormat(VK_FORMAT_BC4_UNORM_BLOCK);
+                break;
+            case FourCC('A', 'T', 'I', '2'):
+            case FourCC('B', 'C', '5', 'U'):
+                info = FindFormat(VK_FORMAT_BC5_UNORM_BLOCK);
+                break;
+            }
+        }
+        else if ((pixelFlags & DdsPixelFormatRgb) && bitCount == 32 && greenMask == 0xFF00)
+        {
+            if (redMask == 0xFF && blueMask == 0xFF0000)
+            {
+                info = FindFormat(VK_FORMAT_R8G8B8A8_UNORM);
+            }
+            else if (redMask == 0xFF0000 && blueMask == 0xFF)
+            {
+                info = FindFormat(VK_FORMAT_B8G8R8A8_UNORM);
+            }
+        }
+
+        if (info == nullptr)
+        {
+            throw std::runtime_error("Unsupported DDS pixel format: " + path);
+        }
+
+        if (caps2 & DdsCubemap)
+        {
+            if ((caps2 & DdsCubemapAllFaces) != DdsCubemapAllFaces)
+            {
+                throw std::runtime_error("Partial DDS cubemaps are not supported: " + path);
+            }
+
+            layers = std::max(layers, 6u);
+        }
+
+        format = info->Format;
+        blockDim = info->BlockDim;
+        blockBytes = info->BlockBytes;
+
+        BuildLayout((flags & DdsMipMapCountFlag) && mipCount > 0 ? mipCount : 1);
+
+        // DDS stores each layer's whole chain in turn, so the layers are interleaved into level order
+        // while copying.
+        for (uint32_t layer = 0; layer < layers; layer++)
+        {
+            for (uint32_t l = 0; l < levels.size(); l++)
+            {
+                const auto & level = levels[l];
+                const uint64_t layerSize = level.Size / layers;
+
+                if (offset > size || layerSize > size - offset)
+                {
+                    throw std::runtime_error("Truncated DDS pixel data: " + path);
+                }
+
+                spans.push_back({ offset, level.Offset + layer * layerSize, layerSize, l });
+                offset += layerSize;
+            }
+        }
+    }
+}
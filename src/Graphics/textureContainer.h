@@ -0,0 +1,71 @@
+#ifndef TEXTURECONTAINER_H
+#define TEXTURECONTAINER_H
+#include "graphics_includes.h"
+#include "mipChain.h"
+#include "../Utils/mappedFile.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace Graphics
+{
+    // A pre-processed KTX2 or DDS texture. The file stays mapped and the validated mips are copied
+    // straight from it into upload memory, there is no decode step.
+    class TextureContainer
+    {
+    public:
+        explicit TextureContainer(const std::string & path);
+
+        TextureContainer(const TextureContainer &) = delete;
+        TextureContainer & operator=(const TextureContainer &) = delete;
+
+        // Picks containers out by extension, anything else goes through Image.
+        static bool IsContainer(const std::string & path);
+
+        uint32_t Width() const;
+        uint32_t Height() const;
+        uint32_t LayerCount() const;
+        VkFormat Format() const;
+
+        // Upload layout: largest level first, every layer of a level back to back so one copy region
+        // covers the level. Offsets are 16 byte aligned, sizes include all layers.
+        const std::vector<MipLevel> & Levels() const;
+        uint64_t UploadSize() const;
+
+        void CopyTo(uint8_t * destination) const;
+
+        // The same layout for the chain from firstLevel down, rebased to start at offset 0, for
+        // streaming only the levels that are needed.
+        std::vector<MipLevel> Levels(uint32_t firstLevel) const;
+        uint64_t UploadSize(uint32_t firstLevel) const;
+
+        void CopyTo(uint8_t * destination, uint32_t firstLevel) const;
+
+    private:
+        struct Span
+        {
+            uint64_t Source;
+            uint64_t Destination;
+            uint64_t Size;
+            uint32_t Level;
+        };
+
+        void ParseKtx2();
+        void ParseDds();
+        void BuildLayout(uint32_t levelCount);
+
+        Util::IO::MappedFile file;
+        std::string path;
+
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint32_t layers = 1;
+        uint32_t blockDim = 1;
+        uint32_t blockBytes = 0;
+
+        std::vector<MipLevel> levels;
+        std::vector<Span> spans;
+    };
+}
+#endif // !TEXTURECONTAINER_H
@@ -0,0 +1,190 @@
+#include "textureStreamer.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace Graphics
+{
+    namespace
+    {
+        const uint32_t NoLevel = UINT32_MAX;
+    }
+
+    TextureStreamer::TextureStreamer(uint64_t budget, uint64_t tailBytes, uint32_t maxLoadsInFlight, uint32_t idleFrames) :
+        budget(budget),
+        tailBytes(tailBytes),
+        maxLoadsInFlight(maxLoadsInFlight),
+        idleFrames(idleFrames)
+    {
+    }
+
+    TextureStreamer::Handle TextureStreamer::Register(const std::vector<uint64_t> & levelBytes)
+    {
+        if (levelBytes.empty())
+        {
+            throw std::invalid_argument("Streamed texture has no levels");
+        }
+
+        Entry entry;
+        entry.ChainBytes.resize(levelBytes.size() + 1, 0);
+
+        for (size_t level = levelBytes.size(); level-- > 0;)
+        {
+            entry.ChainBytes[level] = entry.ChainBytes[level + 1] + levelBytes[level];
+        }
+
+        // The finest level whose chain fits the tail size, or the smallest level if none does.
+        entry.Tail = (uint32_t)levelBytes.size() - 1;
+
+        while (entry.Tail > 0 && entry.ChainBytes[entry.Tail - 1] <= tailBytes)
+        {
+            entry.Tail--;
+        }
+
+        entry.Resident = entry.Tail;
+        entry.Wanted = entry.Tail;
+        entry.Requested = NoLevel;
+        entry.Pending = NoLevel;
+        entry.IdleFrames = 0;
+
+        const Handle handle = nextHandle++;
+        entries.emplace(handle, std::move(entry));
+        return handle;
+    }
+
+    void TextureStreamer::Unregister(Handle handle)
+    {
+        const auto found = entries.find(handle);
+
+        if (found == entries.end())
+        {
+            return;
+        }
+
+        if (found->second.Pending != NoLevel)
+        {
+            inFlight--;
+        }
+
+        entries.erase(found);
+    }
+
+    uint32_t TextureStreamer::ResidentLevel(Handle handle) const
+    {
+        return entries.at(handle).Resident;
+    }
+
+    void TextureStreamer::Request(Handle handle, uint32_t level)
+    {
+        auto & entry = entries.at(handle);
+        entry.Requested = std::min(entry.Requested, level);
+    }
+
+    std::vector<StreamRequest> TextureStreamer::Schedule()
+    {
+        std::vector<StreamRequest> requests;
+        std::vector<std::pair<uint32_t, Handle>> blurry;
+        uint64_t committed = 0;
+
+        for (auto & pair : entries)
+        {
+            Entry & entry = pair.second;
+
+            if (entry.Requested != NoLevel)
+            {
+                entry.Wanted = std::min(entry.Requested, entry.Tail);
+                entry.IdleFrames = 0;
+            }
+            else if (++entry.IdleFrames >= idleFrames)
+            {
+                entry.Wanted = entry.Tail;
+            }
+
+            entry.Requested = NoLevel;
+
+            // While a swap is in flight the old and the new image both exist.
+            committed += entry.ChainBytes[entry.Resident];
+
+            if (entry.Pending != NoLevel)
+            {
+                committed += entry.ChainBytes[entry.Pending];
+                continue;
+            }
+
+            // Drops free memory once done and need no reads, so they go out regardless of the budget
+            // and the in-flight limit.
+            if (entry.Wanted > entry.Resident)
+            {
+                committed += entry.ChainBytes[entry.Wanted];
+                entry.Pending = entry.Wanted;
+                requests.push_back({ pair.first, entry.Wanted });
+                inFlight++;
+                drops++;
+            }
+            else if (entry.Wanted < entry.Resident)
+            {
+                blurry.emplace_back(entry.Resident - entry.Wanted, pair.first);
+            }
+        }
+
+        // Furthest from what was asked for goes first.
+        std::sort(blurry.begin(), blurry.end(), [](const std::pair<uint32_t, Handle> & a, const std::pair<uint32_t, Handle> & b)
+        {
+            return a.first != b.first ? a.first > b.first : a.second < b.second;
+        });
+
+        for (const auto & candidate : blurry)
+        {
+            if (inFlight >= maxLoadsInFlight)
+            {
+                break;
+            }
+
+            Entry & entry = entries.at(candidate.second);
+            const uint32_t level = entry.Resident - 1;
+            const uint64_t cost = entry.ChainBytes[level];
+
+            if (committed + cost > budget)
+            {
+                continue;
+            }
+
+            committed += cost;
+            entry.Pending = level;
+            requests.push_back({ candidate.second, level });
+            inFlight++;
+            loads++;
+        }
+
+        return requests;
+    }
+
+    void TextureStreamer::Complete(Handle handle, uint32_t level)
+    {
+        auto & entry = entries.at(handle);
+
+        if (entry.Pending == NoLevel)
+        {
+            throw std::logic_error("Texture stream completed without a request");
+        }
+
+        entry.Resident = level;
+        entry.Pending = NoLevel;
+        inFlight--;
+    }
+
+    TextureStreamerStats TextureStreamer::Stats() const
+    {
+        TextureStreamerStats stats;
+        stats.BudgetBytes = budget;
+        stats.Textures = (uint32_t)entries.size();
+        stats.Loads = loads;
+        stats.Drops = drops;
+
+        for (const auto & pair : entries)
+        {
+            stats.ResidentBytes += pair.second.ChainBytes[pair.second.Resident];
+        }
+
+        return stats;
+    }
+}
@@ -0,0 +1,79 @@
+#ifndef TEXTURESTREAMER_H
+#define TEXTURESTREAMER_H
+#include <stdint.h>
+#include <unordered_map>
+#include <vector>
+
+namespace Graphics
+{
+    struct StreamRequest
+    {
+        uint32_t Handle;
+
+        // Finest level the texture's image should start at once the request completes.
+        uint32_t Level;
+    };
+
+    struct TextureStreamerStats
+    {
+        uint64_t ResidentBytes = 0;
+        uint64_t BudgetBytes = 0;
+        uint32_t Textures = 0;
+        uint64_t Loads = 0;
+        uint64_t Drops = 0;
+    };
+
+    // Decides which mips of streamed textures are resident. Textures start at their tail, the finest
+    // level whose chain fits in tailBytes, then sharpen one level at a time towards what the GPU feedback
+    // asks for while the total stays within budget. Textures nobody has sampled for idleFrames fall back
+    // to their tail so others can use the memory. Only the render thread touches it.
+    class TextureStreamer
+    {
+    public:
+        typedef uint32_t Handle;
+
+        TextureStreamer(uint64_t budget, uint64_t tailBytes, uint32_t maxLoadsInFlight, uint32_t idleFrames);
+
+        // levelBytes holds the size of every level of the full chain, largest first.
+        Handle Register(const std::vector<uint64_t> & levelBytes);
+        void Unregister(Handle handle);
+
+        uint32_t ResidentLevel(Handle handle) const;
+
+        // Feedback: the finest level of the full chain that was sampled this frame.
+        void Request(Handle handle, uint32_t level);
+
+        // Called once a frame after the feedback is in, returns the loads and drops to start.
+        std::vector<StreamRequest> Schedule();
+
+        // The image for handle now starts at level.
+        void Complete(Handle handle, uint32_t level);
+
+        TextureStreamerStats Stats() const;
+
+    private:
+        struct Entry
+        {
+            std::vector<uint64_t> ChainBytes;
+            uint32_t Tail;
+            uint32_t Resident;
+            uint32_t Wanted;
+            uint32_t Requested;
+            uint32_t Pending;
+            uint32_t IdleFrames;
+        };
+
+        uint64_t budget;
+        uint64_t tailBytes;
+        uint32_t maxLoadsInFlight;
+        uint32_t idleFrames;
+
+        Handle nextHandle = 1;
+        uint32_t inFlight = 0;
+        uint64_t loads = 0;
+        uint64_t drops = 0;
+
+        std::unordered_map<Handle, Entry> entries;
+    };
+}
+#endif // !TEXTURESTREAMER_H
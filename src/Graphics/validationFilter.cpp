@@ -0,0 +1,147 @@
+#include "validationFilter.h"
+#include <string.h>
+
+namespace Graphics::Vulkan
+{
+    namespace
+    {
+        uint64_t HashText(const char * text)
+        {
+            uint64_t hash = 14695981039346656037ull;
+
+            for (; *text != '\0'; text++)
+            {
+                hash = (hash ^ (uint8_t)*text) * 1099511628211ull;
+            }
+
+            return hash;
+        }
+
+        void Log(Util::Logging::Logger & logger, VkDebugUtilsMessageSeverityFlagBitsEXT severity, const char * text)
+        {
+            if (severity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)
+            {
+                LOG_ERROR(logger, Vulkan, "{}", text);
+            }
+            else if (severity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT)
+            {
+                LOG_WARNING(logger, Vulkan, "{}", text);
+            }
+            else if (severity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT)
+            {
+                LOG_INFO(logger, Vulkan, "{}", text);
+            }
+            else
+            {
+                LOG_TRACE(logger, Vulkan, "{}", text);
+            }
+        }
+    }
+
+    ValidationFilter::ValidationFilter(Util::Logging::Logger & logger, std::chrono::steady_clock::duration reportInterval) :
+        logger(logger),
+        reportInterval(reportInterval),
+        lastReport(std::chrono::steady_clock::now())
+    {
+    }
+
+    void ValidationFilter::Submit(VkDebugUtilsMessageSeverityFlagBitsEXT severity, const VkDebugUtilsMessengerCallbackDataEXT * data)
+    {
+        // Ids are only unique per layer, so the text stands in when a layer doesn't set one.
+        const uint64_t key = data->messageIdNumber != 0 ? (uint32_t)data->messageIdNumber : HashText(data->pMessage) | (1ull << 63);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+
+            if (severity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_ERROR_BIT_EXT)
+            {
+                stats.Errors++;
+            }
+            else if (severity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_WARNING_BIT_EXT)
+            {
+                stats.Warnings++;
+            }
+            else if (severity >= VK_DEBUG_UTILS_MESSAGE_SEVERITY_INFO_BIT_EXT)
+            {
+                stats.Info++;
+            }
+            else
+            {
+                stats.Verbose++;
+            }
+
+            Message & message = messages[key];
+            message.Count++;
+
+            if (message.Count > 1)
+            {
+                message.Unreported++;
+                stats.Suppressed++;
+                unreported = true;
+                return;
+            }
+
+            message.Name = data->pMessageIdName != nullptr ? data->pMessageIdName : "";
+            message.Severity = severity;
+            stats.UniqueMessages = messages.size();
+        }
+
+        // The first sighting goes out in full, outside the lock since logging can block.
+        Log(logger, severity, data->pMessage);
+    }
+
+    void ValidationFilter::Update()
+    {
+        const auto now = std::chrono::steady_clock::now();
+
+        if (now - lastReport < reportInterval)
+        {
+            return;
+        }
+
+        lastReport = now;
+        ReportRepeats();
+    }
+
+    void ValidationFilter::ReportRepeats()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (!unreported)
+        {
+            return;
+        }
+
+        for (auto & entry : messages)
+        {
+            Message & message = entry.second;
+
+            if (message.Unreported == 0)
+            {
+                continue;
+            }
+
+            const std::string text = (message.Name.empty() ? "Validation message" : message.Name) + " repeated " +
+                std::to_string(message.Unreported) + " more times (" + std::to_string(message.Count) + " total)";
+            Log(logger, message.Severity, text.c_str());
+            message.Unreported = 0;
+        }
+
+        unreported = false;
+    }
+
+    void ValidationFilter::Summarize()
+    {
+        ReportRepeats();
+
+        const ValidationStats totals = Stats();
+        LOG_INFO(logger, Vulkan, "Validation: {} errors, {} warnings, {} info, {} verbose, {} unique, {} repeats suppressed",
+            totals.Errors, totals.Warnings, totals.Info, totals.Verbose, totals.UniqueMessages, totals.Suppressed);
+    }
+
+    ValidationStats ValidationFilter::Stats() const
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stats;
+    }
+}
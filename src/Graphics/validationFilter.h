@@ -0,0 +1,65 @@
+#ifndef VALIDATIONFILTER_H
+#define VALIDATIONFILTER_H
+#include "graphics_includes.h"
+#include "../Utils/logger.h"
+#include <stdint.h>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace Graphics::Vulkan
+{
+    struct ValidationStats
+    {
+        uint64_t Verbose = 0;
+        uint64_t Info = 0;
+        uint64_t Warnings = 0;
+        uint64_t Errors = 0;
+
+        size_t UniqueMessages = 0;
+        uint64_t Suppressed = 0;
+    };
+
+    // Sits between the debug messenger and the log. Each distinct message, keyed by its
+    // messageIdNumber or by a hash of its text when the layer leaves that 0, is logged the first
+    // time it arrives. Repeats are only counted and reported as one line per message every
+    // ReportInterval, so a message fired every draw doesn't flood the log.
+    class ValidationFilter
+    {
+    public:
+        explicit ValidationFilter(Util::Logging::Logger & logger, std::chrono::steady_clock::duration reportInterval = std::chrono::seconds(5));
+
+        // Called from the debug messenger, on whichever thread made the Vulkan call.
+        void Submit(VkDebugUtilsMessageSeverityFlagBitsEXT severity, const VkDebugUtilsMessengerCallbackDataEXT * data);
+
+        // Logs repeat counts once the interval has passed, cheap to call every frame.
+        void Update();
+
+        // Logs outstanding repeats and the per-severity totals.
+        void Summarize();
+
+        ValidationStats Stats() const;
+
+    private:
+        struct Message
+        {
+            std::string Name;
+            VkDebugUtilsMessageSeverityFlagBitsEXT Severity;
+            uint64_t Count = 0;
+            uint64_t Unreported = 0;
+        };
+
+        void ReportRepeats();
+
+        Util::Logging::Logger & logger;
+        std::chrono::steady_clock::duration reportInterval;
+        std::chrono::steady_clock::time_point lastReport;
+
+        mutable std::mutex mutex;
+        std::unordered_map<uint64_t, Message> messages;
+        ValidationStats stats;
+        bool unreported = false;
+    };
+}
+#endif // !VALIDATIONFILTER_H
@@ -0,0 +1,18 @@
+#ifndef VULKANBUFFER_H
+#define VULKANBUFFER_H
+#include "graphics_includes.h"
+
+namespace Graphics::Vulkan
+{
+    uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags flags, VkPhysicalDeviceMemoryProperties memProperties);
+
+    void CreateBuffer(VkDevice device,
+        VkPhysicalDevice physicalDevice,
+        VkDeviceSize size,
+        VkBufferUsageFlags usage,
+        VkMemoryPropertyFlags properties,
+        uint32_t  * queueIndicies,
+        VkBuffer& buffer,
+        VkDeviceMemory& bufferMemory);
+}
+#endif // !VULKANBUFFER_H
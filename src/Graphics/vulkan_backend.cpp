@@ -1,4 +1,7 @@
 #include "vulkan_backend.h"
+#include "vulkanBuffer.h"
+#include "../Utils/mappedFile.h"
+#include "pixelConvert.h"
 #include <iostream>
 #include <set>
 #include <map>
@@ -6,6 +9,7 @@
 #include <chrono>
 #include <thread>
 #include <sstream>
+#include <exception>
 
 #include <vulkan/vulkan.h>
 
@@ -23,6 +27,42 @@ namespace Graphics::Vulkan
         "VK_LAYER_LUNARG_standard_validation"
     };
 
+    // Decoded pixels allowed in flight across all texture loads.
+    const uint64_t TextureDecodeBudget = 256ull * 1024 * 1024;
+
+    // Upper bound on resident textures, lowered further when the device reports less free memory.
+    const uint64_t TextureCacheBudget = 512ull * 1024 * 1024;
+
+    // Streamed levels allowed across all textures. Each starts with its chain below StreamingTailBytes.
+    const uint64_t StreamingBudget = 256ull * 1024 * 1024;
+    const uint64_t StreamingTailBytes = 256ull * 1024;
+    const uint32_t StreamingLoadsInFlight = 2;
+    const uint32_t StreamingIdleFrames = 300;
+
+    // Atlas pages start small and double until every image fits. The gutter keeps three mips clean.
+    const uint32_t AtlasMinPageSize = 256;
+    const uint32_t AtlasMaxPageSize = 4096;
+    const uint32_t AtlasPadding = 8;
+
+    // Feedback value for "not sampled", the shader only ever lowers it.
+    const int32_t NoFeedback = INT32_MAX;
+
+    // Retire frame of an image that stale command buffers still sample.
+    const uint64_t PendingRetire = UINT64_MAX;
+
+    VkFormat ToVkFormat(BlockFormat format)
+    {
+        switch (format)
+        {
+        case BlockFormat::BC1:
+            return VK_FORMAT_BC1_RGB_UNORM_BLOCK;
+        case BlockFormat::BC3:
+            return VK_FORMAT_BC3_UNORM_BLOCK;
+        default:
+            return VK_FORMAT_BC7_UNORM_BLOCK;
+        }
+    }
+
     const std::vector<const char*> deviceExtensions =
     {
         VK_KHR_SWAPCHAIN_EXTENSION_NAME
@@ -57,6 +97,44 @@ namespace Graphics::Vulkan
         return true;
     }
 
+    bool isInstanceExtensionAvailable(const char * name)
+    {
+        uint32_t extensionCount;
+        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, nullptr);
+
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateInstanceExtensionProperties(nullptr, &extensionCount, availableExtensions.data());
+
+        for (const auto & extension : availableExtensions)
+        {
+            if (strcmp(name, extension.extensionName) == 0)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool isDeviceExtensionAvailable(VkPhysicalDevice device, const char * name)
+    {
+        uint32_t extensionCount;
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+        std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+        vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+        for (const auto & extension : availableExtensions)
+        {
+            if (strcmp(name, extension.extensionName) == 0)
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
     std::vector<const char*> getRequiredExtensions()
     {
         uint32_t glfwExtensionCount = 0;
@@ -79,11 +157,9 @@ namespace Graphics::Vulkan
         const VkDebugUtilsMessengerCallbackDataEXT* pCallbackData,
         void* pUserData)
     {
-        Util::Logging::Logger * logger = (Util::Logging::Logger *)pUserData;
-
-        std::string msg = pCallbackData->pMessage;
+        ValidationFilter * filter = (ValidationFilter *)pUserData;
 
-        logger->Trace(msg.c_str());
+        filter->Submit(messageSeverity, pCallbackData);
 
         return VK_FALSE;
     }
@@ -130,7 +206,7 @@ namespace Graphics::Vulkan
 
         createInfo.pfnUserCallback = debugCallback;
 
-        createInfo.pUserData = &logger;
+        createInfo.pUserData = &validationFilter;
 
         if (CreateDebugUtilsMessengerEXT(instance, &createInfo, nullptr, callback) != VK_SUCCESS)
         {
@@ -153,6 +229,13 @@ namespace Graphics::Vulkan
         createInfo.pApplicationInfo = &appInfo;
 
         auto extensions = getRequiredExtensions();
+
+        physicalDeviceProperties2 = isInstanceExtensionAvailable(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+        if (physicalDeviceProperties2)
+        {
+            extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+        }
+
         createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
         createInfo.ppEnabledExtensionNames = extensions.data();
 
@@ -309,8 +392,19 @@ namespace Graphics::Vulkan
         transferQueueInfo.queueCount = 1;
         transferQueueInfo.pQueuePriorities = &priority;
 
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(physicalDevice, &supportedFeatures);
+
         VkPhysicalDeviceFeatures deviceFeatures = {};
         deviceFeatures.samplerAnisotropy = true;
+        deviceFeatures.multiDrawIndirect = supportedFeatures.multiDrawIndirect;
+        deviceFeatures.textureCompressionBC = supportedFeatures.textureCompressionBC;
+        deviceFeatures.fragmentStoresAndAtomics = supportedFeatures.fragmentStoresAndAtomics;
+        deviceFeatures.pipelineStatisticsQuery = supportedFeatures.pipelineStatisticsQuery;
+        pipelineStatistics = supportedFeatures.pipelineStatisticsQuery == VK_TRUE;
+        multiDrawIndirect = supportedFeatures.multiDrawIndirect == VK_TRUE;
+        textureCompressionBC = supportedFeatures.textureCompressionBC == VK_TRUE;
+        textureFeedback = supportedFeatures.fragmentStoresAndAtomics == VK_TRUE;
 
         VkDeviceQueueCreateInfo queueInfos[2] = { presentQueueInfo, transferQueueInfo };
 
@@ -318,8 +412,16 @@ namespace Graphics::Vulkan
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
         createInfo.pQueueCreateInfos = queueInfos;
         createInfo.queueCreateInfoCount = 2;
-        createInfo.enabledExtensionCount = static_cast<uint32_t>(deviceExtensions.size());
-        createInfo.ppEnabledExtensionNames = deviceExtensions.data();
+        auto extensions = deviceExtensions;
+
+        memoryBudget = physicalDeviceProperties2 && isDeviceExtensionAvailable(physicalDevice, VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        if (memoryBudget)
+        {
+            extensions.push_back(VK_EXT_MEMORY_BUDGET_EXTENSION_NAME);
+        }
+
+        createInfo.enabledExtensionCount = static_cast<uint32_t>(extensions.size());
+        createInfo.ppEnabledExtensionNames = extensions.data();
 
         createInfo.pEnabledFeatures = &deviceFeatures;
 
@@ -413,20 +515,8 @@ namespace Graphics::Vulkan
         swapChainImageViews.resize(swapChainImages.size());
         for (int i = 0; i < swapChainImages.size(); i++)
         {
-            swapChainImageViews[i] = CreateImageView(swapChainImages[i], swapChainFormat.format, VK_IMAGE_ASPECT_COLOR_BIT);
-        }
-    }
-
-    uint32_t findMemoryType(uint32_t typeFilter, VkMemoryPropertyFlags flags, VkPhysicalDeviceMemoryProperties memProperties)
-    {
-        for (uint32_t i = 0; i < memProperties.memoryTypeCount; i++)
-        {
-            if ((typeFilter & (1 << i)) && (memProperties.memoryTypes[i].propertyFlags & flags) == flags)
-            {
-                return i;
-            }
+            swapChainImageViews[i] = CreateImageView(swapChainImages[i], swapChainFormat.format, VK_IMAGE_ASPECT_COLOR_BIT, 1);
         }
-        throw std::runtime_error("failed to find suitable memory type!");
     }
 
     void VulkanBackend::CreateShaders()
@@ -499,46 +589,6 @@ namespace Graphics::Vulkan
         }
     }
 
-    void CreateBuffer(VkDevice device,
-        VkPhysicalDevice physicalDevice,
-        VkDeviceSize size,
-        VkBufferUsageFlags usage,
-        VkMemoryPropertyFlags properties,
-        uint32_t  * queueIndicies,
-        VkBuffer& buffer,
-        VkDeviceMemory& bufferMemory)
-    {
-        VkBufferCreateInfo bufferInfo = {};
-        bufferInfo.sType = VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO;
-        bufferInfo.size = size;
-        bufferInfo.usage = usage;
-        bufferInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
-        bufferInfo.pQueueFamilyIndices = queueIndicies;
-        bufferInfo.queueFamilyIndexCount = 2;
-
-        if (vkCreateBuffer(device, &bufferInfo, nullptr, &buffer) != VK_SUCCESS)
-        {
-            throw std::runtime_error("failed to create buffer!");
-        }
-
-        VkMemoryRequirements memRequirements;
-        vkGetBufferMemoryRequirements(device, buffer, &memRequirements);
-
-        VkPhysicalDeviceMemoryProperties memProperties;
-        vkGetPhysicalDeviceMemoryProperties(physicalDevice, &memProperties);
-
-        VkMemoryAllocateInfo allocInfo = {};
-        allocInfo.sType = VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO;
-        allocInfo.allocationSize = memRequirements.size;
-        allocInfo.memoryTypeIndex = findMemoryType(memRequirements.memoryTypeBits, properties, memProperties);
-
-        if (vkAllocateMemory(device, &allocInfo, nullptr, &bufferMemory) != VK_SUCCESS) {
-            throw std::runtime_error("failed to allocate buffer memory!");
-        }
-
-        CHECK_ERROR(vkBindBufferMemory(device, buffer, bufferMemory, 0));
-    }
-
     void VulkanBackend::CopyBuffer(
         VkBuffer srcBuffer,
         VkBuffer dstBuffer,
@@ -558,37 +608,40 @@ namespace Graphics::Vulkan
         EndSingleTimeCommands(commandBuffer);
     }
 
-    void VulkanBackend::CopyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height)
+    void VulkanBackend::CopyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer buffer, VkImage image, uint32_t layers, const std::vector<MipLevel> & levels)
     {
-        auto commandBuffer = BeginSingleTimeCommands(presentCommandPool);
-        VkBufferImageCopy region = {};
-        region.bufferOffset = 0;
-        region.bufferRowLength = 0;
-        region.bufferImageHeight = 0;
-
-        region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        region.imageSubresource.mipLevel = 0;
-        region.imageSubresource.baseArrayLayer = 0;
-        region.imageSubresource.layerCount = 1;
+        std::vector<VkBufferImageCopy> regions(levels.size());
 
-        region.imageOffset = { 0, 0, 0 };
-        region.imageExtent =
+        for (size_t i = 0; i < levels.size(); i++)
         {
-            width,
-            height,
-            1
-        };
+            auto & region = regions[i];
+            region = {};
+            region.bufferOffset = levels[i].Offset;
+            region.bufferRowLength = 0;
+            region.bufferImageHeight = 0;
+
+            region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+            region.imageSubresource.mipLevel = (uint32_t)i;
+            region.imageSubresource.baseArrayLayer = 0;
+            region.imageSubresource.layerCount = layers;
+
+            region.imageOffset = { 0, 0, 0 };
+            region.imageExtent =
+            {
+                levels[i].Width,
+                levels[i].Height,
+                1
+            };
+        }
 
         vkCmdCopyBufferToImage(
             commandBuffer,
             buffer,
             image,
             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-            1,
-            &region
+            (uint32_t)regions.size(),
+            regions.data()
         );
-
-        EndSingleTimeCommands(commandBuffer);
     }
 
     void VulkanBackend::CreateRenderPass()
@@ -660,15 +713,23 @@ namespace Graphics::Vulkan
         samplerLayoutBinding.pImmutableSamplers = nullptr;
         samplerLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
 
+        VkDescriptorSetLayoutBinding feedbackLayoutBinding = {};
+        feedbackLayoutBinding.binding = 2;
+        feedbackLayoutBinding.descriptorCount = 1;
+        feedbackLayoutBinding.descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        feedbackLayoutBinding.pImmutableSamplers = nullptr;
+        feedbackLayoutBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
         VkDescriptorSetLayoutBinding layouts[] =
         {
             uboLayoutBinding,
-            samplerLayoutBinding
+            samplerLayoutBinding,
+            feedbackLayoutBinding
         };
 
         VkDescriptorSetLayoutCreateInfo layoutInfo = {};
         layoutInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-        layoutInfo.bindingCount = 2;
+        layoutInfo.bindingCount = 3;
         layoutInfo.pBindings = layouts;
 
         if (vkCreateDescriptorSetLayout(device, &layoutInfo, nullptr, &descriptorSetLayout) != VK_SUCCESS)
@@ -679,12 +740,147 @@ namespace Graphics::Vulkan
 
     void VulkanBackend::UpdateUniformData(uint32_t index)
     {
+        PROFILE_ZONE("Update uniforms");
+
         camera.view = glm::lookAt(position, position + direction, glm::cross(right, direction));
 
         void* data;
         CHECK_ERROR(vkMapMemory(device, uniformBuffersMemory[index], 0, sizeof(camera), 0, &data));
         memcpy(data, &camera, sizeof(camera));
         vkUnmapMemory(device, uniformBuffersMemory[index]);
+
+        UpdateDrawCommand(index);
+    }
+
+    void VulkanBackend::UpdateDrawCommand(uint32_t index)
+    {
+        if (currentLods.empty())
+        {
+            return;
+        }
+
+        const auto modelView = camera.view * camera.model;
+
+        auto lod = LodChain::Select(
+            currentLodErrors,
+            currentBounds,
+            modelView,
+            camera.proj,
+            viewport.height,
+            lodPixelThreshold);
+
+        const auto eye = glm::vec3(glm::inverse(modelView)[3]);
+        currentCullers[lod].Cull(camera.proj * modelView, eye, visibleClusters);
+
+        void* data;
+        CHECK_ERROR(vkMapMemory(device, indirectBuffersMemory[index], 0, maxDrawCommands * sizeof(VkDrawIndexedIndirectCommand), 0, &data));
+
+        // The draw count is baked into the command buffers, so slots past the visible clusters draw nothing.
+        auto commands = (VkDrawIndexedIndirectCommand *)data;
+        memset(commands, 0, maxDrawCommands * sizeof(VkDrawIndexedIndirectCommand));
+
+        for (size_t i = 0; i < visibleClusters.size(); i++)
+        {
+            const auto & cluster = currentClusters[lod][visibleClusters[i]];
+
+            commands[i].indexCount = cluster.IndexCount;
+            commands[i].instanceCount = 1;
+            commands[i].firstIndex = cluster.FirstIndex;
+            commands[i].vertexOffset = currentVertexOffset;
+            commands[i].firstInstance = 0;
+        }
+
+        vkUnmapMemory(device, indirectBuffersMemory[index]);
+
+        // DrawFrame has waited for the frame that last used this command buffer.
+        if (!multiDrawIndirect && recordedDrawCounts[index] != visibleClusters.size())
+        {
+            RecordRender(index);
+        }
+    }
+
+    void VulkanBackend::CreateIndirectBuffers(uint32_t commandCount)
+    {
+        DestroyIndirectBuffers();
+
+        maxDrawCommands = commandCount;
+        indirectBuffers.resize(swapChainImages.size());
+        indirectBuffersMemory.resize(swapChainImages.size());
+
+        for (int i = 0; i < indirectBuffers.size(); i++)
+        {
+            CreateBuffer(
+                device,
+                physicalDevice,
+                commandCount * sizeof(VkDrawIndexedIndirectCommand),
+
+                VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+
+                queueIndicies,
+                indirectBuffers[i],
+                indirectBuffersMemory[i]);
+        }
+    }
+
+    void VulkanBackend::DestroyIndirectBuffers()
+    {
+        for (const auto & indirectBuffer : indirectBuffers)
+        {
+            vkDestroyBuffer(device, indirectBuffer, nullptr);
+        }
+
+        for (const auto & indirectBufferMemory : indirectBuffersMemory)
+        {
+            vkFreeMemory(device, indirectBufferMemory, nullptr);
+        }
+
+        indirectBuffers.clear();
+        indirectBuffersMemory.clear();
+        maxDrawCommands = 0;
+    }
+
+    void VulkanBackend::CreateFeedbackBuffers()
+    {
+        DestroyFeedbackBuffers();
+
+        feedbackBuffers.resize(swapChainImages.size());
+        feedbackBuffersMemory.resize(swapChainImages.size());
+
+        for (int i = 0; i < feedbackBuffers.size(); i++)
+        {
+            CreateBuffer(
+                device,
+                physicalDevice,
+                sizeof(int32_t),
+
+                VK_BUFFER_USAGE_STORAGE_BUFFER_BIT | VK_BUFFER_USAGE_TRANSFER_DST_BIT,
+                VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT |
+                VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+
+                queueIndicies,
+                feedbackBuffers[i],
+                feedbackBuffersMemory[i]);
+        }
+
+        ResetFeedback();
+    }
+
+    void VulkanBackend::DestroyFeedbackBuffers()
+    {
+        for (const auto & feedbackBuffer : feedbackBuffers)
+        {
+            vkDestroyBuffer(device, feedbackBuffer, nullptr);
+        }
+
+        for (const auto & feedbackBufferMemory : feedbackBuffersMemory)
+        {
+            vkFreeMemory(device, feedbackBufferMemory, nullptr);
+        }
+
+        feedbackBuffers.clear();
+        feedbackBuffersMemory.clear();
     }
 
     void VulkanBackend::CreateGraphicsPipeline()
@@ -701,28 +897,6 @@ namespace Graphics::Vulkan
         vertexInputInfo.vertexAttributeDescriptionCount = static_cast<uint32_t>(attributeDescriptions.size());
         vertexInputInfo.pVertexAttributeDescriptions = attributeDescriptions.data(); // Optional
 
-        CreateBuffer(
-            device,
-            physicalDevice,
-            4096,
-            VK_BUFFER_USAGE_TRANSFER_DST_BIT |
-            VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-            queueIndicies,
-            vertexBuffer,
-            vertexBufferMemory);
-
-        CreateBuffer(
-            device,
-            physicalDevice,
-            4096,
-            VK_BUFFER_USAGE_TRANSFER_DST_BIT |
-            VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-            queueIndicies,
-            indexBuffer,
-            indexBufferMemory);
-
         uniformBuffers.resize(swapChainImages.size());
         uniformBuffersMemory.resize(swapChainImages.size());
 
@@ -841,6 +1015,25 @@ namespace Graphics::Vulkan
         VkGraphicsPipelineCreateInfo pipelineInfo = {};
         pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
         auto programInfo = currentProgram.GetProgramStageInfo();
+
+        // The feedback writes are compiled out of the fragment shader when streaming is off.
+        const VkBool32 writeFeedback = textureFeedback ? VK_TRUE : VK_FALSE;
+        VkSpecializationMapEntry feedbackEntry = { 0, 0, sizeof(VkBool32) };
+
+        VkSpecializationInfo specialization = {};
+        specialization.mapEntryCount = 1;
+        specialization.pMapEntries = &feedbackEntry;
+        specialization.dataSize = sizeof(writeFeedback);
+        specialization.pData = &writeFeedback;
+
+        for (auto & stage : programInfo)
+        {
+            if (stage.stage == VK_SHADER_STAGE_FRAGMENT_BIT)
+            {
+                stage.pSpecializationInfo = &specialization;
+            }
+        }
+
         pipelineInfo.stageCount = programInfo.size();
         pipelineInfo.pStages = programInfo.data();
         pipelineInfo.pVertexInputState = &vertexInputInfo;
@@ -889,6 +1082,7 @@ namespace Graphics::Vulkan
         }
 
         commandBuffers.resize(swapChainFramebuffers.size());
+        recordedDrawCounts.assign(commandBuffers.size(), 0);
         VkCommandBufferAllocateInfo commandBufferAllocInfo = {};
         commandBufferAllocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
         commandBufferAllocInfo.commandPool = presentCommandPool;
@@ -901,56 +1095,123 @@ namespace Graphics::Vulkan
         }
     }
 
+    VkIndexType ToVkIndexType(IndexType type)
+    {
+        return type == IndexType::UInt16 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+    }
+
     void VulkanBackend::RecordRender()
     {
         for (size_t i = 0; i < commandBuffers.size(); i++)
         {
-            VkCommandBufferBeginInfo beginInfo = {};
-            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
-            beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-            beginInfo.pInheritanceInfo = nullptr;
+            RecordRender(i);
+        }
+    }
 
-            if (vkBeginCommandBuffer(commandBuffers[i], &beginInfo) != VK_SUCCESS)
-            {
-                throw std::runtime_error("failed to begin recording command buffer!");
-            }
+    void VulkanBackend::RecordRender(size_t i)
+    {
+        VkCommandBufferBeginInfo beginInfo = {};
+        beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+        beginInfo.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
+        beginInfo.pInheritanceInfo = nullptr;
 
-            VkRenderPassBeginInfo renderPassBeginInfo = {};
-            renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-            renderPassBeginInfo.renderPass = renderPass;
-            renderPassBeginInfo.framebuffer = swapChainFramebuffers[i];
-            renderPassBeginInfo.renderArea.offset = { 0, 0 };
-            renderPassBeginInfo.renderArea.extent = caps.currentExtent;
-            VkClearValue clearColor = { 0.0f, 0.0f, 0.0f, 1.0f };
-            VkClearValue depth = {};
-            depth.depthStencil = { 1.0f, 0 };
-
-            VkClearValue asd[] =
-            {
-                clearColor,
-                depth
-            };
-            renderPassBeginInfo.clearValueCount = 2;
-            renderPassBeginInfo.pClearValues = asd;
-            vkCmdBeginRenderPass(commandBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+        if (vkBeginCommandBuffer(commandBuffers[i], &beginInfo) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to begin recording command buffer!");
+        }
+
+        gpuProfiler.Reset(commandBuffers[i], i);
+        gpuProfiler.Begin(commandBuffers[i], i, GpuScope::Frame);
+
+        VkRenderPassBeginInfo renderPassBeginInfo = {};
+        renderPassBeginInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
+        renderPassBeginInfo.renderPass = renderPass;
+        renderPassBeginInfo.framebuffer = swapChainFramebuffers[i];
+        renderPassBeginInfo.renderArea.offset = { 0, 0 };
+        renderPassBeginInfo.renderArea.extent = caps.currentExtent;
+        VkClearValue clearColor = { 0.0f, 0.0f, 0.0f, 1.0f };
+        VkClearValue depth = {};
+        depth.depthStencil = { 1.0f, 0 };
+
+        VkClearValue asd[] =
+        {
+            clearColor,
+            depth
+        };
+        renderPassBeginInfo.clearValueCount = 2;
+        renderPassBeginInfo.pClearValues = asd;
+
+        // The shader only lowers the feedback value, so it starts every frame at "not sampled".
+        vkCmdFillBuffer(commandBuffers[i], feedbackBuffers[i], 0, sizeof(int32_t), (uint32_t)NoFeedback);
+
+        VkBufferMemoryBarrier feedbackBarrier = {};
+        feedbackBarrier.sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER;
+        feedbackBarrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        feedbackBarrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT | VK_ACCESS_SHADER_WRITE_BIT;
+        feedbackBarrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        feedbackBarrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        feedbackBarrier.buffer = feedbackBuffers[i];
+        feedbackBarrier.offset = 0;
+        feedbackBarrier.size = VK_WHOLE_SIZE;
+
+        vkCmdPipelineBarrier(commandBuffers[i], VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 1, &feedbackBarrier, 0, nullptr);
+
+        gpuProfiler.BeginStatistics(commandBuffers[i], i);
+        gpuProfiler.Begin(commandBuffers[i], i, GpuScope::RenderPass);
+
+        vkCmdBeginRenderPass(commandBuffers[i], &renderPassBeginInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+        vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
 
-            vkCmdBindPipeline(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline);
+        // Written even without a model so the slot's queries always become available.
+        gpuProfiler.Begin(commandBuffers[i], i, GpuScope::Draws);
 
-            VkBuffer vertexBuffers[] = { vertexBuffer };
+        if (!currentLods.empty())
+        {
+            VkBuffer vertexBuffers[] = { geometry.VertexBuffer() };
             VkDeviceSize offsets[] = { 0 };
             vkCmdBindVertexBuffers(commandBuffers[i], 0, 1, vertexBuffers, offsets);
-            vkCmdBindIndexBuffer(commandBuffers[i], indexBuffer, 0, VK_INDEX_TYPE_UINT32);
+            vkCmdBindIndexBuffer(commandBuffers[i], geometry.IndexBuffer(), 0, ToVkIndexType(currentLods[0].Type));
 
             vkCmdBindDescriptorSets(commandBuffers[i], VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout, 0, 1, &descriptorSets[i], 0, nullptr);
 
-            vkCmdDrawIndexed(commandBuffers[i], currentModelIndices.size(), 1, 0, 0, 0);
-
-            vkCmdEndRenderPass(commandBuffers[i]);
-            if (vkEndCommandBuffer(commandBuffers[i]) != VK_SUCCESS)
+            // The LOD and visible clusters are picked per frame in UpdateDrawCommand, so the draws are read from the indirect buffer.
+            if (multiDrawIndirect)
+            {
+                vkCmdDrawIndexedIndirect(commandBuffers[i], indirectBuffers[i], 0, maxDrawCommands, sizeof(VkDrawIndexedIndirectCommand));
+            }
+            else
             {
-                throw std::runtime_error("failed to record command buffer!");
+                // One call per draw, so only as many as the last cull left visible. UpdateDrawCommand
+                // re-records the buffer whenever its count no longer matches.
+                const uint32_t drawCount = std::min((uint32_t)visibleClusters.size(), maxDrawCommands);
+
+                for (uint32_t draw = 0; draw < drawCount; draw++)
+                {
+                    vkCmdDrawIndexedIndirect(commandBuffers[i], indirectBuffers[i], draw * sizeof(VkDrawIndexedIndirectCommand), 1, sizeof(VkDrawIndexedIndirectCommand));
+                }
+
+                recordedDrawCounts[i] = drawCount;
             }
         }
+
+        gpuProfiler.End(commandBuffers[i], i, GpuScope::Draws);
+
+        vkCmdEndRenderPass(commandBuffers[i]);
+
+        gpuProfiler.End(commandBuffers[i], i, GpuScope::RenderPass);
+        gpuProfiler.EndStatistics(commandBuffers[i], i);
+
+        feedbackBarrier.srcAccessMask = VK_ACCESS_SHADER_WRITE_BIT;
+        feedbackBarrier.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+        vkCmdPipelineBarrier(commandBuffers[i], VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0, 0, nullptr, 1, &feedbackBarrier, 0, nullptr);
+
+        gpuProfiler.End(commandBuffers[i], i, GpuScope::Frame);
+
+        if (vkEndCommandBuffer(commandBuffers[i]) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to record command buffer!");
+        }
     }
 
     void VulkanBackend::SetupTransientOpsQueue()
@@ -969,7 +1230,9 @@ namespace Graphics::Vulkan
     // Initialize vulkan display
     void VulkanBackend::BeginInit(const std::string& title)
     {
-        logger.Info("Initializing Vulkan backend...");
+        PROFILE_ZONE("BeginInit");
+
+        LOG_INFO(logger, Vulkan, "Initializing Vulkan backend...");
 
         CreateInstance(title);
 
@@ -1020,6 +1283,8 @@ namespace Graphics::Vulkan
 
     void VulkanBackend::EndInit()
     {
+        PROFILE_ZONE("EndInit");
+
         CreateRenderPass();
 
         CreateDescriptorSetLayout();
@@ -1028,10 +1293,17 @@ namespace Graphics::Vulkan
         CreateDepthResources();
 
         CreateGraphicsPipeline();
+        FinishTextureLoads();
         CreateTextureSampler();
+        CreateFeedbackBuffers();
         CreateDescriptorSets();
 
+        gpuProfiler.Init(device, physicalDevice, queueIndicies[0], pipelineStatistics, MAX_FRAMES_IN_FLIGHT);
+        gpuProfiler.CreatePools((uint32_t)swapChainImages.size());
+
         createSyncObjects(MAX_FRAMES_IN_FLIGHT, device, renderFinishedSemaphores, imageAvailableSemaphores, inFlightFences);
+        imagesInFlight.assign(swapChainImages.size(), VK_NULL_HANDLE);
+        CreateUploadCommandBuffers();
     }
 
     void VulkanBackend::RecreateSwapChains()
@@ -1061,10 +1333,20 @@ namespace Graphics::Vulkan
         CreateGraphicsPipeline();
 
         CreateDescriptorPool();
+        CreateFeedbackBuffers();
         CreateDescriptorSets();
+        gpuProfiler.CreatePools((uint32_t)swapChainImages.size());
+
+        if (maxDrawCommands > 0)
+        {
+            CreateIndirectBuffers(maxDrawCommands);
+        }
 
-        LoadModel(currentModelVertices, currentModelIndices);
         RecordRender();
+
+        // The new descriptor sets already point at the current images.
+        ClearStaleCommandBuffers();
+        imagesInFlight.assign(swapChainImages.size(), VK_NULL_HANDLE);
     }
 
     void VulkanBackend::CreatePresentCommandPool()
@@ -1082,11 +1364,13 @@ namespace Graphics::Vulkan
 
     void VulkanBackend::CreateDescriptorPool()
     {
-        std::array<VkDescriptorPoolSize, 2> poolSizes = {};
+        std::array<VkDescriptorPoolSize, 3> poolSizes = {};
         poolSizes[0].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         poolSizes[0].descriptorCount = static_cast<uint32_t>(swapChainImages.size());
         poolSizes[1].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
         poolSizes[1].descriptorCount = static_cast<uint32_t>(swapChainImages.size());
+        poolSizes[2].type = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+        poolSizes[2].descriptorCount = static_cast<uint32_t>(swapChainImages.size());
 
         VkDescriptorPoolCreateInfo poolInfo = {};
         poolInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO;
@@ -1123,10 +1407,15 @@ namespace Graphics::Vulkan
 
             VkDescriptorImageInfo imageInfo = {};
             imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-            imageInfo.imageView = textureImageView;
+            imageInfo.imageView = textures.at(boundTexture).View;
             imageInfo.sampler = textureSampler;
 
-            std::array<VkWriteDescriptorSet, 2> descriptorWrites = {};
+            VkDescriptorBufferInfo feedbackInfo = {};
+            feedbackInfo.buffer = feedbackBuffers[i];
+            feedbackInfo.offset = 0;
+            feedbackInfo.range = sizeof(int32_t);
+
+            std::array<VkWriteDescriptorSet, 3> descriptorWrites = {};
 
             descriptorWrites[0].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
             descriptorWrites[0].dstSet = descriptorSets[i];
@@ -1144,22 +1433,57 @@ namespace Graphics::Vulkan
             descriptorWrites[1].descriptorCount = 1;
             descriptorWrites[1].pImageInfo = &imageInfo;
 
+            descriptorWrites[2].sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+            descriptorWrites[2].dstSet = descriptorSets[i];
+            descriptorWrites[2].dstBinding = 2;
+            descriptorWrites[2].dstArrayElement = 0;
+            descriptorWrites[2].descriptorType = VK_DESCRIPTOR_TYPE_STORAGE_BUFFER;
+            descriptorWrites[2].descriptorCount = 1;
+            descriptorWrites[2].pBufferInfo = &feedbackInfo;
+
             vkUpdateDescriptorSets(device, descriptorWrites.size(), descriptorWrites.data(), 0, nullptr);
         }
     }
 
     void VulkanBackend::DrawFrame()
     {
-        vkWaitForFences(device, 1, &inFlightFences[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+        PROFILE_ZONE("DrawFrame");
+
+        {
+            PROFILE_ZONE("Wait for fence");
+            vkWaitForFences(device, 1, &inFlightFences[currentFrame], VK_TRUE, std::numeric_limits<uint64_t>::max());
+        }
+
+        gpuProfiler.Collect((uint32_t)currentFrame);
+        ReleaseRetired(false);
 
         uint32_t imageIndex;
-        auto res = vkAcquireNextImageKHR(device, swapChain, std::numeric_limits<uint64_t>::max(), imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+        VkResult res;
+
+        {
+            PROFILE_ZONE("Acquire image");
+            res = vkAcquireNextImageKHR(device, swapChain, std::numeric_limits<uint64_t>::max(), imageAvailableSemaphores[currentFrame], VK_NULL_HANDLE, &imageIndex);
+        }
+
         if (res == VK_ERROR_OUT_OF_DATE_KHR)
         {
             RecreateSwapChains();
             return;
         }
 
+        // The image's command buffer, descriptor set and buffers are reused below.
+        if (imagesInFlight[imageIndex] != VK_NULL_HANDLE)
+        {
+            PROFILE_ZONE("Wait for image");
+            vkWaitForFences(device, 1, &imagesInFlight[imageIndex], VK_TRUE, std::numeric_limits<uint64_t>::max());
+        }
+
+        imagesInFlight[imageIndex] = inFlightFences[currentFrame];
+
+        validationFilter.Update();
+        UpdateCamera(Input::InputState::Current());
+        UpdateStreaming(imageIndex);
+        RefreshCommandBuffer(imageIndex);
         UpdateUniformData(imageIndex);
 
         VkSubmitInfo submitInfo = {};
@@ -1173,17 +1497,38 @@ namespace Graphics::Vulkan
         submitInfo.commandBufferCount = 1;
         submitInfo.pCommandBuffers = &commandBuffers[imageIndex];
 
+        // Streamed levels are copied ahead of the render commands that sample them.
+        VkCommandBuffer frameCommandBuffers[] = { uploadCommandBuffers[currentFrame], commandBuffers[imageIndex] };
+
+        if (uploadRecording)
+        {
+            if (vkEndCommandBuffer(uploadCommandBuffers[currentFrame]) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to record upload command buffer!");
+            }
+
+            uploadRecording = false;
+            submitInfo.commandBufferCount = 2;
+            submitInfo.pCommandBuffers = frameCommandBuffers;
+        }
+
         VkSemaphore signalSemaphores[] = { renderFinishedSemaphores[currentFrame] };
         submitInfo.signalSemaphoreCount = 1;
         submitInfo.pSignalSemaphores = signalSemaphores;
 
-        vkResetFences(device, 1, &inFlightFences[currentFrame]);
-
-        if (vkQueueSubmit(presentQueue, 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS)
         {
-            throw std::runtime_error("failed to submit draw command buffer!");
+            PROFILE_ZONE("Submit");
+            vkResetFences(device, 1, &inFlightFences[currentFrame]);
+
+            if (vkQueueSubmit(presentQueue, 1, &submitInfo, inFlightFences[currentFrame]) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to submit draw command buffer!");
+            }
         }
 
+        gpuProfiler.Submitted((uint32_t)currentFrame, imageIndex);
+        frameNumber++;
+
         VkSubpassDependency dependency = {};
         dependency.srcSubpass = VK_SUBPASS_EXTERNAL;
         dependency.dstSubpass = 0;
@@ -1204,7 +1549,10 @@ namespace Graphics::Vulkan
         presentInfo.pSwapchains = swapChains;
         presentInfo.pImageIndices = &imageIndex;
 
-        vkQueuePresentKHR(presentQueue, &presentInfo);
+        {
+            PROFILE_ZONE("Present");
+            vkQueuePresentKHR(presentQueue, &presentInfo);
+        }
 
         currentFrame = (currentFrame + 1) % MAX_FRAMES_IN_FLIGHT;
     }
@@ -1212,6 +1560,8 @@ namespace Graphics::Vulkan
     void VulkanBackend::CreateImage(
         uint32_t width,
         uint32_t height,
+        uint32_t mipLevels,
+        uint32_t layers,
         VkFormat format,
         VkImageTiling tiling,
         VkImageUsageFlags usage,
@@ -1225,8 +1575,8 @@ namespace Graphics::Vulkan
         imageInfo.extent.width = width;
         imageInfo.extent.height = height;
         imageInfo.extent.depth = 1;
-        imageInfo.mipLevels = 1;
-        imageInfo.arrayLayers = 1;
+        imageInfo.mipLevels = mipLevels;
+        imageInfo.arrayLayers = layers;
         imageInfo.format = format;
         imageInfo.tiling = tiling;
         imageInfo.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
@@ -1295,7 +1645,8 @@ namespace Graphics::Vulkan
     VkImageView VulkanBackend::CreateImageView(
         VkImage image,
         VkFormat format,
-        VkImageAspectFlags aspectFlags)
+        VkImageAspectFlags aspectFlags,
+        uint32_t mipLevels)
     {
         VkImageViewCreateInfo viewInfo = {};
         viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
@@ -1304,7 +1655,7 @@ namespace Graphics::Vulkan
         viewInfo.format = format;
         viewInfo.subresourceRange.aspectMask = aspectFlags;
         viewInfo.subresourceRange.baseMipLevel = 0;
-        viewInfo.subresourceRange.levelCount = 1;
+        viewInfo.subresourceRange.levelCount = mipLevels;
         viewInfo.subresourceRange.baseArrayLayer = 0;
         viewInfo.subresourceRange.layerCount = 1;
 
@@ -1320,7 +1671,9 @@ namespace Graphics::Vulkan
         VkImage image,
         VkFormat format,
         VkImageLayout oldLayout,
-        VkImageLayout newLayout)
+        VkImageLayout newLayout,
+        uint32_t mipLevels,
+        uint32_t layers)
     {
         VkCommandBuffer commandBuffer = BeginSingleTimeCommands(presentCommandPool);
 
@@ -1333,9 +1686,9 @@ namespace Graphics::Vulkan
         barrier.image = image;
         barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
         barrier.subresourceRange.baseMipLevel = 0;
-        barrier.subresourceRange.levelCount = 1;
+        barrier.subresourceRange.levelCount = mipLevels;
         barrier.subresourceRange.baseArrayLayer = 0;
-        barrier.subresourceRange.layerCount = 1;
+        barrier.subresourceRange.layerCount = layers;
         barrier.srcAccessMask = 0; // TODO
         barrier.dstAccessMask = 0; // TODO
 
@@ -1400,22 +1753,28 @@ namespace Graphics::Vulkan
     {
         CreateImage(caps.currentExtent.width,
             caps.currentExtent.height,
+            1,
+            1,
             VK_FORMAT_D32_SFLOAT_S8_UINT,
             VK_IMAGE_TILING_OPTIMAL,
             VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
             depthImage, depthImageMemory);
 
-        depthImageView = CreateImageView(depthImage, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_IMAGE_ASPECT_DEPTH_BIT);
+        depthImageView = CreateImageView(depthImage, VK_FORMAT_D32_SFLOAT_S8_UINT, VK_IMAGE_ASPECT_DEPTH_BIT, 1);
 
         TransitionImageLayout(depthImage,
             VK_FORMAT_D32_SFLOAT_S8_UINT,
             VK_IMAGE_LAYOUT_UNDEFINED,
-            VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL);
+            VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+            1,
+            1);
     }
 
     void VulkanBackend::LoadProgram(const std::string & name)
     {
+        PROFILE_ZONE("LoadProgram");
+
         currentProgram = ShaderProgram(name, shaderModules);
     }
 
@@ -1423,94 +1782,983 @@ namespace Graphics::Vulkan
         const std::vector<Vertex> & modelData,
         const std::vector<uint32_t> & indices)
     {
+        PROFILE_ZONE("LoadModel");
+
         this->currentModelVertices = modelData;
         this->currentModelIndices = indices;
+
+        const bool hasNormals = std::any_of(currentModelVertices.begin(), currentModelVertices.end(), [](const Vertex & vertex)
+        {
+            return vertex.normal != glm::vec3(0.0f);
+        });
+
+        TangentSpace::Generate(currentModelVertices, currentModelIndices, !hasNormals);
+
+        auto stats = MeshOptimizer::Optimize(currentModelVertices, currentModelIndices);
+
+        LOG_INFO(logger, Assets, "Mesh optimized: {} triangles, {} vertices, ACMR {} -> {}, ATVR {} -> {}",
+            currentModelIndices.size() / 3, currentModelVertices.size(),
+            stats.Before.ACMR, stats.After.ACMR, stats.Before.ATVR, stats.After.ATVR);
+
+        auto lods = LodChain::Build(currentModelVertices, currentModelIndices);
+
+        currentBounds = BoundingSphere::FromVertices(currentModelVertices);
+        currentLods.clear();
+        currentLodErrors.clear();
+        currentClusters.clear();
+        currentCullers.clear();
+
+        geometry.Clear();
+        currentVertexOffset = geometry.AddVertices(currentModelVertices);
+
+        size_t maxClusters = 0;
+
+        for (const auto & lod : lods)
+        {
+            // Each LOD is stored in meshlet order so every cluster is a contiguous index range.
+            auto meshlets = MeshletBuilder::Build(currentModelVertices, lod.Indices);
+
+            std::vector<uint32_t> clusteredIndices;
+            std::vector<IndexRange> clusters;
+            clusteredIndices.reserve(lod.Indices.size());
+
+            for (size_t i = 0; i < meshlets.Meshlets.size(); i++)
+            {
+                IndexRange cluster;
+                cluster.FirstIndex = (uint32_t)clusteredIndices.size();
+                meshlets.AppendIndices(i, clusteredIndices);
+                cluster.IndexCount = (uint32_t)clusteredIndices.size() - cluster.FirstIndex;
+                clusters.push_back(cluster);
+            }
+
+            auto range = geometry.AddIndices(IndexData(clusteredIndices, currentModelVertices.size()));
+
+            for (auto & cluster : clusters)
+            {
+                cluster.FirstIndex += range.FirstIndex;
+                cluster.Type = range.Type;
+            }
+
+            currentLods.push_back(range);
+            currentLodErrors.push_back(lod.Error);
+            currentClusters.push_back(clusters);
+            currentCullers.emplace_back();
+            currentCullers.back().Assign(meshlets.Bounds);
+            maxClusters = std::max(maxClusters, clusters.size());
+
+            LOG_DEBUG(logger, Assets, "LOD {}: {} triangles in {} clusters, error {}",
+                currentLods.size() - 1, lod.Indices.size() / 3, clusters.size(), lod.Error);
+        }
+
+        geometry.Upload(device, physicalDevice, queueIndicies, [this](VkBuffer src, VkBuffer dst, VkDeviceSize size)
+        {
+            CopyBuffer(src, dst, device, transferQueue, transientCommandPool, size);
+        });
+
+        vkDeviceWaitIdle(device);
+        CreateIndirectBuffers((uint32_t)maxClusters);
+
+        RecordRender();
+    }
+
+    void VulkanBackend::LoadTexture(const std::string & path)
+    {
+        PROFILE_ZONE("LoadTexture");
+
+        TextureCache::Id id;
+
+        if (textureCache.Acquire(path, id))
+        {
+            BindTexture(id);
+            return;
+        }
+
+        auto pending = std::make_unique<PendingTexture>();
+        pending->Path = path;
+
+        {
+            Util::IO::MappedFile file(path);
+            pending->ContentHash = TextureCache::Hash(file.Data(), file.Size());
+        }
+
+        if (textureCache.Acquire(path, pending->ContentHash, id))
+        {
+            BindTexture(id);
+            return;
+        }
+
+        // Containers only need their header validated, the mips are copied out of the mapping at upload.
+        if (TextureContainer::IsContainer(path))
+        {
+            pending->Container = std::make_unique<TextureContainer>(path);
+        }
+        else
+        {
+            auto destination = pending.get();
+
+            // Runs on a loader thread.
+            pending->Header = imageLoader.Load(path, [destination](const ImageHeader & header, ImageLoader::Reservation budget)
+            {
+                destination->Pixels.resize(header.Size());
+                destination->Budget = std::move(budget);
+                return destination->Pixels.data();
+            });
+        }
+
+        pendingTextures.push_back(std::move(pending));
+
+        // Loads before EndInit are batched so they decode together, later ones are finished straight away.
+        if (!descriptorSets.empty())
+        {
+            FinishTextureLoads();
+        }
+    }
+
+    void VulkanBackend::FinishTextureLoads()
+    {
+        PROFILE_ZONE("FinishTextureLoads");
+
+        if (pendingTextures.empty())
+        {
+            return;
+        }
+
+        auto pending = std::move(pendingTextures);
+        pendingTextures.clear();
+
+        bool decoded = false;
+        std::exception_ptr error;
+
+        for (auto & texture : pending)
+        {
+            try
+            {
+                decoded |= FinishTextureLoad(*texture);
+            }
+            catch (...)
+            {
+                // Keep going so no decode is left writing into a buffer that pending owns.
+                if (!error)
+                {
+                    error = std::current_exception();
+                }
+
+                if (texture->Header.valid())
+                {
+                    texture->Header.wait();
+                }
+            }
+
+            // Frees the pixels and their share of the decode budget, so the loads behind this one can start.
+            texture.reset();
+        }
+
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+
+        if (decoded)
+        {
+            const auto stats = imageLoader.Stats();
+
+            LOG_INFO(logger, Assets, "Decoded {} images ({} MB) in {} ms, {} images/s on {} threads with {} conversions",
+                stats.Images, stats.DecodedBytes / (1024 * 1024), stats.WallSeconds * 1000.0, stats.ImagesPerSecond(),
+                Util::Threading::ThreadPool::GetInstance()->ThreadCount() + 1, PixelConvert::Level());
+        }
+
+        const auto cache = textureCache.Stats();
+
+        LOG_INFO(logger, Assets, "Texture cache: {} resident, {} of {} MB, {} hits, {} misses, {} evictions",
+            cache.Resident, cache.ResidentBytes / (1024 * 1024), cache.BudgetBytes / (1024 * 1024),
+            cache.Hits, cache.Misses, cache.Evictions);
+    }
+
+    bool VulkanBackend::FinishTextureLoad(PendingTexture & texture)
+    {
+        TextureCache::Id id;
+        bool decoded = false;
+
+        // The same contents can be queued twice before either is uploaded; the second load is wasted
+        // but the cache still only keeps one copy.
+        if (textureCache.Contains(texture.ContentHash))
+        {
+            if (texture.Header.valid())
+            {
+                texture.Header.wait();
+            }
+
+            textureCache.Acquire(texture.Path, texture.ContentHash, id);
+            BindTexture(id);
+            return false;
+        }
+
+        GpuTexture gpuTexture;
+        bool streamed = false;
+        TextureStreamer::Handle handle = 0;
+        uint32_t baseLevel = 0;
+
+        if (texture.Container)
+        {
+            streamed = textureFeedback && texture.Container->Levels().size() > 1;
+
+            if (streamed)
+            {
+                std::vector<uint64_t> levelBytes;
+
+                for (const auto & level : texture.Container->Levels())
+                {
+                    levelBytes.push_back(level.Size);
+                }
+
+                handle = textureStreamer.Register(levelBytes);
+                baseLevel = textureStreamer.ResidentLevel(handle);
+            }
+
+            gpuTexture = UploadContainer(*texture.Container, baseLevel);
+        }
+        else
+        {
+            gpuTexture = UploadDecoded(texture);
+            decoded = true;
+        }
+
+        textureCache.SetBudget(TextureMemoryBudget());
+        id = textureCache.Insert(texture.Path, texture.ContentHash, gpuTexture.Bytes);
+        textures[id] = gpuTexture;
+
+        // The container stays mapped so finer levels can be copied out of it later.
+        if (streamed)
+        {
+            streamedTextures[id] = { std::move(texture.Container), handle, baseLevel };
+        }
+
+        BindTexture(id);
+
+        return decoded;
+    }
+
+    std::vector<AtlasRegion> VulkanBackend::LoadAtlas(const std::vector<std::string> & paths)
+    {
+        PROFILE_ZONE("LoadAtlas");
+
+        // Keeps binds in call order with any loads still queued.
+        FinishTextureLoads();
+
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(physicalDevice, &properties);
+        const uint32_t maxPageSize = std::min(AtlasMaxPageSize, properties.limits.maxImageDimension2D);
+
+        // Every image is held until the page is built, so reject sets that cannot fit before decoding any.
+        // This also keeps them well inside the decode budget, which they could otherwise wait on forever.
+        uint64_t totalBytes = 0;
+
+        for (const auto & path : paths)
+        {
+            Util::IO::MappedFile file(path);
+            ImageHeader header;
+
+            if (!Image::ReadHeader(file.Data(), file.Size(), header))
+            {
+                throw std::runtime_error("Unrecognised image format: " + path);
+            }
+
+            totalBytes += header.Size();
+        }
+
+        if (totalBytes > (uint64_t)maxPageSize * maxPageSize * 4)
+        {
+            throw std::runtime_error("atlas images do not fit a single page!");
+        }
+
+        std::vector<std::vector<uint8_t>> pixels(paths.size());
+        std::vector<ImageLoader::Reservation> budgets(paths.size());
+        std::vector<std::future<ImageHeader>> headers;
+
+        try
+        {
+            for (size_t i = 0; i < paths.size(); i++)
+            {
+                auto destination = &pixels[i];
+                auto budget = &budgets[i];
+
+                headers.push_back(imageLoader.Load(paths[i], [destination, budget](const ImageHeader & header, ImageLoader::Reservation reservation)
+                {
+                    destination->resize(header.Size());
+                    *budget = std::move(reservation);
+                    return destination->data();
+                }));
+            }
+        }
+        catch (...)
+        {
+            for (auto & header : headers)
+            {
+                header.wait();
+            }
+
+            throw;
+        }
+
+        std::vector<AtlasImage> images;
+        std::string name = "atlas:";
+        std::exception_ptr error;
+
+        // Every decode has to finish before pixels goes away, so a failure is only rethrown at the end.
+        for (size_t i = 0; i < paths.size(); i++)
+        {
+            try
+            {
+                const auto header = headers[i].get();
+                images.push_back({ pixels[i].data(), header.Width, header.Height });
+                name += paths[i] + ";";
+            }
+            catch (...)
+            {
+                if (!error)
+                {
+                    error = std::current_exception();
+                }
+            }
+        }
+
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+
+        // Only one texture is bound at a time, so grow the page until everything fits on it.
+        std::unique_ptr<TextureAtlas> atlas;
+        std::vector<AtlasRegion> regions;
+
+        for (uint32_t pageSize = AtlasMinPageSize; pageSize <= maxPageSize; pageSize *= 2)
+        {
+            atlas = std::make_unique<TextureAtlas>(pageSize, AtlasPadding);
+            regions = atlas->Build(images);
+
+            if (atlas->Pages().size() == 1)
+            {
+                break;
+            }
+        }
+
+        if (!atlas || atlas->Pages().size() != 1)
+        {
+            throw std::runtime_error("atlas images do not fit a single page!");
+        }
+
+        const auto & page = atlas->Pages()[0];
+        const uint64_t contentHash = TextureCache::Hash(page.data(), page.size());
+        TextureCache::Id id;
+
+        if (!textureCache.Acquire(name, contentHash, id))
+        {
+            const auto gpuTexture = UploadPixels(page.data(), atlas->PageSize(), atlas->PageSize(), atlas->LevelCount());
+
+            textureCache.SetBudget(TextureMemoryBudget());
+            id = textureCache.Insert(name, contentHash, gpuTexture.Bytes);
+            textures[id] = gpuTexture;
+        }
+
+        BindTexture(id);
+
+        LOG_INFO(logger, Assets, "Packed {} images into a {}x{} atlas, {}% occupied",
+            paths.size(), atlas->PageSize(), atlas->PageSize(), atlas->Occupancy(0) * 100.0f);
+
+        return regions;
+    }
+
+    GpuTexture VulkanBackend::UploadDecoded(PendingTexture & pending)
+    {
+        PROFILE_ZONE("UploadDecoded");
+
+        auto header = pending.Header.get();
+        return UploadPixels(pending.Pixels.data(), header.Width, header.Height, MipChain::LevelCount(header.Width, header.Height));
+    }
+
+    GpuTexture VulkanBackend::UploadPixels(const uint8_t * pixels, uint32_t width, uint32_t height, uint32_t levelCount)
+    {
+        const auto levels = MipChain::Layout(width, height, 4);
+        VkFormat format = VK_FORMAT_R8G8B8A8_UNORM;
+
+        auto blockFormat = textureBlockFormat;
+        if (blockFormat == BlockFormat::BC1 && BlockCompressor::HasAlpha(pixels, width, height))
+        {
+            blockFormat = BlockFormat::BC3;
+        }
+
+        const bool compress = textureCompressionBC && IsSampledFormatSupported(ToVkFormat(blockFormat));
+        std::vector<uint8_t> chain;
+
+        if (compress)
+        {
+            chain.resize(MipChain::TotalSize(levels));
+            MipChain::Generate(pixels, width, height, textureMipFilter, true, chain.data());
+            format = ToVkFormat(blockFormat);
+        }
+
+        // Generate always writes the whole chain, only the first levelCount levels are uploaded.
+        auto uploadLevels = compress ? BlockCompressor::Layout(blockFormat, width, height) : levels;
+        uploadLevels.resize(std::min<size_t>(levelCount, uploadLevels.size()));
+        const auto uploadSize = compress ? MipChain::TotalSize(uploadLevels) : MipChain::TotalSize(levels);
+
         VkBuffer stagingBuffer;
-        VkDeviceMemory mem;
+        VkDeviceMemory stagingMemory;
 
-        auto dataSize = modelData.size() * sizeof(modelData[0]);
-        CreateBuffer(device,
+        CreateBuffer(
+            device,
             physicalDevice,
-            dataSize,
+            uploadSize,
             VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
             queueIndicies,
             stagingBuffer,
-            mem);
+            stagingMemory);
 
-        void * data;
+        // Both the chain and the blocks are only ever written here, so they can go straight into mapped memory.
+        void* data;
+        CHECK_ERROR(vkMapMemory(device, stagingMemory, 0, uploadSize, 0, &data));
 
-        vkMapMemory(device, mem, 0, dataSize, 0, &data);
+        if (compress)
+        {
+            const auto start = std::chrono::steady_clock::now();
 
-        memcpy(data, modelData.data(), dataSize);
+            for (size_t l = 0; l < uploadLevels.size(); l++)
+            {
+                BlockCompressor::Encode(
+                    blockFormat,
+                    chain.data() + levels[l].Offset,
+                    levels[l].Width,
+                    levels[l].Height,
+                    (uint8_t *)data + uploadLevels[l].Offset);
+            }
 
-        vkUnmapMemory(device, mem);
+            LOG_INFO(logger, Assets, "Block compressed {}x{} texture to {} KB in {} ms", width, height, uploadSize / 1024,
+                std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count());
+        }
+        else
+        {
+            MipChain::Generate(pixels, width, height, textureMipFilter, true, (uint8_t *)data);
+        }
+
+        vkUnmapMemory(device, stagingMemory);
 
-        CopyBuffer(stagingBuffer, vertexBuffer, device, transferQueue, transientCommandPool, dataSize);
+        auto texture = CreateTextureImage(stagingBuffer, format, width, height, 1, uploadLevels);
 
-        vkFreeMemory(device, mem, nullptr);
         vkDestroyBuffer(device, stagingBuffer, nullptr);
+        vkFreeMemory(device, stagingMemory, nullptr);
+
+        return texture;
+    }
+
+    GpuTexture VulkanBackend::UploadContainer(const TextureContainer & container, uint32_t firstLevel)
+    {
+        PROFILE_ZONE("UploadContainer");
+
+        if (!IsSampledFormatSupported(container.Format()))
+        {
+            throw std::runtime_error("texture container format is not supported by the device!");
+        }
 
-        dataSize = indices.size() * sizeof(uint32_t);
+        const auto levels = container.Levels(firstLevel);
+        const auto uploadSize = MipChain::TotalSize(levels);
 
-        CreateBuffer(device,
+        VkBuffer stagingBuffer;
+        VkDeviceMemory stagingMemory;
+
+        CreateBuffer(
+            device,
             physicalDevice,
-            dataSize,
+            uploadSize,
             VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
             queueIndicies,
             stagingBuffer,
-            mem);
-        vkMapMemory(device, mem, 0, dataSize, 0, &data);
+            stagingMemory);
 
-        memcpy(data, indices.data(), dataSize);
-        vkUnmapMemory(device, mem);
+        void* data;
+        CHECK_ERROR(vkMapMemory(device, stagingMemory, 0, uploadSize, 0, &data));
+        container.CopyTo((uint8_t *)data, firstLevel);
+        vkUnmapMemory(device, stagingMemory);
+
+        auto texture = CreateTextureImage(stagingBuffer, container.Format(), levels[0].Width, levels[0].Height, container.LayerCount(), levels);
 
-        CopyBuffer(stagingBuffer, indexBuffer, device, transferQueue, transientCommandPool, dataSize);
-        vkFreeMemory(device, mem, nullptr);
         vkDestroyBuffer(device, stagingBuffer, nullptr);
-        RecordRender();
+        vkFreeMemory(device, stagingMemory, nullptr);
+
+        return texture;
     }
 
-    void VulkanBackend::LoadTexture(const std::string & path)
+    GpuTexture VulkanBackend::CreateTextureImage(VkBuffer stagingBuffer, VkFormat format, uint32_t width, uint32_t height, uint32_t layers, const std::vector<MipLevel> & levels)
+    {
+        auto texture = AllocateTextureImage(format, width, height, layers, (uint32_t)levels.size());
+
+        auto commandBuffer = BeginSingleTimeCommands(presentCommandPool);
+        RecordTextureUpload(commandBuffer, stagingBuffer, texture.Image, layers, levels);
+        EndSingleTimeCommands(commandBuffer);
+
+        return texture;
+    }
+
+    GpuTexture VulkanBackend::AllocateTextureImage(VkFormat format, uint32_t width, uint32_t height, uint32_t layers, uint32_t mipLevels)
+    {
+        GpuTexture texture;
+
+        CreateImage(
+            width,
+            height,
+            mipLevels,
+            layers,
+            format,
+            VK_IMAGE_TILING_OPTIMAL,
+            VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+            texture.Image,
+            texture.Memory);
+
+        VkMemoryRequirements memRequirements;
+        vkGetImageMemoryRequirements(device, texture.Image, &memRequirements);
+        texture.Bytes = memRequirements.size;
+
+        texture.View = CreateImageView(texture.Image, format, VK_IMAGE_ASPECT_COLOR_BIT, mipLevels);
+        return texture;
+    }
+
+    void VulkanBackend::RecordTextureUpload(VkCommandBuffer commandBuffer, VkBuffer stagingBuffer, VkImage image, uint32_t layers, const std::vector<MipLevel> & levels)
+    {
+        VkImageMemoryBarrier barrier = {};
+        barrier.sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER;
+        barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        barrier.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+        barrier.image = image;
+        barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        barrier.subresourceRange.baseMipLevel = 0;
+        barrier.subresourceRange.levelCount = (uint32_t)levels.size();
+        barrier.subresourceRange.baseArrayLayer = 0;
+        barrier.subresourceRange.layerCount = layers;
+        barrier.srcAccessMask = 0;
+        barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+
+        CopyBufferToImage(commandBuffer, stagingBuffer, image, layers, levels);
+
+        barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+        barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+        barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+
+        vkCmdPipelineBarrier(commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0, 0, nullptr, 0, nullptr, 1, &barrier);
+    }
+
+    void VulkanBackend::BindTexture(TextureCache::Id id)
     {
-        auto img = Image::Open(path);
+        // The bound texture already holds a reference, drop the one the lookup just added.
+        if (id == boundTexture)
+        {
+            textureCache.Release(id);
+            return;
+        }
+
+        const auto previous = boundTexture;
+        boundTexture = id;
+
+        // Once the descriptor sets exist they have to point at the new image, and the command buffers
+        // that bind them be re-recorded, before the old image may be evicted.
+        if (!descriptorSets.empty())
+        {
+            vkDeviceWaitIdle(device);
+            UpdateTextureDescriptors();
+            RecordRender();
+            ClearStaleCommandBuffers();
+        }
 
-        VkBuffer ttr;
-        VkDeviceMemory mem;
+        if (previous != TextureCache::InvalidId)
+        {
+            textureCache.Release(previous);
+        }
+    }
+
+    void VulkanBackend::UpdateTextureDescriptors()
+    {
+        for (size_t i = 0; i < descriptorSets.size(); i++)
+        {
+            UpdateTextureDescriptors(i);
+        }
+    }
+
+    void VulkanBackend::UpdateTextureDescriptors(size_t index)
+    {
+        VkDescriptorImageInfo imageInfo = {};
+        imageInfo.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        imageInfo.imageView = textures.at(boundTexture).View;
+        imageInfo.sampler = textureSampler;
+
+        VkWriteDescriptorSet descriptorWrite = {};
+        descriptorWrite.sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET;
+        descriptorWrite.dstSet = descriptorSets[index];
+        descriptorWrite.dstBinding = 1;
+        descriptorWrite.dstArrayElement = 0;
+        descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        descriptorWrite.descriptorCount = 1;
+        descriptorWrite.pImageInfo = &imageInfo;
+
+        vkUpdateDescriptorSets(device, 1, &descriptorWrite, 0, nullptr);
+    }
+
+    void VulkanBackend::DestroyTexture(TextureCache::Id id)
+    {
+        for (auto upload = streamingUploads.begin(); upload != streamingUploads.end();)
+        {
+            if (upload->Texture != id)
+            {
+                ++upload;
+                continue;
+            }
+
+            // The copy reads the container, which goes away with the texture.
+            upload->Copied.wait();
+            vkUnmapMemory(device, upload->StagingMemory);
+            vkDestroyBuffer(device, upload->Staging, nullptr);
+            vkFreeMemory(device, upload->StagingMemory, nullptr);
+            upload = streamingUploads.erase(upload);
+        }
+
+        auto streamed = streamedTextures.find(id);
+
+        if (streamed != streamedTextures.end())
+        {
+            textureStreamer.Unregister(streamed->second.Handle);
+            streamedTextures.erase(streamed);
+        }
+
+        auto found = textures.find(id);
+
+        if (found == textures.end())
+        {
+            return;
+        }
+
+        // This frame's upload commands may already copy into it.
+        Retire({ found->second, VK_NULL_HANDLE, VK_NULL_HANDLE, frameNumber });
+
+        textures.erase(found);
+    }
+
+    void VulkanBackend::UpdateStreaming(uint32_t index)
+    {
+        PROFILE_ZONE("Update streaming");
+
+        // Finishing an upload can evict other textures, which drops their uploads from the list.
+        std::vector<StreamingUpload> ready;
+
+        for (auto upload = streamingUploads.begin(); upload != streamingUploads.end();)
+        {
+            if (upload->Copied.wait_for(std::chrono::seconds(0)) == std::future_status::ready)
+            {
+                ready.push_back(std::move(*upload));
+                upload = streamingUploads.erase(upload);
+            }
+            else
+            {
+                ++upload;
+            }
+        }
+
+        for (auto & upload : ready)
+        {
+            FinishStreamingUpload(upload);
+        }
+
+        if (streamedTextures.empty())
+        {
+            return;
+        }
+
+        // Written by this image's previous frame, which DrawFrame has waited for. A stale command buffer
+        // sampled the image from before the last swap, so its feedback is relative to the old base level.
+        const bool stale = index < staleCommandBuffers.size() && staleCommandBuffers[index];
+
+        int32_t minLod;
+        void* data;
+        CHECK_ERROR(vkMapMemory(device, feedbackBuffersMemory[index], 0, sizeof(minLod), 0, &data));
+        memcpy(&minLod, data, sizeof(minLod));
+        vkUnmapMemory(device, feedbackBuffersMemory[index]);
+
+        const auto bound = streamedTextures.find(boundTexture);
+
+        if (bound != streamedTextures.end() && minLod != NoFeedback && !stale)
+        {
+            const int32_t level = std::max(0, (int32_t)bound->second.BaseLevel + minLod);
+            textureStreamer.Request(bound->second.Handle, (uint32_t)level);
+        }
+
+        for (const auto & request : textureStreamer.Schedule())
+        {
+            for (const auto & streamed : streamedTextures)
+            {
+                if (streamed.second.Handle == request.Handle)
+                {
+                    StartStreamingUpload(streamed.first, request.Level);
+                    break;
+                }
+            }
+        }
+    }
+
+    void VulkanBackend::StartStreamingUpload(TextureCache::Id id, uint32_t level)
+    {
+        const TextureContainer * source = streamedTextures.at(id).Source.get();
+        const auto uploadSize = source->UploadSize(level);
+
+        StreamingUpload upload;
+        upload.Texture = id;
+        upload.Level = level;
 
         CreateBuffer(
             device,
             physicalDevice,
-            img->Size(),
+            uploadSize,
             VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
             VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
             queueIndicies,
-            ttr,
-            mem);
+            upload.Staging,
+            upload.StagingMemory);
 
         void* data;
-        vkMapMemory(device, mem, 0, img->Size(), 0, &data);
-        memcpy(data, img->Data(), static_cast<size_t>(img->Size()));
-        vkUnmapMemory(device, mem);
+        CHECK_ERROR(vkMapMemory(device, upload.StagingMemory, 0, uploadSize, 0, &data));
+        auto destination = (uint8_t *)data;
 
-        CreateImage(
-            img->Width(),
-            img->Height(),
-            VK_FORMAT_R8G8B8A8_UNORM,
-            VK_IMAGE_TILING_OPTIMAL,
-            VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
-            VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
-            textureImage,
-            textureImageMemory);
+        // Faulting the levels in from disk happens on a pool thread, the frame only picks up the result.
+        upload.Copied = Util::Threading::ThreadPool::GetInstance()->Submit([source, destination, level]()
+        {
+            source->CopyTo(destination, level);
+        });
+
+        streamingUploads.push_back(std::move(upload));
+    }
+
+    void VulkanBackend::FinishStreamingUpload(StreamingUpload & upload)
+    {
+        PROFILE_ZONE("FinishStreamingUpload");
+
+        upload.Copied.get();
+        vkUnmapMemory(device, upload.StagingMemory);
+
+        auto streamed = streamedTextures.find(upload.Texture);
+
+        if (streamed != streamedTextures.end())
+        {
+            const auto & source = *streamed->second.Source;
+            const auto levels = source.Levels(upload.Level);
+            auto texture = AllocateTextureImage(source.Format(), levels[0].Width, levels[0].Height, source.LayerCount(), (uint32_t)levels.size());
+            RecordTextureUpload(UploadCommandBuffer(), upload.Staging, texture.Image, source.LayerCount(), levels);
+
+            // Frames in flight may still sample the old image, and the bound one stays in use until
+            // every render command buffer has been re-recorded.
+            auto & current = textures.at(upload.Texture);
+
+            if (upload.Texture == boundTexture && !descriptorSets.empty())
+            {
+                staleCommandBuffers.assign(commandBuffers.size(), true);
+                Retire({ current, VK_NULL_HANDLE, VK_NULL_HANDLE, PendingRetire });
+            }
+            else
+            {
+                Retire({ current, VK_NULL_HANDLE, VK_NULL_HANDLE, frameNumber });
+            }
+
+            current = texture;
+
+            streamed->second.BaseLevel = upload.Level;
+            textureStreamer.Complete(streamed->second.Handle, upload.Level);
+
+            const auto stats = textureStreamer.Stats();
+            LOG_INFO(logger, Assets, "Streamed texture {} to level {}, {} of {} MB streamed, {} loads, {} drops",
+                upload.Texture, upload.Level, stats.ResidentBytes / (1024 * 1024), stats.BudgetBytes / (1024 * 1024),
+                stats.Loads, stats.Drops);
+
+            textureCache.Resize(upload.Texture, texture.Bytes);
+        }
+
+        // The copy out of it runs with this frame.
+        Retire({ {}, upload.Staging, upload.StagingMemory, frameNumber });
+    }
+
+    VkCommandBuffer VulkanBackend::UploadCommandBuffer()
+    {
+        const auto commandBuffer = uploadCommandBuffers[currentFrame];
+
+        if (!uploadRecording)
+        {
+            VkCommandBufferBeginInfo beginInfo = {};
+            beginInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO;
+            beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+
+            if (vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
+            {
+                throw std::runtime_error("failed to begin recording upload command buffer!");
+            }
+
+            uploadRecording = true;
+        }
+
+        return commandBuffer;
+    }
+
+    void VulkanBackend::CreateUploadCommandBuffers()
+    {
+        VkCommandPoolCreateInfo poolInfo = {};
+        poolInfo.sType = VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO;
+        poolInfo.queueFamilyIndex = queueIndicies[0];
+        poolInfo.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT | VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+
+        if (vkCreateCommandPool(device, &poolInfo, nullptr, &uploadCommandPool) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to create upload command pool!");
+        }
+
+        uploadCommandBuffers.resize(MAX_FRAMES_IN_FLIGHT);
+
+        VkCommandBufferAllocateInfo allocInfo = {};
+        allocInfo.sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO;
+        allocInfo.commandPool = uploadCommandPool;
+        allocInfo.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        allocInfo.commandBufferCount = (uint32_t)uploadCommandBuffers.size();
+
+        if (vkAllocateCommandBuffers(device, &allocInfo, uploadCommandBuffers.data()) != VK_SUCCESS)
+        {
+            throw std::runtime_error("failed to allocate upload command buffers!");
+        }
+    }
 
-        TransitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL);
-        CopyBufferToImage(ttr, textureImage, img->Width(), img->Height());
-        TransitionImageLayout(textureImage, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    void VulkanBackend::RefreshCommandBuffer(uint32_t index)
+    {
+        if (index >= staleCommandBuffers.size() || !staleCommandBuffers[index])
+        {
+            return;
+        }
 
-        textureImageView = CreateImageView(textureImage, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT);
+        // DrawFrame has waited for the frame that last rendered this image, so neither is in use.
+        UpdateTextureDescriptors(index);
+        RecordRender(index);
+        staleCommandBuffers[index] = false;
 
-        delete img;
+        if (std::none_of(staleCommandBuffers.begin(), staleCommandBuffers.end(), [](bool stale) { return stale; }))
+        {
+            ClearStaleCommandBuffers();
+        }
+    }
+
+    void VulkanBackend::ClearStaleCommandBuffers()
+    {
+        staleCommandBuffers.clear();
+
+        // Nothing recorded from here on refers to the images swapped out.
+        for (auto & resources : retired)
+        {
+            if (resources.Frame == PendingRetire)
+            {
+                resources.Frame = frameNumber;
+            }
+        }
+    }
+
+    void VulkanBackend::Retire(const RetiredResources & resources)
+    {
+        retired.push_back(resources);
+    }
+
+    void VulkanBackend::ReleaseRetired(bool all)
+    {
+        for (auto resources = retired.begin(); resources != retired.end();)
+        {
+            // Waiting on this frame's fence finished every frame up to MAX_FRAMES_IN_FLIGHT back.
+            if (!all && (resources->Frame == PendingRetire || resources->Frame + MAX_FRAMES_IN_FLIGHT > frameNumber))
+            {
+                ++resources;
+                continue;
+            }
+
+            if (resources->Texture.View != VK_NULL_HANDLE)
+            {
+                vkDestroyImageView(device, resources->Texture.View, nullptr);
+                vkDestroyImage(device, resources->Texture.Image, nullptr);
+                vkFreeMemory(device, resources->Texture.Memory, nullptr);
+            }
+
+            if (resources->Buffer != VK_NULL_HANDLE)
+            {
+                vkDestroyBuffer(device, resources->Buffer, nullptr);
+                vkFreeMemory(device, resources->Memory, nullptr);
+            }
+
+            resources = retired.erase(resources);
+        }
+    }
+
+    void VulkanBackend::ResetFeedback()
+    {
+        for (const auto & memory : feedbackBuffersMemory)
+        {
+            void* data;
+            CHECK_ERROR(vkMapMemory(device, memory, 0, sizeof(NoFeedback), 0, &data));
+            memcpy(data, &NoFeedback, sizeof(NoFeedback));
+            vkUnmapMemory(device, memory);
+        }
+    }
+
+    uint64_t VulkanBackend::TextureMemoryBudget()
+    {
+        if (!memoryBudget)
+        {
+            return TextureCacheBudget;
+        }
+
+        auto getMemoryProperties2 = (PFN_vkGetPhysicalDeviceMemoryProperties2KHR)vkGetInstanceProcAddr(instance, "vkGetPhysicalDeviceMemoryProperties2KHR");
+
+        if (getMemoryProperties2 == nullptr)
+        {
+            return TextureCacheBudget;
+        }
+
+        VkPhysicalDeviceMemoryBudgetPropertiesEXT budget = {};
+        budget.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT;
+
+        VkPhysicalDeviceMemoryProperties2KHR properties = {};
+        properties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2_KHR;
+        properties.pNext = &budget;
+
+        getMemoryProperties2(physicalDevice, &properties);
+
+        uint64_t available = 0;
+
+        for (uint32_t i = 0; i < properties.memoryProperties.memoryHeapCount; i++)
+        {
+            if ((properties.memoryProperties.memoryHeaps[i].flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) && budget.heapBudget[i] > budget.heapUsage[i])
+            {
+                available += budget.heapBudget[i] - budget.heapUsage[i];
+            }
+        }
+
+        // The cache's own textures are already part of the reported usage.
+        return std::min(TextureCacheBudget, available + textureCache.Stats().ResidentBytes);
+    }
+
+    TextureCacheStats VulkanBackend::TextureStats() const
+    {
+        return textureCache.Stats();
+    }
+
+    bool VulkanBackend::IsSampledFormatSupported(VkFormat format)
+    {
+        VkFormatProperties properties;
+        vkGetPhysicalDeviceFormatProperties(physicalDevice, format, &properties);
+
+        const VkFormatFeatureFlags required = VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT;
+        return (properties.optimalTilingFeatures & required) == required;
     }
 
     void VulkanBackend::CreateTextureSampler()
@@ -1531,7 +2779,7 @@ namespace Graphics::Vulkan
         samplerInfo.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
         samplerInfo.mipLodBias = 0.0f;
         samplerInfo.minLod = 0.0f;
-        samplerInfo.maxLod = 0.0f;
+        samplerInfo.maxLod = VK_LOD_CLAMP_NONE;
         if (vkCreateSampler(device, &samplerInfo, nullptr, &textureSampler) != VK_SUCCESS)
         {
             throw std::runtime_error("failed to create texture sampler!");
@@ -1543,98 +2791,64 @@ namespace Graphics::Vulkan
         return new VulkanBackend(window, loadedShaders);
     }
 
-    void VulkanBackend::HandleEvent(Events::Event * evt)
+    void VulkanBackend::HandleEvent(const Events::MouseMoveEvent & evt)
     {
-        Events::KeyEvent * keyEvent = dynamic_cast<Events::KeyEvent *> (evt);
-        Events::MouseEvent * mouseEvent = dynamic_cast<Events::MouseEvent *> (evt);
-
-        if (keyEvent == nullptr)
-        {
-            HandleMouseEvent(mouseEvent);
-        }
-        else
-        {
-            HandleKeyEvent(keyEvent);
-        }
-    }
-
-    void VulkanBackend::HandleMouseEvent(Events::MouseEvent * evt)
-    {
-        auto move = dynamic_cast<Events::MouseMoveEvent *>(evt);
-        auto press = dynamic_cast<Events::MouseButtonPressEvent *>(evt);
-        auto hold = dynamic_cast<Events::MouseButtonPressHoldEvent *>(evt);
-        auto release = dynamic_cast<Events::MouseButtonReleaseEvent *>(evt);
-
-        if (move != nullptr)
-        {
-            auto fbWidth = caps.currentExtent.width;
-            auto fbHeight = caps.currentExtent.height;
+        // The cursor is captured, so this arrives once a frame with the whole frame's motion.
+        this->verticalAngle -= this->mouseSpeed * 0.1f * float(evt.DeltaY);
+        this->horizontalAngle -= this->mouseSpeed * 0.1f * float(evt.DeltaX);
 
-            this->verticalAngle += this->mouseSpeed * 0.1f  * float(fbHeight / 2 - move->Y);
-            this->horizontalAngle += this->mouseSpeed  * 0.1f * float(fbWidth / 2 - move->X);
+        direction = glm::vec3(
+            cos(this->verticalAngle) * sin(this->horizontalAngle),
+            sin(this->verticalAngle),
+            cos(this->verticalAngle) * cos(this->horizontalAngle));
 
-            direction = glm::vec3(
-                cos(this->verticalAngle) * sin(this->horizontalAngle),
-                sin(this->verticalAngle),
-                cos(this->verticalAngle) * cos(this->horizontalAngle));
+        right = glm::vec3
+        (
+            sin(this->horizontalAngle - M_PI_2),
+            0,
+            cos(this->horizontalAngle - M_PI_2)
+        );
 
-            right = glm::vec3
-            (
-                sin(this->horizontalAngle - M_PI_2),
-                0,
-                cos(this->horizontalAngle - M_PI_2)
-            );
+        glm::vec3 up = glm::cross(right, direction);
+    }
 
-            glm::vec3 up = glm::cross(right, direction);
+    void VulkanBackend::HandleEvent(const Events::KeyPressEvent & evt)
+    {
+        LOG_DEBUG(logger, Input, "{} was pressed", Input::Keyboard::KeyToString(evt.Key));
+    }
 
-            glfwSetCursorPos(this->window, fbWidth / 2, fbHeight / 2);
-        }
+    void VulkanBackend::HandleEvent(const Events::KeyReleaseEvent & evt)
+    {
+        LOG_DEBUG(logger, Input, "{} was released", Input::Keyboard::KeyToString(evt.Key));
     }
 
-    void VulkanBackend::HandleKeyEvent(Events::KeyEvent * evt)
+    void VulkanBackend::HandleEvent(const Events::KeyHoldEvent & evt)
     {
-        Events::KeyPressEvent * press = dynamic_cast<Events::KeyPressEvent *>(evt);
-        Events::KeyReleaseEvent * release = dynamic_cast<Events::KeyReleaseEvent *>(evt);;
-        Events::KeyHoldEvent * hold = dynamic_cast<Events::KeyHoldEvent *>(evt);;
+        LOG_DEBUG(logger, Input, "{} was held", Input::Keyboard::KeyToString(evt.Key));
+    }
 
-        Input::Key keyPressed = Input::Key::None;
+    void VulkanBackend::UpdateCamera(const Input::InputSnapshot & input)
+    {
+        const float step = moveSpeed * float(input.DeltaTime);
 
-        if (press != nullptr)
+        if (input.KeyDown(GLFW_KEY_W))
         {
-            logger.Debug((Input::Keyboard::KeyToString(press->Key) + " was pressed").c_str());
-            keyPressed = press->Key;
+            position += direction * step;
         }
-        else if (release != nullptr)
+
+        if (input.KeyDown(GLFW_KEY_S))
         {
-            logger.Debug((Input::Keyboard::KeyToString(release->Key) + " was released").c_str());
-            keyPressed = Input::Key::None;
+            position -= direction * step;
         }
-        else if (hold != nullptr)
+
+        if (input.KeyDown(GLFW_KEY_A))
         {
-            logger.Debug((Input::Keyboard::KeyToString(hold->Key) + " was held").c_str());
-            keyPressed = hold->Key;
+            position -= right * step;
         }
 
-        if (keyPressed == Input::Key::None)
-            return;
-
-        switch (keyPressed)
+        if (input.KeyDown(GLFW_KEY_D))
         {
-        case Input::Key::W:
-            position += direction * moveSpeed;
-            break;
-
-        case Input::Key::S:
-            position -= direction * moveSpeed;
-            break;
-
-        case Input::Key::A:
-            position -= right * moveSpeed;
-            break;
-
-        case Input::Key::D:
-            position += right * moveSpeed;
-            break;
+            position += right * step;
         }
     }
 
@@ -1642,7 +2856,12 @@ namespace Graphics::Vulkan
         Graphics::ShaderList loadedShaders) :
         loadedShaders(loadedShaders),
         window(window),
-        logger("debug.log", Util::Logging::LogLevel::Trace, true)
+        logger("debug.log", Util::Logging::CompiledLogLevel, Util::Logging::Overflow::Block),
+        validationFilter(logger),
+        gpuProfiler(logger),
+        imageLoader(Util::Threading::ThreadPool::GetInstance(), TextureDecodeBudget),
+        textureCache(TextureCacheBudget, [this](TextureCache::Id id) { DestroyTexture(id); }),
+        textureStreamer(StreamingBudget, StreamingTailBytes, StreamingLoadsInFlight, StreamingIdleFrames)
     {
     }
 
@@ -1660,6 +2879,7 @@ namespace Graphics::Vulkan
         vkDestroySurfaceKHR(instance, surface, nullptr);
         vkDestroyCommandPool(device, presentCommandPool, nullptr);
         vkDestroyCommandPool(device, transientCommandPool, nullptr);
+        vkDestroyCommandPool(device, uploadCommandPool, nullptr);
 
         for (const auto & semaphore : imageAvailableSemaphores)
         {
@@ -1680,8 +2900,16 @@ namespace Graphics::Vulkan
         vkDestroyImage(device, depthImage, nullptr);
         vkFreeMemory(device, depthImageMemory, nullptr);
 
-        vkDestroyBuffer(device, indexBuffer, nullptr);
-        vkFreeMemory(device, indexBufferMemory, nullptr);
+        while (!textures.empty())
+        {
+            DestroyTexture(textures.begin()->first);
+        }
+
+        ReleaseRetired(true);
+
+        vkDestroySampler(device, textureSampler, nullptr);
+
+        geometry.Destroy(device);
 
         for (const auto & uniformBuffer : uniformBuffers)
         {
@@ -1693,11 +2921,14 @@ namespace Graphics::Vulkan
             vkFreeMemory(device, uniformBuffersMemory, nullptr);
         }
 
+        DestroyIndirectBuffers();
+        DestroyFeedbackBuffers();
+
         vkDestroyDescriptorSetLayout(device, descriptorSetLayout, nullptr);
         vkDestroyDescriptorPool(device, descriptorPool, nullptr);
 
-        vkDestroyBuffer(device, vertexBuffer, nullptr);
-        vkFreeMemory(device, vertexBufferMemory, nullptr);
+        gpuProfiler.Summarize();
+        gpuProfiler.Destroy();
 
         vkDestroyDevice(device, nullptr);
 
@@ -1705,7 +2936,8 @@ namespace Graphics::Vulkan
 
         vkDestroyInstance(instance, nullptr);
 
-        logger.Info("backend cleaned up...");
+        validationFilter.Summarize();
+        LOG_INFO(logger, Vulkan, "backend cleaned up...");
     }
 
     void VulkanBackend::CleanupSwapchain()
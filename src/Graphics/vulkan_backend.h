@@ -5,6 +5,7 @@
 #include "fragmentShader.h"
 #include "shaderProgram.h"
 #include "../Utils/logger.h"
+#include "../Utils/profiler.h"
 #include "graphics_includes.h"
 #include "vertex.h"
 #include "projectionData.h"
@@ -18,9 +19,29 @@
 #include "../events/keyPressEvent.h"
 #include "../events/keyReleaseEvent.h"
 #include "../events/keyHoldEvent.h"
+#include "../Input/inputState.h"
 
 #include "image.h"
+#include "imageLoader.h"
+#include "mipChain.h"
+#include "blockCompression.h"
+#include "textureContainer.h"
+#include "textureCache.h"
+#include "textureStreamer.h"
+#include "textureAtlas.h"
+#include "meshOptimizer.h"
+#include "indexData.h"
+#include "meshLod.h"
+#include "geometryPool.h"
+#include "meshlet.h"
+#include "clusterCuller.h"
+#include "tangentSpace.h"
+#include "validationFilter.h"
+#include "gpuProfiler.h"
+#include <future>
+#include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #define _USE_MATH_DEFINES
@@ -28,6 +49,57 @@
 
 namespace Graphics::Vulkan
 {
+    struct PendingTexture
+    {
+        std::string Path;
+        uint64_t ContentHash;
+
+        std::future<ImageHeader> Header;
+
+        // Level 0 is decoded into ordinary memory since the mip chain is filtered from it.
+        std::vector<uint8_t> Pixels;
+        ImageLoader::Reservation Budget;
+
+        // Set instead of the above for KTX2 and DDS files, which are uploaded as stored.
+        std::unique_ptr<TextureContainer> Container;
+    };
+
+    struct GpuTexture
+    {
+        VkImage Image;
+        VkImageView View;
+        VkDeviceMemory Memory;
+        uint64_t Bytes;
+    };
+
+    // A container texture whose image holds only the levels from BaseLevel down.
+    struct StreamedTexture
+    {
+        std::unique_ptr<TextureContainer> Source;
+        TextureStreamer::Handle Handle;
+        uint32_t BaseLevel;
+    };
+
+    // Levels being copied out of the mapped container on a pool thread.
+    struct StreamingUpload
+    {
+        TextureCache::Id Texture;
+        uint32_t Level;
+        VkBuffer Staging;
+        VkDeviceMemory StagingMemory;
+        std::future<void> Copied;
+    };
+
+    // Replaced or evicted resources that frames in flight may still use. Any of the handles can be
+    // null, they're destroyed once the frame numbered Frame has been waited on.
+    struct RetiredResources
+    {
+        GpuTexture Texture;
+        VkBuffer Buffer;
+        VkDeviceMemory Memory;
+        uint64_t Frame;
+    };
+
     class VulkanBackend : public GraphicsBackend
     {
     public:
@@ -37,26 +109,58 @@ namespace Graphics::Vulkan
         void DrawFrame();
         void LoadProgram(const std::string & name);
         void LoadModel(const std::vector<Vertex> & modelData, const std::vector<uint32_t> & indices);
-        void HandleEvent(Events::Event * evt);
+        std::vector<AtlasRegion> LoadAtlas(const std::vector<std::string> & paths);
+        void HandleEvent(const Events::KeyPressEvent & evt);
+        void HandleEvent(const Events::KeyReleaseEvent & evt);
+        void HandleEvent(const Events::KeyHoldEvent & evt);
+        void HandleEvent(const Events::MouseMoveEvent & evt);
+
+        TextureCacheStats TextureStats() const;
 
         static VulkanBackend * Make(GLFWwindow *window, ShaderList shaderList);
     private:
 
         Util::Logging::Logger logger;
+        ValidationFilter validationFilter;
+        GpuProfiler gpuProfiler;
 
         VulkanBackend();
 
         VulkanBackend(GLFWwindow * window, ShaderList loadedShaders);
 
-        void HandleMouseEvent(Events::MouseEvent * evt);
-        void HandleKeyEvent(Events::KeyEvent * evt);
+        void UpdateCamera(const Input::InputSnapshot & input);
 
         void LoadTexture(const std::string & path);
+        void FinishTextureLoads();
+        bool FinishTextureLoad(PendingTexture & texture);
+        GpuTexture UploadDecoded(PendingTexture & pending);
+        GpuTexture UploadPixels(const uint8_t * pixels, uint32_t width, uint32_t height, uint32_t levelCount);
+        GpuTexture UploadContainer(const TextureContainer & container, uint32_t firstLevel);
+        GpuTexture CreateTextureImage(VkBuffer stagingBuffer, VkFormat format, uint32_t width, uint32_t height, uint32_t layers, const std::vector<MipLevel> & levels);
+        GpuTexture AllocateTextureImage(VkFormat format, uint32_t width, uint32_t height, uint32_t layers, uint32_t mipLevels);
+        void RecordTextureUpload(VkCommandBuffer commandBuffer, VkBuffer stagingBuffer, VkImage image, uint32_t layers, const std::vector<MipLevel> & levels);
+        void BindTexture(TextureCache::Id id);
+        void UpdateTextureDescriptors();
+        void UpdateTextureDescriptors(size_t index);
+        void DestroyTexture(TextureCache::Id id);
+        void UpdateStreaming(uint32_t index);
+        void StartStreamingUpload(TextureCache::Id id, uint32_t level);
+        void FinishStreamingUpload(StreamingUpload & upload);
+        VkCommandBuffer UploadCommandBuffer();
+        void CreateUploadCommandBuffers();
+        void RefreshCommandBuffer(uint32_t index);
+        void ClearStaleCommandBuffers();
+        void Retire(const RetiredResources & resources);
+        void ReleaseRetired(bool all);
+        void ResetFeedback();
+        uint64_t TextureMemoryBudget();
+        bool IsSampledFormatSupported(VkFormat format);
         void CreateSurface(GLFWwindow  *window, VkInstance instance);
         void CreateInstance(const std::string& title);
         void SetupDebugCallback(VkDebugUtilsMessengerEXT * callback);
         void SelectPhysicalDevice();
         void RecordRender();
+        void RecordRender(size_t index);
         void SetupTransientOpsQueue();
         void RecreateSwapChains();
         void CreateSwapChain(bool reuse);
@@ -69,10 +173,15 @@ namespace Graphics::Vulkan
         void CleanupSwapchain();
         void CreateLogicalDevice();
         void UpdateUniformData(uint32_t index);
+        void UpdateDrawCommand(uint32_t index);
+        void CreateIndirectBuffers(uint32_t commandCount);
+        void DestroyIndirectBuffers();
+        void CreateFeedbackBuffers();
+        void DestroyFeedbackBuffers();
         void CreateDescriptorSets();
         void CreateDepthResources();
         void CreateShaders();
-        void CopyBufferToImage(VkBuffer buffer, VkImage image, uint32_t width, uint32_t height);
+        void CopyBufferToImage(VkCommandBuffer commandBuffer, VkBuffer buffer, VkImage image, uint32_t layers, const std::vector<MipLevel> & levels);
         void CopyBuffer(
             VkBuffer srcBuffer,
             VkBuffer dstBuffer,
@@ -83,6 +192,8 @@ namespace Graphics::Vulkan
         void CreateImage(
             uint32_t width,
             uint32_t height,
+            uint32_t mipLevels,
+            uint32_t layers,
             VkFormat format,
             VkImageTiling tiling,
             VkImageUsageFlags usage,
@@ -90,17 +201,49 @@ namespace Graphics::Vulkan
             VkImage& image,
             VkDeviceMemory& imageMemory);
 
-        VkImageView CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags);
-        void TransitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout);
+        VkImageView CreateImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, uint32_t mipLevels);
+        void TransitionImageLayout(VkImage image, VkFormat format, VkImageLayout oldLayout, VkImageLayout newLayout, uint32_t mipLevels, uint32_t layers);
         void CreateTextureSampler();
         VkCommandBuffer BeginSingleTimeCommands(VkCommandPool pool);
         void EndSingleTimeCommands(VkCommandBuffer commandBuffer);
 
-        VkImage textureImage;
-        VkImageView textureImageView;
         VkSampler textureSampler;
-
-        VkDeviceMemory textureImageMemory;
+        MipFilter textureMipFilter = MipFilter::Kaiser;
+
+        // Textures are block compressed when the device can sample the format, otherwise uploaded as RGBA8.
+        // BC1 is promoted to BC3 for images with alpha.
+        bool textureCompressionBC = false;
+        BlockFormat textureBlockFormat = BlockFormat::BC7;
+
+        ImageLoader imageLoader;
+        std::vector<std::unique_ptr<PendingTexture>> pendingTextures;
+
+        // The descriptor sets sample boundTexture, which holds a reference in the cache.
+        TextureCache textureCache;
+        std::unordered_map<TextureCache::Id, GpuTexture> textures;
+        TextureCache::Id boundTexture = TextureCache::InvalidId;
+
+        // VK_EXT_memory_budget needs VK_KHR_get_physical_device_properties2 on the instance.
+        bool physicalDeviceProperties2 = false;
+        bool memoryBudget = false;
+
+        // Containers with a mip chain start at a small tail and stream finer levels as the fragment
+        // shader's feedback asks for them. Needs fragmentStoresAndAtomics for the feedback writes.
+        bool textureFeedback = false;
+        TextureStreamer textureStreamer;
+        std::unordered_map<TextureCache::Id, StreamedTexture> streamedTextures;
+        std::vector<StreamingUpload> streamingUploads;
+        std::vector<VkBuffer> feedbackBuffers;
+        std::vector<VkDeviceMemory> feedbackBuffersMemory;
+
+        // Streamed levels are copied by a command buffer submitted ahead of the frame's own. Swapping
+        // the bound image leaves every render command buffer stale, each is re-recorded when its
+        // swapchain image comes round, and the old image is retired once none of them use it.
+        VkCommandPool uploadCommandPool;
+        std::vector<VkCommandBuffer> uploadCommandBuffers;
+        bool uploadRecording = false;
+        std::vector<bool> staleCommandBuffers;
+        std::vector<RetiredResources> retired;
 
         GLFWwindow * window;
         VkDebugUtilsMessengerEXT callback;
@@ -123,6 +266,13 @@ namespace Graphics::Vulkan
         ShaderProgram currentProgram;
         std::vector<Vertex> currentModelVertices;
         std::vector<uint32_t> currentModelIndices;
+        std::vector<IndexRange> currentLods;
+        std::vector<float> currentLodErrors;
+        std::vector<std::vector<IndexRange>> currentClusters;
+        std::vector<ClusterCuller> currentCullers;
+        std::vector<uint32_t> visibleClusters;
+        BoundingSphere currentBounds;
+        int32_t currentVertexOffset = 0;
         VkViewport viewport;
         VkRect2D scissor;
         VkDescriptorSetLayout descriptorSetLayout;
@@ -146,17 +296,26 @@ namespace Graphics::Vulkan
         std::vector<VkSemaphore> renderFinishedSemaphores;
         std::vector<VkFence> inFlightFences;
 
-        VkSurfaceCapabilitiesKHR caps;
+        // The in-flight fence of the frame that last rendered each swapchain image.
+        std::vector<VkFence> imagesInFlight;
+        uint64_t frameNumber = 0;
 
-        VkBuffer vertexBuffer;
-        VkDeviceMemory vertexBufferMemory;
+        VkSurfaceCapabilitiesKHR caps;
 
-        VkBuffer indexBuffer;
-        VkDeviceMemory indexBufferMemory;
+        GeometryPool geometry;
 
         std::vector<VkBuffer> uniformBuffers;
         std::vector<VkDeviceMemory> uniformBuffersMemory;
 
+        std::vector<VkBuffer> indirectBuffers;
+        std::vector<VkDeviceMemory> indirectBuffersMemory;
+        uint32_t maxDrawCommands = 0;
+        bool multiDrawIndirect = false;
+
+        // Draws recorded into each command buffer when they are issued one by one.
+        std::vector<uint32_t> recordedDrawCounts;
+        bool pipelineStatistics = false;
+
         ProjectionData camera;
         glm::vec3 position;
         glm::vec3 direction;
@@ -169,8 +328,10 @@ namespace Graphics::Vulkan
         float verticalAngle = 0.0f;
         float horizontalAngle = 0.0f;
         float initialFOV = 45.0f;
-        float moveSpeed = 0.25f;
+        // World units per second.
+        float moveSpeed = 7.5f;
         float mouseSpeed = 0.005f;
+        float lodPixelThreshold = 1.0f;
 
         size_t currentFrame = 0;
         const uint32_t MAX_FRAMES_IN_FLIGHT = 2;
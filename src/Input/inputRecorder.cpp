@@ -0,0 +1,246 @@
+#include "inputRecorder.h"
+#include "keyboard.h"
+#include "mouse.h"
+#include "../Utils/mappedFile.h"
+#include <string.h>
+#include <stdexcept>
+
+namespace Input
+{
+    namespace
+    {
+        const char Magic[4] = { 'I', 'N', 'P', 'R' };
+        const uint32_t Version = 1;
+
+        template <typename T>
+        void Write(std::ofstream & output, T value)
+        {
+            output.write((const char *)&value, sizeof(T));
+        }
+
+        template <typename T>
+        T Read(const uint8_t *& cursor, const uint8_t * end)
+        {
+            if ((size_t)(end - cursor) < sizeof(T))
+            {
+                throw std::runtime_error("Input recording is truncated");
+            }
+
+            T value;
+            memcpy(&value, cursor, sizeof(T));
+            cursor += sizeof(T);
+            return value;
+        }
+    }
+
+    InputRecorder * InputRecorder::instance = nullptr;
+
+    InputRecorder * InputRecorder::GetInstance()
+    {
+        if (instance == nullptr)
+        {
+            instance = new InputRecorder();
+        }
+
+        return instance;
+    }
+
+    void InputRecorder::StartRecording(const std::string & path)
+    {
+        InputRecorder * recorder = GetInstance();
+        recorder->output.open(path, std::ios::binary | std::ios::trunc);
+
+        if (!recorder->output.is_open())
+        {
+            throw std::runtime_error("Could not open " + path + " for recording");
+        }
+
+        recorder->output.write(Magic, sizeof(Magic));
+        Write(recorder->output, Version);
+    }
+
+    void InputRecorder::StartReplay(const std::string & path)
+    {
+        Util::IO::MappedFile file(path);
+        const uint8_t * cursor = file.Data();
+        const uint8_t * end = cursor + file.Size();
+
+        if (file.Size() < sizeof(Magic) + sizeof(Version) || memcmp(cursor, Magic, sizeof(Magic)) != 0)
+        {
+            throw std::runtime_error(path + " is not an input recording");
+        }
+
+        cursor += sizeof(Magic);
+
+        if (Read<uint32_t>(cursor, end) != Version)
+        {
+            throw std::runtime_error(path + " was recorded by an unsupported version");
+        }
+
+        InputRecorder * recorder = GetInstance();
+        recorder->replay.clear();
+        recorder->replayPosition = 0;
+        recorder->replayTime = 0.0;
+
+        while (cursor < end)
+        {
+            Record record = {};
+            record.Type = (RecordType)Read<uint8_t>(cursor, end);
+
+            switch (record.Type)
+            {
+            case RecordType::Frame:
+                record.X = Read<double>(cursor, end);
+                break;
+
+            case RecordType::Key:
+                record.Code = Read<int16_t>(cursor, end);
+                record.Scancode = Read<int32_t>(cursor, end);
+                record.Action = Read<uint8_t>(cursor, end);
+                record.Mods = Read<uint8_t>(cursor, end);
+                break;
+
+            case RecordType::Button:
+                record.Code = Read<uint8_t>(cursor, end);
+                record.Action = Read<uint8_t>(cursor, end);
+                record.Mods = Read<uint8_t>(cursor, end);
+                break;
+
+            case RecordType::Move:
+                record.X = Read<double>(cursor, end);
+                record.Y = Read<double>(cursor, end);
+                break;
+
+            default:
+                throw std::runtime_error(path + " has an unknown record type");
+            }
+
+            recorder->replay.push_back(record);
+        }
+
+        recorder->replaying = true;
+    }
+
+    void InputRecorder::Stop()
+    {
+        InputRecorder * recorder = GetInstance();
+
+        if (recorder->output.is_open())
+        {
+            recorder->output.close();
+        }
+
+        recorder->replay.clear();
+        recorder->replaying = false;
+    }
+
+    bool InputRecorder::Replaying()
+    {
+        return GetInstance()->replaying;
+    }
+
+    void InputRecorder::InstallCallbacks(GLFWwindow * window)
+    {
+        InputRecorder * recorder = GetInstance();
+
+        if (recorder->replaying)
+        {
+            return;
+        }
+
+        if (recorder->output.is_open())
+        {
+            glfwSetKeyCallback(window, RecordKey);
+            glfwSetCursorPosCallback(window, RecordMove);
+            glfwSetMouseButtonCallback(window, RecordButton);
+        }
+        else
+        {
+            glfwSetKeyCallback(window, Keyboard::HandleKey);
+            glfwSetCursorPosCallback(window, Mouse::HandleMouseMove);
+            glfwSetMouseButtonCallback(window, Mouse::HandleMouseClick);
+        }
+    }
+
+    double InputRecorder::PollEvents(GLFWwindow * window)
+    {
+        InputRecorder * recorder = GetInstance();
+
+        // Still pumped while replaying so the window stays responsive to the OS.
+        glfwPollEvents();
+
+        if (!recorder->replaying)
+        {
+            const double time = glfwGetTime();
+
+            if (recorder->output.is_open())
+            {
+                Write(recorder->output, (uint8_t)RecordType::Frame);
+                Write(recorder->output, time);
+            }
+
+            return time;
+        }
+
+        while (recorder->replayPosition < recorder->replay.size())
+        {
+            const Record & record = recorder->replay[recorder->replayPosition++];
+
+            switch (record.Type)
+            {
+            case RecordType::Frame:
+                recorder->replayTime = record.X;
+                return record.X;
+
+            case RecordType::Key:
+                Keyboard::HandleKey(window, record.Code, record.Scancode, record.Action, record.Mods);
+                break;
+
+            case RecordType::Button:
+                Mouse::HandleMouseClick(window, record.Code, record.Action, record.Mods);
+                break;
+
+            case RecordType::Move:
+                Mouse::HandleMouseMove(window, record.X, record.Y);
+                break;
+            }
+        }
+
+        // Out of frames, hold the last timestamp so this frame doesn't move anything.
+        glfwSetWindowShouldClose(window, GLFW_TRUE);
+        return recorder->replayTime;
+    }
+
+    void InputRecorder::RecordKey(GLFWwindow * window, int key, int scancode, int action, int mods)
+    {
+        std::ofstream & output = GetInstance()->output;
+        Write(output, (uint8_t)RecordType::Key);
+        Write(output, (int16_t)key);
+        Write(output, (int32_t)scancode);
+        Write(output, (uint8_t)action);
+        Write(output, (uint8_t)mods);
+
+        Keyboard::HandleKey(window, key, scancode, action, mods);
+    }
+
+    void InputRecorder::RecordButton(GLFWwindow * window, int button, int action, int mods)
+    {
+        std::ofstream & output = GetInstance()->output;
+        Write(output, (uint8_t)RecordType::Button);
+        Write(output, (uint8_t)button);
+        Write(output, (uint8_t)action);
+        Write(output, (uint8_t)mods);
+
+        Mouse::HandleMouseClick(window, button, action, mods);
+    }
+
+    void InputRecorder::RecordMove(GLFWwindow * window, double x, double y)
+    {
+        std::ofstream & output = GetInstance()->output;
+        Write(output, (uint8_t)RecordType::Move);
+        Write(output, x);
+        Write(output, y);
+
+        Mouse::HandleMouseMove(window, x, y);
+    }
+}
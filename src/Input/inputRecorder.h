@@ -0,0 +1,79 @@
+#ifndef INPUTRECORDER_H
+#define INPUTRECORDER_H
+
+#include "../Graphics/graphics_includes.h"
+#include <stdint.h>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace Input
+{
+    // Captures the raw GLFW key, button and cursor callbacks with the frame they arrived in, and
+    // plays them back through the same handlers so a run can repeat a recorded camera path exactly.
+    // The file is a small header followed by one record per callback, each frame closed by a record
+    // holding its timestamp. Replay also reuses those timestamps, so movement integrated by dt
+    // matches the recording regardless of how fast frames render.
+    class InputRecorder
+    {
+    public:
+        static void StartRecording(const std::string & path);
+
+        // Loads the whole file, throws if it isn't a recording.
+        static void StartReplay(const std::string & path);
+
+        static void Stop();
+
+        static bool Replaying();
+
+        // Points the GLFW callbacks at Keyboard and Mouse, through the recorder when recording.
+        // While replaying none are installed so live input can't leak into the run.
+        static void InstallCallbacks(GLFWwindow * window);
+
+        // Replaces glfwPollEvents in the main loop and returns the frame's timestamp. While
+        // replaying it feeds the next recorded frame instead, and asks the window to close once
+        // the recording runs out.
+        static double PollEvents(GLFWwindow * window);
+
+    private:
+        enum class RecordType : uint8_t
+        {
+            Frame,
+            Key,
+            Button,
+            Move
+        };
+
+        struct Record
+        {
+            RecordType Type;
+            int Code;
+            int Scancode;
+            int Action;
+            int Mods;
+            double X;
+            double Y;
+        };
+
+        InputRecorder()
+        {
+        }
+
+        static InputRecorder * GetInstance();
+
+        static void RecordKey(GLFWwindow * window, int key, int scancode, int action, int mods);
+        static void RecordButton(GLFWwindow * window, int button, int action, int mods);
+        static void RecordMove(GLFWwindow * window, double x, double y);
+
+        static InputRecorder * instance;
+
+        std::ofstream output;
+
+        std::vector<Record> replay;
+        size_t replayPosition = 0;
+        double replayTime = 0.0;
+        bool replaying = false;
+    };
+}
+
+#endif // !INPUTRECORDER_H
@@ -0,0 +1,101 @@
+#include "inputState.h"
+
+namespace Input
+{
+    namespace
+    {
+        template <size_t Count>
+        bool Test(const std::bitset<Count> & bits, int index)
+        {
+            return index >= 0 && (size_t)index < Count && bits.test(index);
+        }
+
+        template <size_t Count>
+        void Set(std::bitset<Count> & down, std::bitset<Count> & pressed, std::bitset<Count> & released, int index, bool isDown)
+        {
+            // GLFW_KEY_UNKNOWN is -1.
+            if (index < 0 || (size_t)index >= Count || down.test(index) == isDown)
+            {
+                return;
+            }
+
+            down.set(index, isDown);
+            (isDown ? pressed : released).set(index);
+        }
+    }
+
+    bool InputSnapshot::KeyDown(int key) const
+    {
+        return Test(Keys, key);
+    }
+
+    bool InputSnapshot::KeyPressed(int key) const
+    {
+        return Test(KeysPressed, key);
+    }
+
+    bool InputSnapshot::KeyReleased(int key) const
+    {
+        return Test(KeysReleased, key);
+    }
+
+    bool InputSnapshot::ButtonDown(int button) const
+    {
+        return Test(Buttons, button);
+    }
+
+    bool InputSnapshot::ButtonPressed(int button) const
+    {
+        return Test(ButtonsPressed, button);
+    }
+
+    bool InputSnapshot::ButtonReleased(int button) const
+    {
+        return Test(ButtonsReleased, button);
+    }
+
+    InputState * InputState::instance = nullptr;
+
+    InputState * InputState::GetInstance()
+    {
+        if (instance == nullptr)
+        {
+            instance = new InputState();
+        }
+
+        return instance;
+    }
+
+    void InputState::SetKey(int key, bool down)
+    {
+        InputSnapshot & live = GetInstance()->live;
+        Set(live.Keys, live.KeysPressed, live.KeysReleased, key, down);
+    }
+
+    void InputState::SetButton(int button, bool down)
+    {
+        InputSnapshot & live = GetInstance()->live;
+        Set(live.Buttons, live.ButtonsPressed, live.ButtonsReleased, button, down);
+    }
+
+    const InputSnapshot & InputState::Update(double time)
+    {
+        InputState * state = GetInstance();
+
+        state->live.DeltaTime = state->snapshot.Time > 0.0 ? time - state->snapshot.Time : 0.0;
+        state->live.Time = time;
+        state->snapshot = state->live;
+
+        state->live.KeysPressed.reset();
+        state->live.KeysReleased.reset();
+        state->live.ButtonsPressed.reset();
+        state->live.ButtonsReleased.reset();
+
+        return state->snapshot;
+    }
+
+    const InputSnapshot & InputState::Current()
+    {
+        return GetInstance()->snapshot;
+    }
+}
@@ -0,0 +1,61 @@
+#ifndef INPUTSTATE_H
+#define INPUTSTATE_H
+
+#include "../Graphics/graphics_includes.h"
+#include <bitset>
+
+namespace Input
+{
+    // Which keys and mouse buttons are down, indexed by GLFW key and button codes.
+    struct InputSnapshot
+    {
+        std::bitset<GLFW_KEY_LAST + 1> Keys;
+        std::bitset<GLFW_KEY_LAST + 1> KeysPressed;
+        std::bitset<GLFW_KEY_LAST + 1> KeysReleased;
+
+        std::bitset<GLFW_MOUSE_BUTTON_LAST + 1> Buttons;
+        std::bitset<GLFW_MOUSE_BUTTON_LAST + 1> ButtonsPressed;
+        std::bitset<GLFW_MOUSE_BUTTON_LAST + 1> ButtonsReleased;
+
+        // glfwGetTime when the snapshot was taken and the seconds since the one before.
+        double Time = 0.0;
+        double DeltaTime = 0.0;
+
+        bool KeyDown(int key) const;
+        bool KeyPressed(int key) const;
+        bool KeyReleased(int key) const;
+
+        bool ButtonDown(int button) const;
+        bool ButtonPressed(int button) const;
+        bool ButtonReleased(int button) const;
+    };
+
+    // Live key and button state written by the GLFW callbacks and frozen into a snapshot once a
+    // frame. Pressed and released hold every transition since the last snapshot, so a tap shorter
+    // than a frame still shows up. Main thread only, like the callbacks.
+    class InputState
+    {
+    public:
+        static void SetKey(int key, bool down);
+        static void SetButton(int button, bool down);
+
+        // Called once a frame after polling, with the frame's timestamp in seconds.
+        static const InputSnapshot & Update(double time);
+
+        static const InputSnapshot & Current();
+
+    private:
+        InputState()
+        {
+        }
+
+        static InputState * GetInstance();
+
+        static InputState * instance;
+
+        InputSnapshot live;
+        InputSnapshot snapshot;
+    };
+}
+
+#endif // !INPUTSTATE_H
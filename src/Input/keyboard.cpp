@@ -1,4 +1,5 @@
 #include "keyboard.h"
+#include "inputState.h"
 #include "../events/keyPressEvent.h"
 #include "../events/keyReleaseEvent.h"
 #include "../events/keyHoldEvent.h"
@@ -29,31 +30,31 @@ namespace Input
 
     void Keyboard::HandleKey(GLFWwindow* window, int key, int scancode, int action, int mods)
     {
+        InputState::SetKey(key, action != GLFW_RELEASE);
+
         Key pressedKey = GLFWKeyToKey(key, scancode, mods);
 
-        Events::Event * evt;
+        if (pressedKey == Key::None)
+        {
+            return;
+        }
 
         switch (action)
         {
         case GLFW_PRESS:
-            evt = new Events::KeyPressEvent(pressedKey);
+            Events::EventPump::PostEvent(Events::KeyPressEvent(pressedKey));
             break;
 
         case GLFW_RELEASE:
-            evt = new Events::KeyReleaseEvent(pressedKey);
+            Events::EventPump::PostEvent(Events::KeyReleaseEvent(pressedKey));
             break;
 
         case GLFW_REPEAT:
-            evt = new Events::KeyHoldEvent(pressedKey);
+            Events::EventPump::PostEvent(Events::KeyHoldEvent(pressedKey));
             break;
 
         default:
-            return;
-        }
-
-        if (pressedKey != Key::None)
-        {
-            Events::EventPump::FireEvent(evt);
+            break;
         }
     }
 
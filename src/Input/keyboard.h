@@ -21,7 +21,7 @@ namespace Input
         static Keyboard * GetInstance();
         static void DestroyInstance();
 
-        static std::string KeyToString(Key key)
+        static const char * KeyToString(Key key)
         {
             switch (key)
             {
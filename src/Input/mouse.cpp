@@ -1,4 +1,5 @@
 #include "mouse.h"
+#include "inputState.h"
 
 #include "../Events/mouseButtonPressEvent.h"
 #include "../Events/mouseButtonPressHoldEvent.h"
@@ -23,12 +24,56 @@ namespace Input
 
     void Mouse::HandleMouseMove(GLFWwindow * window, double x, double y)
     {
-        auto evt = new Events::MouseMoveEvent(x, y);
+        Mouse * mouse = GetInstance();
 
-        Events::EventPump::FireEvent(evt);
+        if (mouse->tracking)
+        {
+            mouse->deltaX += x - mouse->lastX;
+            mouse->deltaY += y - mouse->lastY;
+            mouse->moved = true;
+        }
+
+        mouse->lastX = x;
+        mouse->lastY = y;
+        mouse->tracking = true;
+    }
+
+    bool Mouse::CaptureCursor(GLFWwindow * window)
+    {
+        Mouse * mouse = GetInstance();
+        mouse->tracking = false;
+        mouse->moved = false;
+        mouse->deltaX = mouse->deltaY = 0.0;
+
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+
+#ifdef GLFW_RAW_MOUSE_MOTION
+        if (glfwRawMouseMotionSupported())
+        {
+            glfwSetInputMode(window, GLFW_RAW_MOUSE_MOTION, GLFW_TRUE);
+            return true;
+        }
+#endif
+        return false;
+    }
+
+    void Mouse::EndFrame()
+    {
+        Mouse * mouse = GetInstance();
+
+        if (!mouse->moved)
+        {
+            return;
+        }
+
+        Events::EventPump::PostEvent(Events::MouseMoveEvent(mouse->lastX, mouse->lastY, mouse->deltaX, mouse->deltaY));
+
+        mouse->deltaX = mouse->deltaY = 0.0;
+        mouse->moved = false;
     }
 
     void Mouse::HandleMouseClick(GLFWwindow * window, int button, int action, int mods)
     {
+        InputState::SetButton(button, action != GLFW_RELEASE);
     }
 }
\ No newline at end of file
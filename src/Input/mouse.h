@@ -18,6 +18,14 @@ namespace Input
         static void HandleMouseMove(GLFWwindow * window, double x, double y);
         static void HandleMouseClick(GLFWwindow * window, int button, int action, int mods);
 
+        // Hides and locks the cursor to the window and, where GLFW supports it, reads unaccelerated
+        // motion straight from the device. Returns whether raw motion is on.
+        static bool CaptureCursor(GLFWwindow * window);
+
+        // Posts one MouseMoveEvent carrying the motion summed since the last call, if there was any.
+        // Called once a frame after glfwPollEvents.
+        static void EndFrame();
+
         static Mouse * GetInstance();
 
     private:
@@ -26,6 +34,15 @@ namespace Input
         }
 
         static Mouse * Instance;
+
+        double lastX = 0.0;
+        double lastY = 0.0;
+        double deltaX = 0.0;
+        double deltaY = 0.0;
+
+        // The first position after capture only sets the baseline, it isn't a movement.
+        bool tracking = false;
+        bool moved = false;
     };
 }
 
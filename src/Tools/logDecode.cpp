@@ -0,0 +1,181 @@
+#include "../Utils/logFormat.h"
+#include <stdio.h>
+#include <string.h>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace Util::Logging;
+
+namespace
+{
+    class Reader
+    {
+    public:
+        Reader(const std::vector<uint8_t> & data) :
+            cursor(data.data()), end(data.data() + data.size())
+        {
+        }
+
+        bool AtEnd() const
+        {
+            return cursor == end;
+        }
+
+        template <typename T>
+        T Read()
+        {
+            T value;
+            memcpy(&value, Bytes(sizeof(T)), sizeof(T));
+            return value;
+        }
+
+        const uint8_t * Bytes(size_t count)
+        {
+            if ((size_t)(end - cursor) < count)
+            {
+                throw std::runtime_error("log is truncated");
+            }
+
+            const uint8_t * bytes = cursor;
+            cursor += count;
+            return bytes;
+        }
+
+        bool AtHeader() const
+        {
+            return (size_t)(end - cursor) >= sizeof(BinaryLogMagic) && memcmp(cursor, BinaryLogMagic, sizeof(BinaryLogMagic)) == 0;
+        }
+
+    private:
+        const uint8_t * cursor;
+        const uint8_t * end;
+    };
+
+    std::chrono::system_clock::time_point ToTime(int64_t micros)
+    {
+        return std::chrono::system_clock::time_point(std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::microseconds(micros)));
+    }
+
+    void Decode(const std::vector<uint8_t> & data, FILE * output)
+    {
+        Reader reader(data);
+        std::unordered_map<uint32_t, std::string> formats;
+        std::string line;
+        std::string message;
+
+        while (!reader.AtEnd())
+        {
+            if (reader.AtHeader())
+            {
+                reader.Bytes(sizeof(BinaryLogMagic));
+
+                if (reader.Read<uint32_t>() != BinaryLogVersion)
+                {
+                    throw std::runtime_error("log was written by an unsupported version");
+                }
+
+                // Each run that appended to the log numbered its formats from scratch.
+                formats.clear();
+                continue;
+            }
+
+            const BinaryLogEntry entry = (BinaryLogEntry)reader.Read<uint8_t>();
+            line.clear();
+
+            switch (entry)
+            {
+            case BinaryLogEntry::Format:
+            {
+                const uint32_t id = reader.Read<uint32_t>();
+                const uint16_t length = reader.Read<uint16_t>();
+                formats[id].assign((const char *)reader.Bytes(length), length);
+                break;
+            }
+
+            case BinaryLogEntry::Message:
+            {
+                const int64_t micros = reader.Read<int64_t>();
+                const LogLevel level = (LogLevel)reader.Read<uint8_t>();
+                const uint32_t id = reader.Read<uint32_t>();
+                const uint16_t length = reader.Read<uint16_t>();
+                const uint8_t * args = reader.Bytes(length);
+
+                auto format = formats.find(id);
+
+                if (format == formats.end())
+                {
+                    throw std::runtime_error("message uses format " + std::to_string(id) + " before it is defined");
+                }
+
+                message.clear();
+                RenderLogFormat(format->second.c_str(), args, length, message);
+                AppendLogLine(ToTime(micros), level, message.c_str(), message.length(), line);
+                break;
+            }
+
+            case BinaryLogEntry::Text:
+            {
+                const int64_t micros = reader.Read<int64_t>();
+                const LogLevel level = (LogLevel)reader.Read<uint8_t>();
+                const uint16_t length = reader.Read<uint16_t>();
+                AppendLogLine(ToTime(micros), level, (const char *)reader.Bytes(length), length, line);
+                break;
+            }
+
+            default:
+                throw std::runtime_error("unknown log entry");
+            }
+
+            fwrite(line.c_str(), 1, line.length(), output);
+        }
+    }
+}
+
+// Turns a binary log written with LogEncoding::Binary into the text format.
+int main(int argc, char * argv[])
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <binary log> [text output]\n", argv[0]);
+        return 1;
+    }
+
+    std::ifstream file(argv[1], std::ios::binary);
+
+    if (!file.is_open())
+    {
+        fprintf(stderr, "could not open %s\n", argv[1]);
+        return 1;
+    }
+
+    const std::vector<uint8_t> data((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    FILE * output = argc > 2 ? fopen(argv[2], "w") : stdout;
+
+    if (output == nullptr)
+    {
+        fprintf(stderr, "could not open %s for writing\n", argv[2]);
+        return 1;
+    }
+
+    try
+    {
+        Decode(data, output);
+    }
+    catch (const std::runtime_error & error)
+    {
+        fprintf(stderr, "%s: %s\n", argv[1], error.what());
+        return 1;
+    }
+
+    if (output != stdout)
+    {
+        fclose(output);
+    }
+
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include "cpuFeatures.h"
+
+#if defined(_M_X64) || defined(_M_IX86)
+#include <intrin.h>
+#define CPU_FEATURES_X86
+#elif defined(__x86_64__) || defined(__i386__)
+#include <cpuid.h>
+#define CPU_FEATURES_X86
+#endif
+
+namespace Util::Cpu
+{
+    namespace
+    {
+#ifdef CPU_FEATURES_X86
+        void CpuId(unsigned int leaf, unsigned int subleaf, unsigned int registers[4])
+        {
+#ifdef _MSC_VER
+            __cpuidex((int *)registers, (int)leaf, (int)subleaf);
+#else
+            __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+        }
+
+        unsigned long long ExtendedControlRegister()
+        {
+#ifdef _MSC_VER
+            return _xgetbv(0);
+#else
+            unsigned int low, high;
+            __asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+            return ((unsigned long long)high << 32) | low;
+#endif
+        }
+
+        Features Detect()
+        {
+            Features features;
+            unsigned int registers[4];
+
+            CpuId(0, 0, registers);
+            const unsigned int maxLeaf = registers[0];
+
+            if (maxLeaf < 1)
+            {
+                return features;
+            }
+
+            CpuId(1, 0, registers);
+            const unsigned int ecx = registers[2];
+            const unsigned int edx = registers[3];
+
+            features.Sse2 = (edx & (1u << 26)) != 0;
+            features.Ssse3 = (ecx & (1u << 9)) != 0;
+            features.Sse41 = (ecx & (1u << 19)) != 0;
+
+            // AVX needs the OS to save YMM registers on context switch, which OSXSAVE and XCR0 report.
+            const bool osxsave = (ecx & (1u << 27)) != 0;
+            const bool ymmSaved = osxsave && (ExtendedControlRegister() & 0x6) == 0x6;
+
+            features.Avx = ymmSaved && (ecx & (1u << 28)) != 0;
+            features.F16c = features.Avx && (ecx & (1u << 29)) != 0;
+
+            if (maxLeaf >= 7)
+            {
+                CpuId(7, 0, registers);
+                features.Avx2 = features.Avx && (registers[1] & (1u << 5)) != 0;
+            }
+
+            return features;
+        }
+#else
+        Features Detect()
+        {
+            return Features();
+        }
+#endif
+    }
+
+    const Features & Current()
+    {
+        static const Features features = Detect();
+        return features;
+    }
+}
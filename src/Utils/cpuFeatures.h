@@ -0,0 +1,20 @@
+#ifndef CPUFEATURES_H
+#define CPUFEATURES_H
+
+namespace Util::Cpu
+{
+    // Instruction sets usable by this process, AVX ones only when the OS also saves the YMM state.
+    struct Features
+    {
+        bool Sse2 = false;
+        bool Ssse3 = false;
+        bool Sse41 = false;
+        bool Avx = false;
+        bool Avx2 = false;
+        bool F16c = false;
+    };
+
+    // Queried once on first use.
+    const Features & Current();
+}
+#endif // !CPUFEATURES_H
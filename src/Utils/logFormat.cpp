@@ -0,0 +1,197 @@
+#include "logFormat.h"
+#include <stdio.h>
+#include <ctime>
+
+namespace Util::Logging
+{
+    std::atomic<uint32_t> LogFormat::nextId{ 0 };
+
+    const char BinaryLogMagic[4] = { 'B', 'L', 'O', 'G' };
+
+    void LogArgs::Put(LogArgType type, uint64_t value)
+    {
+        if (full || (size_t)(end - cursor) < 1 + sizeof(value))
+        {
+            full = true;
+            return;
+        }
+
+        *cursor++ = (uint8_t)type;
+        memcpy(cursor, &value, sizeof(value));
+        cursor += sizeof(value);
+    }
+
+    void LogArgs::PutString(const char * text, size_t length)
+    {
+        const size_t header = 1 + sizeof(uint16_t);
+
+        if (full || (size_t)(end - cursor) < header)
+        {
+            full = true;
+            return;
+        }
+
+        // Long strings are shortened to whatever room is left rather than dropped.
+        const size_t room = (end - cursor) - header;
+        const uint16_t stored = (uint16_t)(length < room ? length : room);
+
+        *cursor++ = (uint8_t)LogArgType::String;
+        memcpy(cursor, &stored, sizeof(stored));
+        cursor += sizeof(stored);
+        memcpy(cursor, text, stored);
+        cursor += stored;
+    }
+
+    namespace
+    {
+        // Renders the next argument, false once they run out or the rest was cut off.
+        bool RenderArg(const uint8_t *& cursor, const uint8_t * end, std::string & out)
+        {
+            if (cursor >= end)
+            {
+                return false;
+            }
+
+            const LogArgType type = (LogArgType)*cursor++;
+
+            if (type == LogArgType::String)
+            {
+                uint16_t length;
+
+                if ((size_t)(end - cursor) < sizeof(length))
+                {
+                    return false;
+                }
+
+                memcpy(&length, cursor, sizeof(length));
+                cursor += sizeof(length);
+
+                if ((size_t)(end - cursor) < length)
+                {
+                    return false;
+                }
+
+                out.append((const char *)cursor, length);
+                cursor += length;
+                return true;
+            }
+
+            uint64_t value;
+
+            if ((size_t)(end - cursor) < sizeof(value))
+            {
+                return false;
+            }
+
+            memcpy(&value, cursor, sizeof(value));
+            cursor += sizeof(value);
+
+            switch (type)
+            {
+            case LogArgType::Int:
+                out.append(std::to_string((int64_t)value));
+                return true;
+
+            case LogArgType::UInt:
+                out.append(std::to_string(value));
+                return true;
+
+            case LogArgType::Float:
+            {
+                double number;
+                memcpy(&number, &value, sizeof(number));
+
+                char text[32];
+                snprintf(text, sizeof(text), "%g", number);
+                out.append(text);
+                return true;
+            }
+
+            case LogArgType::Bool:
+                out.append(value != 0 ? "true" : "false");
+                return true;
+
+            default:
+                return false;
+            }
+        }
+    }
+
+    void RenderLogFormat(const char * format, const uint8_t * args, size_t length, std::string & out)
+    {
+        const uint8_t * cursor = args;
+        const uint8_t * end = args + length;
+
+        for (const char * c = format; *c != '\0'; c++)
+        {
+            if (c[0] == '{' && c[1] == '}')
+            {
+                if (!RenderArg(cursor, end, out))
+                {
+                    out.append("<truncated>");
+                    cursor = end;
+                }
+
+                c++;
+                continue;
+            }
+
+            out.push_back(*c);
+        }
+    }
+
+    namespace
+    {
+        const char * levelToString(LogLevel level)
+        {
+            switch (level)
+            {
+            case LogLevel::Trace:
+                return "Trace";
+
+            case LogLevel::Debug:
+                return "Debug";
+
+            case LogLevel::Info:
+                return "Info";
+
+            case LogLevel::Warning:
+                return "Warning";
+
+            case LogLevel::Error:
+                return "Error";
+
+            case LogLevel::Fatal:
+                return "Fatal";
+
+            default:
+                return "?";
+            }
+        }
+    }
+
+    void AppendLogLine(std::chrono::system_clock::time_point time, LogLevel level, const char * msg, size_t length, std::string & out)
+    {
+        const time_t rawtime = std::chrono::system_clock::to_time_t(time);
+        const auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(time.time_since_epoch()) % 1000;
+
+        // localtime shares one buffer between threads.
+        struct tm timeinfo;
+#ifdef _WIN32
+        localtime_s(&timeinfo, &rawtime);
+#else
+        localtime_r(&rawtime, &timeinfo);
+#endif
+
+        char stamp[32];
+        const size_t stampLength = strftime(stamp, sizeof(stamp), "%d-%m-%y %H:%M:%S", &timeinfo);
+        snprintf(stamp + stampLength, sizeof(stamp) - stampLength, ".%03d", (int)ms.count());
+
+        out.append(levelToString(level));
+        out.append(": ");
+        out.append(stamp);
+        out.append(": ");
+        out.append(msg, length);
+        out.push_back('\n');
+    }
+}
@@ -0,0 +1,139 @@
+#ifndef LOGFORMAT_H
+#define LOGFORMAT_H
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <type_traits>
+
+namespace Util::Logging
+{
+    enum class LogLevel
+    {
+        Trace = 6,
+        Debug = 5,
+        Info = 4,
+        Warning = 3,
+        Error = 2,
+        Fatal = 1
+    };
+
+    // A format string known at compile time, "{}" marks where each argument goes. Every call site
+    // owns one static instance, so the hot path only records its id and the raw argument bytes.
+    class LogFormat
+    {
+    public:
+        explicit LogFormat(const char * text) :
+            Id(nextId.fetch_add(1, std::memory_order_relaxed)),
+            Text(text)
+        {
+        }
+
+        const uint32_t Id;
+        const char * const Text;
+
+    private:
+        static std::atomic<uint32_t> nextId;
+    };
+
+    enum class LogArgType : uint8_t
+    {
+        Int,
+        UInt,
+        Float,
+        Bool,
+        String
+    };
+
+    // Argument encoding shared by the logger and the offline decoder: a type byte, then the value
+    // as 8 bytes, or a 16-bit length and the characters for strings. Arguments that don't fit are
+    // cut off and render as "<truncated>".
+    class LogArgs
+    {
+    public:
+        LogArgs(uint8_t * data, size_t capacity) :
+            cursor(data), end(data + capacity)
+        {
+        }
+
+        template <typename T>
+        void Add(const T & value)
+        {
+            if constexpr (std::is_same_v<T, bool>)
+            {
+                Put(LogArgType::Bool, (uint64_t)value);
+            }
+            else if constexpr (std::is_enum_v<T>)
+            {
+                Add((std::underlying_type_t<T>)value);
+            }
+            else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>)
+            {
+                Put(LogArgType::Int, (uint64_t)(int64_t)value);
+            }
+            else if constexpr (std::is_integral_v<T>)
+            {
+                Put(LogArgType::UInt, (uint64_t)value);
+            }
+            else if constexpr (std::is_floating_point_v<T>)
+            {
+                const double widened = value;
+                uint64_t bits;
+                memcpy(&bits, &widened, sizeof(bits));
+                Put(LogArgType::Float, bits);
+            }
+            else if constexpr (std::is_same_v<T, std::string>)
+            {
+                PutString(value.c_str(), value.length());
+            }
+            else
+            {
+                static_assert(std::is_convertible_v<T, const char *>, "unsupported log argument type");
+                const char * text = value;
+                PutString(text, strlen(text));
+            }
+        }
+
+        // Bytes written so far.
+        size_t Size(const uint8_t * data) const
+        {
+            return cursor - data;
+        }
+
+    private:
+        void Put(LogArgType type, uint64_t value);
+        void PutString(const char * text, size_t length);
+
+        uint8_t * cursor;
+        uint8_t * end;
+
+        // Once one argument is cut off the rest are too, so they can't shift into its place.
+        bool full = false;
+    };
+
+    // Substitutes the encoded arguments into format, appending to out.
+    void RenderLogFormat(const char * format, const uint8_t * args, size_t length, std::string & out);
+
+    // Appends one line of a text log, "Level: dd-mm-yy HH:MM:SS.mmm: msg".
+    void AppendLogLine(std::chrono::system_clock::time_point time, LogLevel level, const char * msg, size_t length, std::string & out);
+
+    // Binary log layout: BinaryLogMagic and BinaryLogVersion, then entries each starting with a
+    // BinaryLogEntry byte. A format is defined once before the first message using it:
+    //   Format:  uint32 id, uint16 length, characters
+    //   Message: int64 microseconds since the epoch, uint8 level, uint32 format id, uint16 length,
+    //            then the encoded arguments
+    //   Text:    int64 microseconds since the epoch, uint8 level, uint16 length, characters
+    // Appending to an existing log starts a new header, which also resets the format ids.
+    extern const char BinaryLogMagic[4];
+    const uint32_t BinaryLogVersion = 1;
+
+    enum class BinaryLogEntry : uint8_t
+    {
+        Format,
+        Message,
+        Text
+    };
+}
+#endif // !LOGFORMAT_H
@@ -1,12 +1,22 @@
 #include "logger.h"
 #include <iostream>
-#include <sstream>
-#include <ctime>
-#include <iomanip>
-#include <chrono>
+#include <string.h>
+#include <stdexcept>
 
 namespace Util::Logging
 {
+    namespace
+    {
+        // How long the writer sleeps when idle, which is also how long a message can sit queued.
+        const std::chrono::milliseconds WriterInterval(5);
+
+        template <typename T>
+        void Append(std::string & out, T value)
+        {
+            out.append((const char *)&value, sizeof(T));
+        }
+    }
+
     Logger::Logger(const char * filePath, LogLevel level, bool unbuffered)
     {
         this->unbuffered = unbuffered;
@@ -16,100 +26,269 @@ namespace Util::Logging
             throw new std::runtime_error("Can't open log for writing...");
         }
 
-        this->currentLogLevel = level;
+        for (auto & categoryLevel : this->levels)
+        {
+            categoryLevel.store(level, std::memory_order_relaxed);
+        }
+    }
+
+    Logger::Logger(const char * filePath, LogLevel level, Overflow overflow, LogEncoding encoding)
+    {
+        this->unbuffered = false;
+        this->logFile = fopen(filePath, encoding == LogEncoding::Binary ? "ab" : "a+");
+        if (logFile == nullptr)
+        {
+            throw new std::runtime_error("Can't open log for writing...");
+        }
+
+        if (encoding == LogEncoding::Binary)
+        {
+            fwrite(BinaryLogMagic, 1, sizeof(BinaryLogMagic), this->logFile);
+            fwrite(&BinaryLogVersion, sizeof(BinaryLogVersion), 1, this->logFile);
+        }
+
+        for (auto & categoryLevel : this->levels)
+        {
+            categoryLevel.store(level, std::memory_order_relaxed);
+        }
+        this->encoding = encoding;
+        this->overflow = overflow;
+        this->queue = std::make_unique<Util::Threading::MpscRing<Record, QueueCapacity>>();
+        this->running.store(true, std::memory_order_relaxed);
+        this->writer = std::thread(&Logger::WriterLoop, this);
     }
 
     Logger::~Logger()
     {
+        if (this->writer.joinable())
+        {
+            this->running.store(false, std::memory_order_release);
+            this->wake.notify_one();
+            this->writer.join();
+        }
+
         if (this->logFile != NULL)
         {
             fclose(this->logFile);
         }
     }
 
-    std::string levelToString(LogLevel level)
+    void Logger::Write(std::string msg, LogLevel level)
+    {
+        Write(msg.c_str(), msg.length(), level);
+    }
+
+    void Logger::Write(const char * msg, size_t length, LogLevel level)
+    {
+        if (!Enabled(LogCategory::General, level))
+        {
+            return;
+        }
+
+        const auto now = std::chrono::system_clock::now();
+
+        if (!this->queue)
+        {
+            std::string logMessage;
+            AppendLogLine(now, level, msg, length, logMessage);
+
+            if (fwrite(logMessage.c_str(), 1, logMessage.length(), this->logFile) != logMessage.length())
+            {
+                throw new std::runtime_error("failed to write log line...");
+            }
+
+            if (this->unbuffered)
+            {
+                fflush(this->logFile);
+            }
+
+            return;
+        }
+
+        Submit(level, [&](Record & record)
+        {
+            record.Time = now;
+            record.Level = level;
+            record.Format = nullptr;
+            record.Length = (uint16_t)(length < MaxMessageLength ? length : MaxMessageLength);
+            memcpy(record.Text, msg, record.Length);
+        });
+    }
+
+    void Logger::WriteNow(const Record & record)
+    {
+        std::string logMessage;
+        Emit(record, logMessage);
+
+        if (fwrite(logMessage.c_str(), 1, logMessage.length(), this->logFile) != logMessage.length())
+        {
+            throw new std::runtime_error("failed to write log line...");
+        }
+
+        if (this->unbuffered)
+        {
+            fflush(this->logFile);
+        }
+    }
+
+    bool Logger::WaitForSpace()
     {
-        switch (level)
+        if (this->overflow == Overflow::Drop)
         {
-        case LogLevel::Trace:
-            return "Trace";
+            this->dropped.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+
+        this->wake.notify_one();
+        std::this_thread::yield();
+        return true;
+    }
 
-        case LogLevel::Debug:
-            return "Debug";
+    void Logger::Emit(const Record & record, std::string & out)
+    {
+        if (this->encoding == LogEncoding::Text)
+        {
+            if (record.Format == nullptr)
+            {
+                AppendLogLine(record.Time, record.Level, record.Text, record.Length, out);
+                return;
+            }
 
-        case LogLevel::Info:
-            return "Info";
+            this->rendered.clear();
+            RenderLogFormat(record.Format->Text, (const uint8_t *)record.Text, record.Length, this->rendered);
+            AppendLogLine(record.Time, record.Level, this->rendered.c_str(), this->rendered.length(), out);
+            return;
+        }
 
-        case LogLevel::Warning:
-            return "Warning";
+        const int64_t micros = std::chrono::duration_cast<std::chrono::microseconds>(record.Time.time_since_epoch()).count();
 
-        case LogLevel::Error:
-            return "Error";
+        if (record.Format == nullptr)
+        {
+            Append(out, BinaryLogEntry::Text);
+            Append(out, micros);
+            Append(out, (uint8_t)record.Level);
+            Append(out, record.Length);
+            out.append(record.Text, record.Length);
+            return;
+        }
 
-        case LogLevel::Fatal:
-            return "Fatal";
+        const uint32_t id = record.Format->Id;
 
-        default:
-            throw new std::runtime_error("?");
+        if (id >= this->formatsWritten.size())
+        {
+            this->formatsWritten.resize(id + 1, false);
         }
+
+        if (!this->formatsWritten[id])
+        {
+            const uint16_t length = (uint16_t)strlen(record.Format->Text);
+            Append(out, BinaryLogEntry::Format);
+            Append(out, id);
+            Append(out, length);
+            out.append(record.Format->Text, length);
+            this->formatsWritten[id] = true;
+        }
+
+        Append(out, BinaryLogEntry::Message);
+        Append(out, micros);
+        Append(out, (uint8_t)record.Level);
+        Append(out, id);
+        Append(out, record.Length);
+        out.append(record.Text, record.Length);
     }
 
-    void Logger::Write(std::string msg, LogLevel level)
+    void Logger::WriterLoop()
     {
-        if (level <= this->currentLogLevel)
+        std::string batch;
+        Record record;
+        uint64_t reportedDrops = 0;
+
+        for (;;)
         {
-            std::ostringstream stream;
+            // Read before draining, so once it is false the drain below is the final one.
+            const bool stopping = !this->running.load(std::memory_order_acquire);
 
-            time_t rawtime;
-            struct tm * timeinfo;
-            auto now = std::chrono::system_clock::now();
+            batch.clear();
+            size_t count = 0;
 
-            auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(now.time_since_epoch()) % 1000;
+            while (count < QueueCapacity && this->queue->TryConsume([this, &batch](const Record & queued) { Emit(queued, batch); }))
+            {
+                count++;
+            }
 
-            time(&rawtime);
-            timeinfo = localtime(&rawtime);
+            const uint64_t drops = this->dropped.load(std::memory_order_relaxed);
 
-            stream << levelToString(level) << ": ";
-            stream << std::put_time(timeinfo, "%d-%m-%y %H:%M:%S");
-            stream << '.' << std::setfill('0') << std::setw(3) << ms.count() << ": " << msg << std::endl;
-            auto logMessage = stream.str();
-            if (fwrite(logMessage.c_str(), 1, logMessage.length(), this->logFile) != logMessage.length())
+            if (drops != reportedDrops)
             {
-                throw new std::runtime_error("failed to write log line...");
+                const std::string msg = std::to_string(drops - reportedDrops) + " log messages dropped, the queue was full";
+
+                record.Time = std::chrono::system_clock::now();
+                record.Level = LogLevel::Warning;
+                record.Format = nullptr;
+                record.Length = (uint16_t)msg.length();
+                memcpy(record.Text, msg.c_str(), msg.length());
+
+                Emit(record, batch);
+                reportedDrops = drops;
             }
 
-            if (this->unbuffered)
+            if (!batch.empty())
             {
+                // Nowhere to report a failed write from here, the next batch tries again.
+                fwrite(batch.c_str(), 1, batch.length(), this->logFile);
                 fflush(this->logFile);
+
+                if (count == QueueCapacity)
+                {
+                    continue;
+                }
+            }
+
+            if (stopping)
+            {
+                return;
             }
+
+            std::unique_lock<std::mutex> lock(this->wakeMutex);
+            this->wake.wait_for(lock, WriterInterval);
         }
     }
 
+    void Logger::SetLevel(LogCategory category, LogLevel level)
+    {
+        this->levels[(size_t)category].store(level, std::memory_order_relaxed);
+    }
+
+    uint64_t Logger::Dropped() const
+    {
+        return this->dropped.load(std::memory_order_relaxed);
+    }
+
     void Logger::Trace(const char * msg)
     {
-        Write(msg, LogLevel::Trace);
+        Write(msg, strlen(msg), LogLevel::Trace);
     }
 
     void Logger::Debug(const char * msg)
     {
-        Write(msg, LogLevel::Debug);
+        Write(msg, strlen(msg), LogLevel::Debug);
     }
 
     void Logger::Info(const char * msg)
     {
-        Write(msg, LogLevel::Info);
+        Write(msg, strlen(msg), LogLevel::Info);
     }
 
     void Logger::Warning(const char * msg)
     {
-        Write(msg, LogLevel::Warning);
+        Write(msg, strlen(msg), LogLevel::Warning);
     }
     void Logger::Error(const char * msg)
     {
-        Write(msg, LogLevel::Error);
+        Write(msg, strlen(msg), LogLevel::Error);
     }
     void Logger::Fatal(const char * msg)
     {
-        Write(msg, LogLevel::Fatal);
+        Write(msg, strlen(msg), LogLevel::Fatal);
     }
-}
\ No newline at end of file
+}
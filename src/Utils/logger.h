@@ -1,26 +1,71 @@
 #ifndef LOGGER_H
 #define LOGGER_H
+#include "mpscRing.h"
+#include "logFormat.h"
 #include <stdio.h>
+#include <stdint.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 #include <string>
+#include <thread>
+#include <vector>
 
 namespace Util::Logging
 {
-    enum class LogLevel
+    // What an asynchronous logger does when its queue is full.
+    enum class Overflow
     {
-        Trace = 6,
-        Debug = 5,
-        Info = 4,
-        Warning = 3,
-        Error = 2,
-        Fatal = 1
+        Drop,
+        Block
+    };
+
+    // Subsystems whose runtime levels can be set separately.
+    enum class LogCategory
+    {
+        General,
+        Vulkan,
+        Input,
+        Assets,
+        Count
+    };
+
+    // Calls through the LOG_ macros more verbose than this are compiled out, arguments and all. Defaults
+    // to Info in release builds and Trace otherwise, define LOG_COMPILED_LEVEL to override.
+#ifndef LOG_COMPILED_LEVEL
+#ifdef NDEBUG
+#define LOG_COMPILED_LEVEL 4
+#else
+#define LOG_COMPILED_LEVEL 6
+#endif
+#endif
+    constexpr LogLevel CompiledLogLevel = (LogLevel)LOG_COMPILED_LEVEL;
+
+    // How an asynchronous logger stores its file. Binary logs keep structured messages as format
+    // ids and raw arguments and are turned into text offline by logdecode.
+    enum class LogEncoding
+    {
+        Text,
+        Binary
     };
 
     class Logger
     {
     public:
+        // Formats and writes on the calling thread.
         Logger(const char * filePath, LogLevel level, bool unbuffered);
+
+        // Callers only copy the message into a lock-free queue, a background thread formats and
+        // writes them in batches. Messages longer than MaxMessageLength are truncated.
+        Logger(const char * filePath, LogLevel level, Overflow overflow, LogEncoding encoding = LogEncoding::Text);
+
         ~Logger();
 
+        Logger(const Logger &) = delete;
+        Logger & operator=(const Logger &) = delete;
+
         void Trace(const char * msg);
         void Debug(const char * msg);
         void Info(const char * msg);
@@ -28,11 +73,135 @@ namespace Util::Logging
         void Error(const char * msg);
         void Fatal(const char * msg);
         void Write(std::string msg, LogLevel level);
+        void Write(const char * msg, size_t length, LogLevel level);
+
+        // Every category starts at the level given to the constructor. Plain text messages use
+        // General.
+        void SetLevel(LogCategory category, LogLevel level);
+
+        bool Enabled(LogCategory category, LogLevel level) const
+        {
+            return level <= this->levels[(size_t)category].load(std::memory_order_relaxed);
+        }
+
+        // Records format's id and the raw argument bytes, the text is put together later by the
+        // writer thread or, for binary logs, by the decoder. Use the LOG_ macros rather than
+        // calling this directly, they keep one static format per call site.
+        template <typename... Args>
+        void Structured(LogCategory category, LogLevel level, const LogFormat & format, const Args &... args)
+        {
+            if (!Enabled(category, level))
+            {
+                return;
+            }
+
+            const auto now = std::chrono::system_clock::now();
+
+            Submit(level, [&](Record & record)
+            {
+                record.Time = now;
+                record.Level = level;
+                record.Format = &format;
+
+                LogArgs encoded((uint8_t *)record.Text, MaxMessageLength);
+                (encoded.Add(args), ...);
+                record.Length = (uint16_t)encoded.Size((const uint8_t *)record.Text);
+            });
+        }
+
+        // Messages lost to a full queue with Overflow::Drop.
+        uint64_t Dropped() const;
+
+        static const size_t MaxMessageLength = 500;
 
     private:
+        static const size_t QueueCapacity = 1024;
+
+        struct Record
+        {
+            std::chrono::system_clock::time_point Time;
+            LogLevel Level;
+
+            // Null for plain text, otherwise Text holds the encoded arguments.
+            const LogFormat * Format;
+
+            uint16_t Length;
+            char Text[MaxMessageLength];
+        };
+
+        // Async loggers fill the record in its queue slot, only the bytes written there are touched.
+        template <typename Fill>
+        void Submit(LogLevel level, const Fill & fill)
+        {
+            if (!this->queue)
+            {
+                Record record;
+                fill(record);
+                WriteNow(record);
+                return;
+            }
+
+            while (!this->queue->TryEmplace(fill))
+            {
+                if (!WaitForSpace())
+                {
+                    return;
+                }
+            }
+
+            // Errors go out straight away, everything else waits for the writer's next round.
+            if (level <= LogLevel::Error)
+            {
+                this->wake.notify_one();
+            }
+        }
+
+        void WriteNow(const Record & record);
+        bool WaitForSpace();
+        void Emit(const Record & record, std::string & out);
+        void WriterLoop();
+
         bool unbuffered;
         FILE * logFile;
-        LogLevel currentLogLevel;
+        std::atomic<LogLevel> levels[(size_t)LogCategory::Count];
+
+        Overflow overflow = Overflow::Drop;
+        LogEncoding encoding = LogEncoding::Text;
+
+        // Only touched by whichever thread emits, the writer in async mode.
+        std::vector<bool> formatsWritten;
+        std::string rendered;
+
+        std::unique_ptr<Util::Threading::MpscRing<Record, QueueCapacity>> queue;
+        std::atomic<uint64_t> dropped{ 0 };
+
+        std::thread writer;
+        std::atomic<bool> running{ false };
+        std::mutex wakeMutex;
+        std::condition_variable wake;
     };
 }
-#endif
\ No newline at end of file
+
+// Logs through a static LogFormat owned by this call site, see Logger::Structured. category is a
+// LogCategory name and level must be a constant. Past CompiledLogLevel nothing is compiled, and
+// when the category is turned down at runtime the arguments aren't evaluated.
+#define LOG_AT(logger, category, level, format, ...) \
+    do \
+    { \
+        if constexpr ((level) <= Util::Logging::CompiledLogLevel) \
+        { \
+            if ((logger).Enabled(Util::Logging::LogCategory::category, (level))) \
+            { \
+                static const Util::Logging::LogFormat logFormat(format); \
+                (logger).Structured(Util::Logging::LogCategory::category, (level), logFormat, ##__VA_ARGS__); \
+            } \
+        } \
+    } while (0)
+
+#define LOG_TRACE(logger, category, format, ...) LOG_AT(logger, category, Util::Logging::LogLevel::Trace, format, ##__VA_ARGS__)
+#define LOG_DEBUG(logger, category, format, ...) LOG_AT(logger, category, Util::Logging::LogLevel::Debug, format, ##__VA_ARGS__)
+#define LOG_INFO(logger, category, format, ...) LOG_AT(logger, category, Util::Logging::LogLevel::Info, format, ##__VA_ARGS__)
+#define LOG_WARNING(logger, category, format, ...) LOG_AT(logger, category, Util::Logging::LogLevel::Warning, format, ##__VA_ARGS__)
+#define LOG_ERROR(logger, category, format, ...) LOG_AT(logger, category, Util::Logging::LogLevel::Error, format, ##__VA_ARGS__)
+
+#endif
@@ -0,0 +1,129 @@
+#include "mappedFile.h"
+#include <stdexcept>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Util::IO
+{
+#ifdef _WIN32
+    MappedFile::MappedFile(const std::string & path)
+    {
+        file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+
+        if (file == INVALID_HANDLE_VALUE)
+        {
+            file = nullptr;
+            throw std::runtime_error("Could not open " + path);
+        }
+
+        LARGE_INTEGER fileSize;
+        GetFileSizeEx(file, &fileSize);
+        size = (size_t)fileSize.QuadPart;
+
+        // Empty files can't be mapped, Data() just stays null.
+        if (size == 0)
+        {
+            return;
+        }
+
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+        if (mapping != nullptr)
+        {
+            data = (const uint8_t *)MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        }
+
+        if (data == nullptr)
+        {
+            if (mapping != nullptr)
+            {
+                CloseHandle(mapping);
+            }
+
+            CloseHandle(file);
+            throw std::runtime_error("Could not map " + path);
+        }
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (data != nullptr)
+        {
+            UnmapViewOfFile(data);
+        }
+
+        if (mapping != nullptr)
+        {
+            CloseHandle(mapping);
+        }
+
+        if (file != nullptr)
+        {
+            CloseHandle(file);
+        }
+    }
+#else
+    MappedFile::MappedFile(const std::string & path)
+    {
+        file = open(path.c_str(), O_RDONLY);
+
+        if (file < 0)
+        {
+            throw std::runtime_error("Could not open " + path);
+        }
+
+        struct stat info;
+        fstat(file, &info);
+        size = (size_t)info.st_size;
+
+        if (size == 0)
+        {
+            return;
+        }
+
+        void * view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+
+        if (view == MAP_FAILED)
+        {
+            close(file);
+            throw std::runtime_error("Could not map " + path);
+        }
+
+        madvise(view, size, MADV_SEQUENTIAL);
+        data = (const uint8_t *)view;
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (data != nullptr)
+        {
+            munmap((void *)data, size);
+        }
+
+        if (file >= 0)
+        {
+            close(file);
+        }
+    }
+#endif
+
+    const uint8_t * MappedFile::Data() const
+    {
+        return data;
+    }
+
+    size_t MappedFile::Size() const
+    {
+        return size;
+    }
+}
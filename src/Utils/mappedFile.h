@@ -0,0 +1,35 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+namespace Util::IO
+{
+    // Read-only view of a whole file. Pages are faulted in by the OS as they are touched,
+    // so nothing is copied into process memory up front.
+    class MappedFile
+    {
+    public:
+        explicit MappedFile(const std::string & path);
+        ~MappedFile();
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile & operator=(const MappedFile &) = delete;
+
+        const uint8_t * Data() const;
+        size_t Size() const;
+
+    private:
+        const uint8_t * data = nullptr;
+        size_t size = 0;
+
+#ifdef _WIN32
+        void * file = nullptr;
+        void * mapping = nullptr;
+#else
+        int file = -1;
+#endif
+    };
+}
+#endif // !MAPPEDFILE_H
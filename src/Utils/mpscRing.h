@@ -0,0 +1,108 @@
+#ifndef MPSCRING_H
+#define MPSCRING_H
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <utility>
+
+namespace Util::Threading
+{
+    // Bounded queue any number of threads can push into without locks while one thread pops.
+    // Each slot carries a sequence number telling producers when it is free and the consumer when
+    // it has been written, so neither side ever waits on the other. Pushing into a full ring fails.
+    template <typename T, size_t Capacity>
+    class MpscRing
+    {
+        static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+    public:
+        MpscRing()
+        {
+            for (size_t i = 0; i < Capacity; i++)
+            {
+                slots[i].Sequence.store(i, std::memory_order_relaxed);
+            }
+        }
+
+        MpscRing(const MpscRing &) = delete;
+        MpscRing & operator=(const MpscRing &) = delete;
+
+        // Safe from any thread. Copies or moves value straight into its slot.
+        template <typename U>
+        bool TryPush(U && value)
+        {
+            return TryEmplace([&value](T & slot) { slot = std::forward<U>(value); });
+        }
+
+        // Like TryPush, but fill writes the value in the claimed slot itself, so a large T that is
+        // only partly used is never copied whole. fill must not throw, the slot is already claimed.
+        template <typename Fill>
+        bool TryEmplace(const Fill & fill)
+        {
+            size_t position = tail.load(std::memory_order_relaxed);
+
+            for (;;)
+            {
+                Slot & slot = slots[position & (Capacity - 1)];
+                const size_t sequence = slot.Sequence.load(std::memory_order_acquire);
+                const intptr_t difference = (intptr_t)sequence - (intptr_t)position;
+
+                if (difference == 0)
+                {
+                    // Claim the slot; on failure position holds the new tail and we go round again.
+                    if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                    {
+                        fill(slot.Value);
+                        slot.Sequence.store(position + 1, std::memory_order_release);
+                        return true;
+                    }
+                }
+                else if (difference < 0)
+                {
+                    // The consumer hasn't freed this slot from the previous lap yet.
+                    return false;
+                }
+                else
+                {
+                    position = tail.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        // Consumer thread only. Also fails while the producer that claimed the next slot is still writing it.
+        bool TryPop(T & value)
+        {
+            return TryConsume([&value](T & slot) { value = std::move(slot); });
+        }
+
+        // Consumer thread only. Hands the value to consume where it lies, the slot is reused once it returns.
+        template <typename Consume>
+        bool TryConsume(const Consume & consume)
+        {
+            Slot & slot = slots[head & (Capacity - 1)];
+
+            if (slot.Sequence.load(std::memory_order_acquire) != head + 1)
+            {
+                return false;
+            }
+
+            consume(slot.Value);
+            slot.Sequence.store(head + Capacity, std::memory_order_release);
+            head++;
+            return true;
+        }
+
+    private:
+        struct Slot
+        {
+            std::atomic<size_t> Sequence;
+            T Value;
+        };
+
+        // Producers and the consumer each get their own cache line.
+        alignas(64) std::atomic<size_t> tail{ 0 };
+        alignas(64) size_t head = 0;
+        alignas(64) Slot slots[Capacity];
+    };
+}
+#endif // !MPSCRING_H
@@ -0,0 +1,183 @@
+#include "profiler.h"
+#include <stdio.h>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <vector>
+
+namespace Util::Profiling
+{
+    namespace
+    {
+        // Past this a thread stops recording rather than growing without bound.
+        const size_t MaxZonesPerThread = 1 << 20;
+
+        struct Zone
+        {
+            const char * Name;
+            uint64_t Start;
+            uint64_t End;
+        };
+
+        struct CounterSample
+        {
+            const char * Name;
+            uint64_t Time;
+            double Value;
+        };
+
+        struct ThreadBuffer
+        {
+            // Only contended while a trace is being written or cleared.
+            std::mutex Mutex;
+            std::vector<Zone> Zones;
+            std::vector<CounterSample> Counters;
+            std::string Name;
+            uint32_t Id;
+        };
+
+        const auto epoch = std::chrono::steady_clock::now();
+
+        // Buffers outlive their threads so zones from finished workers still get written.
+        std::mutex buffersMutex;
+        std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+
+        thread_local ThreadBuffer * localBuffer = nullptr;
+
+        ThreadBuffer & LocalBuffer()
+        {
+            if (localBuffer == nullptr)
+            {
+                std::lock_guard<std::mutex> lock(buffersMutex);
+                buffers.push_back(std::make_unique<ThreadBuffer>());
+                localBuffer = buffers.back().get();
+                localBuffer->Id = (uint32_t)buffers.size();
+                localBuffer->Name = "Thread " + std::to_string(localBuffer->Id);
+            }
+
+            return *localBuffer;
+        }
+
+        void WriteEscaped(FILE * file, const char * text)
+        {
+            for (; *text != '\0'; text++)
+            {
+                if (*text == '"' || *text == '\\')
+                {
+                    fputc('\\', file);
+                }
+
+                fputc(*text, file);
+            }
+        }
+    }
+
+    std::atomic<bool> Profiler::enabled{ false };
+
+    void Profiler::Start()
+    {
+        {
+            std::lock_guard<std::mutex> lock(buffersMutex);
+
+            for (auto & buffer : buffers)
+            {
+                std::lock_guard<std::mutex> bufferLock(buffer->Mutex);
+                buffer->Zones.clear();
+                buffer->Counters.clear();
+            }
+        }
+
+        enabled.store(true, std::memory_order_relaxed);
+    }
+
+    void Profiler::Stop()
+    {
+        enabled.store(false, std::memory_order_relaxed);
+    }
+
+    void Profiler::SetThreadName(const std::string & name)
+    {
+        ThreadBuffer & buffer = LocalBuffer();
+        std::lock_guard<std::mutex> lock(buffer.Mutex);
+        buffer.Name = name;
+    }
+
+    void Profiler::Record(const char * name, uint64_t start, uint64_t end)
+    {
+        ThreadBuffer & buffer = LocalBuffer();
+        std::lock_guard<std::mutex> lock(buffer.Mutex);
+
+        if (buffer.Zones.size() < MaxZonesPerThread)
+        {
+            buffer.Zones.push_back({ name, start, end });
+        }
+    }
+
+    void Profiler::Counter(const char * name, double value)
+    {
+        if (!Enabled())
+        {
+            return;
+        }
+
+        const uint64_t now = Now();
+        ThreadBuffer & buffer = LocalBuffer();
+        std::lock_guard<std::mutex> lock(buffer.Mutex);
+
+        if (buffer.Counters.size() < MaxZonesPerThread)
+        {
+            buffer.Counters.push_back({ name, now, value });
+        }
+    }
+
+    uint64_t Profiler::Now()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - epoch).count();
+    }
+
+    void Profiler::WriteChromeTrace(const std::string & path)
+    {
+        FILE * file = fopen(path.c_str(), "w");
+
+        if (file == nullptr)
+        {
+            throw std::runtime_error("Could not open " + path + " for the profile");
+        }
+
+        fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", file);
+        bool first = true;
+
+        std::lock_guard<std::mutex> lock(buffersMutex);
+
+        for (auto & buffer : buffers)
+        {
+            std::lock_guard<std::mutex> bufferLock(buffer->Mutex);
+
+            fprintf(file, "%s\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%u,\"args\":{\"name\":\"", first ? "" : ",", buffer->Id);
+            WriteEscaped(file, buffer->Name.c_str());
+            fputs("\"}}", file);
+            first = false;
+
+            // Chrome trace timestamps are in microseconds.
+            for (const Zone & zone : buffer->Zones)
+            {
+                fputs(",\n{\"name\":\"", file);
+                WriteEscaped(file, zone.Name);
+                fprintf(file, "\",\"ph\":\"X\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+                    buffer->Id, zone.Start / 1000.0, (zone.End - zone.Start) / 1000.0);
+            }
+
+            for (const CounterSample & counter : buffer->Counters)
+            {
+                fputs(",\n{\"name\":\"", file);
+                WriteEscaped(file, counter.Name);
+                fprintf(file, "\",\"ph\":\"C\",\"pid\":1,\"tid\":%u,\"ts\":%.3f,\"args\":{\"value\":%.6g}}",
+                    buffer->Id, counter.Time / 1000.0, counter.Value);
+            }
+        }
+
+        fputs("\n]}\n", file);
+        fclose(file);
+    }
+}
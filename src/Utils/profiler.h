@@ -0,0 +1,76 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+#include <stdint.h>
+#include <atomic>
+#include <string>
+
+namespace Util::Profiling
+{
+    // Records named CPU zones per thread while started and writes them out as a Chrome trace, which
+    // chrome://tracing and ui.perfetto.dev both open. Nesting comes from the timestamps, so zones
+    // on one thread only need to be properly scoped. A zone costs two clock reads and an append to
+    // the thread's own buffer, and a single relaxed load while the profiler is stopped.
+    class Profiler
+    {
+    public:
+        // Clears anything recorded before.
+        static void Start();
+        static void Stop();
+
+        static bool Enabled()
+        {
+            return enabled.load(std::memory_order_relaxed);
+        }
+
+        // Labels the calling thread in the trace.
+        static void SetThreadName(const std::string & name);
+
+        // name must outlive the profiler, in practice a string literal.
+        static void Record(const char * name, uint64_t start, uint64_t end);
+
+        // A value plotted over time next to the zones, e.g. GPU times read back a few frames late.
+        // Same lifetime rule for name as Record.
+        static void Counter(const char * name, double value);
+
+        // Nanoseconds on the steady clock since the program started.
+        static uint64_t Now();
+
+        static void WriteChromeTrace(const std::string & path);
+
+    private:
+        static std::atomic<bool> enabled;
+    };
+
+    class ProfileZone
+    {
+    public:
+        explicit ProfileZone(const char * name) :
+            name(name), active(Profiler::Enabled()), start(active ? Profiler::Now() : 0)
+        {
+        }
+
+        ~ProfileZone()
+        {
+            if (active)
+            {
+                Profiler::Record(name, start, Profiler::Now());
+            }
+        }
+
+        ProfileZone(const ProfileZone &) = delete;
+        ProfileZone & operator=(const ProfileZone &) = delete;
+
+    private:
+        const char * name;
+        bool active;
+        uint64_t start;
+    };
+}
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+
+// Times the rest of the enclosing scope.
+#define PROFILE_ZONE(name) Util::Profiling::ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+
+#endif // !PROFILER_H
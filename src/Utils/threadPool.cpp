@@ -0,0 +1,176 @@
+#include "threadPool.h"
+#include "profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+namespace Util::Threading
+{
+    ThreadPool * ThreadPool::instance = nullptr;
+
+    ThreadPool::ThreadPool(size_t threadCount)
+    {
+        for (size_t i = 0; i < threadCount; i++)
+        {
+            workers.emplace_back([this, i]()
+            {
+                Util::Profiling::Profiler::SetThreadName("Worker " + std::to_string(i));
+                workerLoop();
+            });
+        }
+    }
+
+    ThreadPool::~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+
+        wakeUp.notify_all();
+
+        for (auto & worker : workers)
+        {
+            worker.join();
+        }
+    }
+
+    size_t ThreadPool::ThreadCount() const
+    {
+        return workers.size();
+    }
+
+    std::future<void> ThreadPool::Submit(std::function<void()> task)
+    {
+        std::packaged_task<void()> packaged(std::move(task));
+        auto future = packaged.get_future();
+
+        if (workers.empty())
+        {
+            packaged();
+            return future;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            tasks.push_back(std::move(packaged));
+        }
+
+        wakeUp.notify_one();
+        return future;
+    }
+
+    void ThreadPool::workerLoop()
+    {
+        while (true)
+        {
+            std::packaged_task<void()> task;
+
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                wakeUp.wait(lock, [this]() { return stopping || !tasks.empty(); });
+
+                if (stopping && tasks.empty())
+                {
+                    return;
+                }
+
+                task = std::move(tasks.front());
+                tasks.pop_front();
+            }
+
+            task();
+        }
+    }
+
+    namespace
+    {
+        struct ParallelForState
+        {
+            std::function<void(size_t, size_t)> body;
+            size_t count;
+            size_t grain;
+            size_t chunks;
+
+            std::atomic<size_t> next{ 0 };
+            std::atomic<size_t> finished{ 0 };
+
+            std::mutex mutex;
+            std::condition_variable done;
+            std::exception_ptr error;
+
+            void Run()
+            {
+                size_t chunk;
+
+                while ((chunk = next.fetch_add(1)) < chunks)
+                {
+                    const size_t begin = chunk * grain;
+
+                    try
+                    {
+                        body(begin, std::min(count, begin + grain));
+                    }
+                    catch (...)
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        if (!error)
+                        {
+                            error = std::current_exception();
+                        }
+                    }
+
+                    if (finished.fetch_add(1) + 1 == chunks)
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        done.notify_all();
+                    }
+                }
+            }
+        };
+    }
+
+    void ThreadPool::ParallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)> & body)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+
+        grain = std::max<size_t>(grain, 1);
+
+        const size_t chunks = (count + grain - 1) / grain;
+
+        if (chunks == 1 || workers.empty())
+        {
+            body(0, count);
+            return;
+        }
+
+        // Helpers that start after the work ran out return straight away, the shared state keeps
+        // them valid after this call has returned.
+        auto state = std::make_shared<ParallelForState>();
+        state->body = body;
+        state->count = count;
+        state->grain = grain;
+        state->chunks = chunks;
+
+        const size_t helpers = std::min(workers.size(), chunks - 1);
+
+        for (size_t i = 0; i < helpers; i++)
+        {
+            Submit([state]() { state->Run(); });
+        }
+
+        state->Run();
+
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->done.wait(lock, [&state]() { return state->finished.load() == state->chunks; });
+
+        if (state->error)
+        {
+            std::rethrow_exception(state->error);
+        }
+    }
+}
@@ -0,0 +1,51 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace Util::Threading
+{
+    class ThreadPool
+    {
+    public:
+        static ThreadPool * GetInstance()
+        {
+            if (instance == nullptr)
+            {
+                // The thread asking for work takes part in ParallelFor, so leave it a core.
+                const unsigned int cores = std::thread::hardware_concurrency();
+                instance = new ThreadPool(cores > 1 ? cores - 1 : 0);
+            }
+            return instance;
+        }
+
+        explicit ThreadPool(size_t threadCount);
+        ~ThreadPool();
+
+        std::future<void> Submit(std::function<void()> task);
+
+        // Runs body over [0, count) in chunks of at most grain items. The calling thread takes chunks
+        // too, so this is safe to call from inside a task and makes progress with zero workers.
+        // The first exception thrown by body is rethrown here once every chunk has finished.
+        void ParallelFor(size_t count, size_t grain, const std::function<void(size_t begin, size_t end)> & body);
+
+        size_t ThreadCount() const;
+
+    private:
+        void workerLoop();
+
+        static ThreadPool * instance;
+
+        std::vector<std::thread> workers;
+        std::deque<std::packaged_task<void()>> tasks;
+        std::mutex mutex;
+        std::condition_variable wakeUp;
+        bool stopping = false;
+    };
+}
+#endif // !THREADPOOL_H
@@ -1,6 +1,9 @@
 #include "app.h"
 #include "Input/keyboard.h"
 #include "Input/mouse.h"
+#include "Input/inputState.h"
+#include "Input/inputRecorder.h"
+#include "Utils/profiler.h"
 #include <filesystem>
 #include <fstream>
 #include <unordered_map>
@@ -18,6 +21,12 @@ namespace fs = std::filesystem;
 
 uint32_t App::Run()
 {
+    if (!profilePath.empty())
+    {
+        Util::Profiling::Profiler::SetThreadName("Main");
+        Util::Profiling::Profiler::Start();
+    }
+
     init();
     loop();
     cleanup();
@@ -30,11 +39,39 @@ App::App(const uint32_t width, const uint32_t height, const char * title, const
     this->width = width; this->height = height; this->title = title; this->shaderDir = shaderDir;
 }
 
+void App::RecordInput(const std::string & path)
+{
+    this->recordPath = path;
+}
+
+void App::ReplayInput(const std::string & path)
+{
+    this->replayPath = path;
+}
+
+void App::Profile(const std::string & path)
+{
+    this->profilePath = path;
+}
+
 void App::init()
 {
+    PROFILE_ZONE("Init");
+
     glfwInit();
     glfwWindowHint(GLFW_CLIENT_API, GLFW_NO_API);
 
+    if (!replayPath.empty())
+    {
+        // Replays are benchmark runs, nobody needs to see the window.
+        glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+        Input::InputRecorder::StartReplay(replayPath);
+    }
+    else if (!recordPath.empty())
+    {
+        Input::InputRecorder::StartRecording(recordPath);
+    }
+
     auto monitor = glfwGetPrimaryMonitor();
 
     auto mode = glfwGetVideoMode(monitor);
@@ -167,22 +204,32 @@ void App::init()
     graphicsBackend->EndInit();
     graphicsBackend->LoadModel(vertices, indices);
 
-    glfwSetKeyCallback(this->window, Input::Keyboard::HandleKey);
-    glfwSetCursorPosCallback(this->window, Input::Mouse::HandleMouseMove);
-    glfwSetMouseButtonCallback(this->window, Input::Mouse::HandleMouseClick);
+    Input::InputRecorder::InstallCallbacks(this->window);
+
+    Input::Mouse::CaptureCursor(this->window);
 }
 
 void App::loop()
 {
     while (!glfwWindowShouldClose(window))
     {
-        glfwPollEvents();
+        PROFILE_ZONE("Frame");
+
+        {
+            PROFILE_ZONE("Input");
+            Input::InputState::Update(Input::InputRecorder::PollEvents(window));
+            Input::Mouse::EndFrame();
+            Events::EventPump::DispatchEvents();
+        }
+
         graphicsBackend->DrawFrame();
     }
 }
 
 void App::cleanup()
 {
+    Input::InputRecorder::Stop();
+
     glfwDestroyWindow(window);
 
     glfwTerminate();
@@ -190,4 +237,10 @@ void App::cleanup()
     graphicsBackend->Cleanup();
 
     delete graphicsBackend;
+
+    if (!profilePath.empty())
+    {
+        Util::Profiling::Profiler::Stop();
+        Util::Profiling::Profiler::WriteChromeTrace(profilePath);
+    }
 }
\ No newline at end of file
@@ -12,12 +12,22 @@ public:
     uint32_t Run();
     App(uint32_t width, uint32_t height, const char * title, const char * shaderDir);
 
+    // Both take effect on Run, replaying wins if both are set.
+    void RecordInput(const std::string & path);
+    void ReplayInput(const std::string & path);
+
+    // Writes a Chrome trace of the whole run to path on exit.
+    void Profile(const std::string & path);
+
 private:
 
     uint32_t width;
     uint32_t height;
     std::string title;
     std::string shaderDir;
+    std::string recordPath;
+    std::string replayPath;
+    std::string profilePath;
     GLFWwindow * window;
 
     Graphics::GraphicsBackend * graphicsBackend;
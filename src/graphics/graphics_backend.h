@@ -5,6 +5,7 @@
 #include <vector>
 #include "shader.h"
 #include "vertex.h"
+#include "textureAtlas.h"
 #include "../events/iEventHandler.h"
 #include "../events/eventsPump.h"
 
@@ -12,7 +13,11 @@ namespace Graphics
 {
     typedef std::vector<std::tuple<std::string, ShaderType, std::vector<char>>> ShaderList;
 
-    class GraphicsBackend : public Events::IEventHandler
+    class GraphicsBackend :
+        public Events::IEventHandler<Events::KeyPressEvent>,
+        public Events::IEventHandler<Events::KeyReleaseEvent>,
+        public Events::IEventHandler<Events::KeyHoldEvent>,
+        public Events::IEventHandler<Events::MouseMoveEvent>
     {
     public:
         virtual void BeginInit(const std::string & title) = 0;
@@ -23,9 +28,15 @@ namespace Graphics
         virtual void LoadModel(const std::vector<Vertex> & modelData, const std::vector<uint32_t> & indices) = 0;
         virtual void LoadTexture(const std::string & path) = 0;
 
+        // Packs small images into one texture and binds it, the regions remap each image's UVs.
+        virtual std::vector<AtlasRegion> LoadAtlas(const std::vector<std::string> & paths) = 0;
+
         GraphicsBackend()
         {
-            Events::EventPump::RegisterHandler(this);
+            Events::EventPump::Subscribe<Events::KeyPressEvent>(this);
+            Events::EventPump::Subscribe<Events::KeyReleaseEvent>(this);
+            Events::EventPump::Subscribe<Events::KeyHoldEvent>(this);
+            Events::EventPump::Subscribe<Events::MouseMoveEvent>(this);
         }
     };
 }
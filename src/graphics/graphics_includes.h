@@ -5,6 +5,7 @@
 #define VK_USE_PLATFORM_WIN32_KHR
 #define GLFW_EXPOSE_NATIVE_WIN32
 #define GLFW_EXPOSE_NATIVE_WGL
+#define NOMINMAX
 #include <GLFW/glfw3.h>
 #include <GLFW/glfw3native.h>
 
@@ -1,7 +1,57 @@
 #include <iostream>
+#include <string.h>
+#include <string>
+#include <vector>
 #include "app.h"
 #if defined(_WIN64)
 #include <Windows.h>
+#include <shellapi.h>
+#endif
+
+static void ParseArguments(App & app, const std::vector<std::string> & args)
+{
+    for (size_t i = 1; i + 1 < args.size(); i++)
+    {
+        if (args[i] == "--record-input")
+        {
+            app.RecordInput(args[++i]);
+        }
+        else if (args[i] == "--replay-input")
+        {
+            app.ReplayInput(args[++i]);
+        }
+        else if (args[i] == "--profile")
+        {
+            app.Profile(args[++i]);
+        }
+    }
+}
+
+#if defined(_WIN64)
+// Same layout as argv, the program name first and every argument in UTF-8.
+static std::vector<std::string> CommandLineArguments()
+{
+    std::vector<std::string> args;
+    int argc = 0;
+    LPWSTR * argv = CommandLineToArgvW(GetCommandLineW(), &argc);
+
+    if (!argv)
+    {
+        return args;
+    }
+
+    for (int i = 0; i < argc; i++)
+    {
+        int size = WideCharToMultiByte(CP_UTF8, 0, argv[i], -1, nullptr, 0, nullptr, nullptr);
+        std::string arg(size > 0 ? size : 1, '\0');
+        WideCharToMultiByte(CP_UTF8, 0, argv[i], -1, &arg[0], size, nullptr, nullptr);
+        arg.resize(arg.size() - 1);
+        args.push_back(arg);
+    }
+
+    LocalFree(argv);
+    return args;
+}
 
 INT wWinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, PWSTR lpCmdLine, INT nCmdShow)
 #else
@@ -11,5 +61,11 @@ int main(int argc, char* argv[])
 {
     App app(1920, 1080, "My app", "Shaders");
 
+#if defined(_WIN64)
+    ParseArguments(app, CommandLineArguments());
+#else
+    ParseArguments(app, std::vector<std::string>(argv, argv + argc));
+#endif
+
     return app.Run();
 }
\ No newline at end of file
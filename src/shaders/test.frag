@@ -6,7 +6,26 @@ layout(location = 1) in vec2 texcoord;
 layout(location = 0) out vec4 outColor;
 layout(binding = 1) uniform sampler2D texSampler;
 
+layout(constant_id = 0) const bool WriteFeedback = false;
+
+// Finest mip of the bound image sampled this frame, relative to its first resident level.
+layout(std430, binding = 2) buffer Feedback
+{
+    int minLod;
+} feedback;
+
 void main()
 {
     outColor = outColor = texture(texSampler, texcoord);
+
+    // One fragment in 64 is enough to find the finest level and keeps the atomics on one address rare.
+    if (WriteFeedback && ((int(gl_FragCoord.x) | int(gl_FragCoord.y)) & 7) == 0)
+    {
+        int lod = int(floor(textureQueryLod(texSampler, texcoord).y));
+
+        if (lod < feedback.minLod)
+        {
+            atomicMin(feedback.minLod, lod);
+        }
+    }
 }
\ No newline at end of file